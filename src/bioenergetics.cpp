@@ -0,0 +1,150 @@
+#include "bioenergetics.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "model_config_map.h"
+
+TemperatureFactors exactTemperatureFactors(const float temp) {
+    // TODO: Should fish die if temp > CTM? Otherwise have to cap temp
+    const float V = (CTM - temp)/(CTM - CTO);
+    return {pow(V, CONS_X) * exp(CONS_X * (1 - V)), exp(RQ * temp), pow(temp, FB), pow(temp, UB)};
+}
+
+namespace {
+// Temperature factors sampled every TEMPERATURE_TABLE_STEP degrees from TEMPERATURE_TABLE_MIN up to CTM
+// (the cap applied by Fish::getBoundedTempForGrowth), computed once (~80KB)
+class TemperatureFactorTable {
+public:
+    TemperatureFactorTable() {
+        const size_t size = (size_t) std::ceil((CTM - TEMPERATURE_TABLE_MIN) / TEMPERATURE_TABLE_STEP) + 2;
+        entries.resize(size);
+        for (size_t i = 0; i < size; ++i) {
+            const double temp = std::min((double) CTM, TEMPERATURE_TABLE_MIN + (double) i * TEMPERATURE_TABLE_STEP);
+            const double V = (CTM - temp) / (CTM - CTO);
+            entries[i] = {
+                std::pow(V, (double) CONS_X) * std::exp(CONS_X * (1.0 - V)),
+                std::exp(RQ * temp),
+                std::pow(temp, (double) FB),
+                std::pow(temp, (double) UB)
+            };
+        }
+    }
+
+    TemperatureFactors lookup(const float temp) const {
+        return temp < TEMPERATURE_TABLE_MIN ? exactTemperatureFactors(temp) : this->interpolate(temp);
+    }
+
+    // Interpolate a temperature of at least TEMPERATURE_TABLE_MIN (higher ones are capped at CTM)
+    TemperatureFactors interpolate(const float temp) const {
+        const float position = std::min((temp - TEMPERATURE_TABLE_MIN) * (1.0f / TEMPERATURE_TABLE_STEP),
+                                        (float) (entries.size() - 2));
+        const size_t i = (size_t) position;
+        const double t = position - (float) i;
+        const TemperatureFactors &lo = entries[i];
+        const TemperatureFactors &hi = entries[i + 1];
+        return {
+            lo.consumption + t * (hi.consumption - lo.consumption),
+            lo.respiration + t * (hi.respiration - lo.respiration),
+            lo.egestion + t * (hi.egestion - lo.egestion),
+            lo.excretion + t * (hi.excretion - lo.excretion)
+        };
+    }
+
+private:
+    std::vector<TemperatureFactors> entries;
+};
+
+const TemperatureFactorTable &temperatureFactorTable() {
+    static const TemperatureFactorTable table;
+    return table;
+}
+
+// Single precision temperature factors for the batch kernel
+struct TemperatureFactorsF {
+    float consumption;
+    float respiration;
+    float egestion;
+    float excretion;
+};
+
+// The evaluateBioenergeticsBatch loop, with the source of the temperature factors inlined by the caller
+template<typename FactorsAt>
+inline void bioenergeticsLoop(const ModelParams &params, const float mass, const float forkLength, const size_t n,
+                              const float *__restrict temp, const float *__restrict pmax,
+                              const float *__restrict cost, const float *__restrict popDensity,
+                              const float *__restrict habitatMortalityConst,
+                              float *__restrict growth, float *__restrict mortality, float *__restrict fitness,
+                              FactorsAt factorsAt) {
+    // Terms that only depend on the fish (see getGrowth)
+    const float Cmax = CA * std::pow(mass, CB);
+    const float respirationMass = RA * std::pow(mass, RB);
+    // ...and on the fish and parameters (see getMortality, same constants)
+    const float a = 1.849f;
+    const float b_m = -0.8f;
+    const float b_s = -2.395f;
+    const float S = 250.0f;
+    const float sizeScale = (float) (S / std::exp(b_s + a * std::log((double) forkLength)));
+    const float mortMin = params.mortMin;
+    const float mortRange = params.mortMax - params.mortMin;
+    const float logInflection = std::log(params.mortalityInflectionPoint);
+
+    for (size_t i = 0; i < n; ++i) {
+        const float P = pmax[i];
+        const TemperatureFactorsF f = factorsAt(temp[i]);
+        const float consumption = Cmax * P * f.consumption;
+        const float egestion = FA * f.egestion * std::exp(FG * P) * consumption;
+        const float excretion = UA * f.excretion * std::exp(UG * P) * (consumption - egestion);
+        const float velocity = (cost[i] / (60 * 60)) * 100;
+        const float respiration = respirationMass * f.respiration * std::exp(RTO * velocity);
+        const float specificDynamicAction = SDA * (consumption - egestion);
+        const float delta = consumption - respiration - specificDynamicAction - egestion - excretion;
+        const float g = (delta / 24) * mass;
+
+        // Empty locations (density 0) are clamped so log stays finite; the term is 1 either way
+        const float logDensity = std::log(std::max(popDensity[i], std::numeric_limits<float>::min()));
+        const float densityTerm = std::exp(-std::exp(-b_m * (logDensity - logInflection)));
+        const float m = (mortMin + mortRange * densityTerm) * sizeScale * habitatMortalityConst[i];
+
+        growth[i] = g;
+        mortality[i] = m;
+        fitness[i] = g / m;
+    }
+}
+}
+
+TemperatureFactors tabulatedTemperatureFactors(const float temp) {
+    return temperatureFactorTable().lookup(temp);
+}
+
+TemperatureFactors temperatureFactors(const ModelParams &params, const float temp) {
+    return params.temperatureFactorTable ? tabulatedTemperatureFactors(temp) : exactTemperatureFactors(temp);
+}
+
+void evaluateBioenergeticsBatch(const ModelParams &params, const float mass, const float forkLength, const size_t n,
+                                const float *temp, const float *pmax, const float *cost, const float *popDensity,
+                                const float *habitatMortalityConst, float *growth, float *mortality, float *fitness) {
+    // The table's domain is checked once for the whole batch, so the loop itself stays branch-free; a batch
+    // with any temperature below the table (rare: only near-freezing water) is evaluated exactly throughout
+    const bool inTable = params.temperatureFactorTable
+                         && std::all_of(temp, temp + n, [](const float T) { return T >= TEMPERATURE_TABLE_MIN; });
+    if (inTable) {
+        const TemperatureFactorTable &table = temperatureFactorTable();
+        bioenergeticsLoop(params, mass, forkLength, n, temp, pmax, cost, popDensity, habitatMortalityConst,
+                          growth, mortality, fitness, [&table](const float T) {
+                              const TemperatureFactors f = table.interpolate(T);
+                              return TemperatureFactorsF{(float) f.consumption, (float) f.respiration,
+                                                         (float) f.egestion, (float) f.excretion};
+                          });
+    } else {
+        bioenergeticsLoop(params, mass, forkLength, n, temp, pmax, cost, popDensity, habitatMortalityConst,
+                          growth, mortality, fitness, [](const float T) {
+                              const float V = (CTM - T) / (CTM - CTO);
+                              return TemperatureFactorsF{
+                                  std::pow(V, CONS_X) * std::exp(CONS_X * (1.0f - V)), std::exp(RQ * T),
+                                  std::pow(T, FB), std::pow(T, UB)
+                              };
+                          });
+    }
+}
@@ -0,0 +1,214 @@
+#include "compact_history.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr float TEMP_SCALE = 100.0f;
+
+int16_t tempToFixed(float temp) {
+    const float scaled = std::round(temp * TEMP_SCALE);
+    return (int16_t) std::min(std::max(scaled, (float) INT16_MIN), (float) INT16_MAX);
+}
+
+void writeVarint(std::vector<uint8_t> &out, int delta) {
+    // Zigzag: small differences of either sign become small unsigned values
+    uint32_t value = ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31);
+    while (value >= 0x80) {
+        out.push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t) value);
+}
+
+int readVarint(const uint8_t *&in) {
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        const uint8_t byte = *in++;
+        value |= (uint32_t) (byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            break;
+        }
+    }
+    return (int) (value >> 1) ^ -(int) (value & 1);
+}
+
+template<typename T>
+size_t vectorBytes(const std::vector<T> &v) {
+    return v.capacity() * sizeof(T);
+}
+}
+
+uint16_t floatToHalf(float value) {
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    const uint16_t sign = (uint16_t) ((x >> 16) & 0x8000);
+    x &= 0x7fffffff;
+    if (x >= 0x7f800000) {
+        // Infinity, or NaN (kept quiet)
+        return sign | (x > 0x7f800000 ? 0x7e00 : 0x7c00);
+    }
+    if (x >= 0x477ff000) {
+        // Rounds to 65520 or more
+        return sign | 0x7c00;
+    }
+    if (x < 0x38800000) {
+        // Below 2^-14: a subnormal half, in units of 2^-24
+        if (x <= 0x33000000) {
+            return sign;
+        }
+        const uint32_t mantissa = (x & 0x7fffff) | 0x800000;
+        const uint32_t shift = 126 - (x >> 23);
+        uint32_t h = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (h & 1))) {
+            ++h;
+        }
+        return sign | (uint16_t) h;
+    }
+    // Rebias the exponent and keep the top 10 mantissa bits (a carry may round up into the exponent)
+    uint32_t h = (x >> 13) - ((127 - 15) << 10);
+    const uint32_t rest = x & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (h & 1))) {
+        ++h;
+    }
+    return sign | (uint16_t) h;
+}
+
+float halfToFloat(uint16_t bits) {
+    const uint32_t sign = (uint32_t) (bits & 0x8000) << 16;
+    const uint32_t exponent = (bits >> 10) & 0x1f;
+    const uint32_t mantissa = bits & 0x3ff;
+    uint32_t x;
+    if (exponent == 0x1f) {
+        x = sign | 0x7f800000 | (mantissa << 13);
+    } else if (exponent != 0) {
+        x = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    } else {
+        const float magnitude = std::ldexp((float) mantissa, -24);
+        return sign != 0 ? -magnitude : magnitude;
+    }
+    float value;
+    std::memcpy(&value, &x, sizeof(value));
+    return value;
+}
+
+void CompactHistory::append(int location, float growth, float pmax, float mortality, float temp, float depth,
+                            FlowVelocity flowVelocity) {
+    if (this->samples.size() % LOCATION_KEY_INTERVAL == 0) {
+        this->locationKeys.push_back({(uint32_t) this->locationDeltas.size(), this->lastLocation});
+    }
+    writeVarint(this->locationDeltas, location - this->lastLocation);
+    this->lastLocation = location;
+    this->samples.push_back({
+        floatToHalf(growth), floatToHalf(pmax), floatToHalf(mortality), floatToHalf(depth),
+        floatToHalf(flowVelocity.u), floatToHalf(flowVelocity.v), tempToFixed(temp)
+    });
+}
+
+void CompactHistory::reserve(size_t timesteps) {
+    this->samples.reserve(timesteps);
+    this->locationDeltas.reserve(timesteps);
+    this->locationKeys.reserve((timesteps + LOCATION_KEY_INTERVAL - 1) / LOCATION_KEY_INTERVAL);
+}
+
+void CompactHistory::setSizeHistory(const std::vector<float> &massHistory,
+                                    const std::vector<float> &forkLengthHistory) {
+    this->mass.resize(massHistory.size());
+    std::transform(massHistory.begin(), massHistory.end(), this->mass.begin(), floatToHalf);
+    this->forkLength.resize(forkLengthHistory.size());
+    std::transform(forkLengthHistory.begin(), forkLengthHistory.end(), this->forkLength.begin(), floatToHalf);
+}
+
+size_t CompactHistory::bytes() const {
+    return sizeof(CompactHistory) + vectorBytes(this->locationDeltas) + vectorBytes(this->locationKeys)
+           + vectorBytes(this->samples) + vectorBytes(this->mass) + vectorBytes(this->forkLength);
+}
+
+HistorySample CompactHistory::at(size_t i) const {
+    const PackedSample &s = this->samples[i];
+    return {
+        this->locationAt(i),
+        halfToFloat(s.growth),
+        halfToFloat(s.pmax),
+        halfToFloat(s.mortality),
+        (float) s.temp / TEMP_SCALE,
+        halfToFloat(s.depth),
+        0.0f,
+        FlowVelocity(halfToFloat(s.flowVelocityU), halfToFloat(s.flowVelocityV)),
+        i < this->mass.size() ? halfToFloat(this->mass[i]) : 0.0f,
+        i < this->forkLength.size() ? halfToFloat(this->forkLength[i]) : 0.0f
+    };
+}
+
+int CompactHistory::locationAt(size_t i) const {
+    int location;
+    this->copyLocations(i, 1, &location);
+    return location;
+}
+
+void CompactHistory::copyLocations(size_t first, size_t count, int *out) const {
+    if (count == 0) {
+        return;
+    }
+    // Decode forward from the last key at or before first
+    const size_t keyIndex = first / LOCATION_KEY_INTERVAL;
+    const LocationKey &key = this->locationKeys[keyIndex];
+    const uint8_t *in = this->locationDeltas.data() + key.offset;
+    int location = key.previous;
+    for (size_t i = keyIndex * LOCATION_KEY_INTERVAL; i < first; ++i) {
+        location += readVarint(in);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        location += readVarint(in);
+        out[i] = location;
+    }
+}
+
+void CompactHistory::copy(HistoryChannel channel, size_t first, size_t count, float *out) const {
+    const PackedSample *in = this->samples.data() + first;
+    auto decodeEach = [in, count, out](auto valueOf) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = valueOf(in[i]);
+        }
+    };
+    auto decodeSizes = [first, count, out](const std::vector<uint16_t> &values) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = first + i < values.size() ? halfToFloat(values[first + i]) : 0.0f;
+        }
+    };
+    switch (channel) {
+        case HistoryChannel::Growth:
+            decodeEach([](const PackedSample &s) { return halfToFloat(s.growth); });
+            break;
+        case HistoryChannel::Pmax:
+            decodeEach([](const PackedSample &s) { return halfToFloat(s.pmax); });
+            break;
+        case HistoryChannel::Mortality:
+            decodeEach([](const PackedSample &s) { return halfToFloat(s.mortality); });
+            break;
+        case HistoryChannel::Temp:
+            decodeEach([](const PackedSample &s) { return (float) s.temp / TEMP_SCALE; });
+            break;
+        case HistoryChannel::Depth:
+            decodeEach([](const PackedSample &s) { return halfToFloat(s.depth); });
+            break;
+        case HistoryChannel::FlowSpeed:
+            std::fill(out, out + count, 0.0f);
+            break;
+        case HistoryChannel::FlowVelocityU:
+            decodeEach([](const PackedSample &s) { return halfToFloat(s.flowVelocityU); });
+            break;
+        case HistoryChannel::FlowVelocityV:
+            decodeEach([](const PackedSample &s) { return halfToFloat(s.flowVelocityV); });
+            break;
+        case HistoryChannel::Mass:
+            decodeSizes(this->mass);
+            break;
+        case HistoryChannel::ForkLength:
+            decodeSizes(this->forkLength);
+            break;
+    }
+}
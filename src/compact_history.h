@@ -0,0 +1,92 @@
+#ifndef COMPACT_HISTORY_H
+#define COMPACT_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "map.h"
+
+// The per-timestep values of a tagged fish's history
+enum class HistoryChannel {
+    Growth, Pmax, Mortality, Temp, Depth, FlowSpeed, FlowVelocityU, FlowVelocityV, Mass, ForkLength
+};
+
+// One recorded timestep of a tagged fish's history
+struct HistorySample {
+    int location;
+    float growth;
+    float pmax;
+    float mortality;
+    float temp;
+    float depth;
+    float flowSpeed;
+    FlowVelocity flowVelocity;
+    // Only known in replay mode (see Fish::calculateMassHistory)
+    float mass;
+    float forkLength;
+};
+
+// IEEE 754 binary16 conversion (round to nearest even; overflow saturates to infinity)
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t bits);
+
+/*
+ * A tagged fish's history in quantized form (see the compactHistories config parameter), about
+ * 16 bytes per timestep instead of 36.
+ *
+ * - Locations are stored as the differences between consecutive node ids, zigzag varint coded
+ *   (one byte while a fish stays within 63 ids of its last node). Every LOCATION_KEY_INTERVAL
+ *   timesteps a key records where the coded stream stands, so any timestep decodes in a bounded
+ *   number of steps. Node ids are exact.
+ * - Temperature is fixed point at 0.01 degrees C (error at most 0.005).
+ * - Growth, pmax, mortality, depth, flow velocity and, in replay mode, mass and fork length are
+ *   binary16 floats: relative error at most 2^-11 (about 0.05%), and values below 6.1e-5 in
+ *   magnitude lose relative precision gradually (absolute error at most 3e-8).
+ * - The deprecated flow speed channel is not kept; it decodes as 0.
+ */
+class CompactHistory {
+public:
+    static constexpr size_t LOCATION_KEY_INTERVAL = 64;
+
+    void append(int location, float growth, float pmax, float mortality, float temp, float depth,
+                FlowVelocity flowVelocity);
+    void reserve(size_t timesteps);
+    // Store the back-calculated mass and fork length histories (one value per recorded timestep)
+    void setSizeHistory(const std::vector<float> &mass, const std::vector<float> &forkLength);
+
+    size_t size() const { return this->samples.size(); }
+    // Bytes held (including unused capacity)
+    size_t bytes() const;
+
+    HistorySample at(size_t i) const;
+    int locationAt(size_t i) const;
+    // Decode count values starting at timestep first
+    void copyLocations(size_t first, size_t count, int *out) const;
+    void copy(HistoryChannel channel, size_t first, size_t count, float *out) const;
+
+private:
+    struct PackedSample {
+        uint16_t growth;
+        uint16_t pmax;
+        uint16_t mortality;
+        uint16_t depth;
+        uint16_t flowVelocityU;
+        uint16_t flowVelocityV;
+        int16_t temp;
+    };
+    struct LocationKey {
+        // Position of the key's timestep in locationDeltas
+        uint32_t offset;
+        // Node id of the timestep before it
+        int previous;
+    };
+
+    std::vector<uint8_t> locationDeltas;
+    std::vector<LocationKey> locationKeys;
+    int lastLocation = 0;
+    std::vector<PackedSample> samples;
+    std::vector<uint16_t> mass;
+    std::vector<uint16_t> forkLength;
+};
+
+#endif
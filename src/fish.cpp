@@ -1,54 +1,21 @@
 #include "fish.h"
 #include "fish_movement.h"
 
+#include <algorithm>
 #include <deque>
 #include <cmath>
 #include <iostream>
 #include <unordered_set>
 #include <utility>
 
+#include "bioenergetics.h"
 #include "fish_movement_downstream.h"
-#include "fish_movement_factory.h"
 #include "util.h"
 
-const float CA = 0.303;
-const float CB = -0.275;
-const float CQ = 5.0;
-const float CTO = 15.0;
-const float CTM = 25.0; // was 18.0
-//const float CTL = 24.0;
-//const float CK1 = 0.36;
-//const float CK4 = 0.01;
-// Respiration (Equation 1)
-const float RA = 0.00264;
-const float RB = -0.217;
-const float RQ = 0.06818;
-const float RTO = 0.0234;
-//const float RTM = 0.0;
-//const float RTL = 25.0;
-//const float RK1 = 1.0;
-//const float RK4 = 0.13;
-//const float ACT = 9.7;
-//const float BACT = 0.0405;
-const float SDA = 0.172;
-// Egestion (uses Equation set 2, for now)
-const float FA = 0.212;
-const float FB = -0.222;
-const float FG = 0.631;
-// Excretion
-const float UA = 0.0314;
-const float UB = 0.58;
-const float UG = -0.299;
-
 // Pmax params
 const float consA = 1; // maybe play with this
 const float consV = 5; // maybe play with this - assumes there is an excess of food
 
-// Consumption (g*g^-1*d^-1)
-const float CONS_Z = log(CQ) * (CTM - CTO);
-const float CONS_Y = log(CQ) * (CTM - CTO + 2.0);
-const float CONS_X = (pow(CONS_Z, 2.0) * pow(1.0 + sqrt(1.0 + 40/CONS_Y), 2.0))/400.0;
-
 const float AVG_LOCAL_ABUNDANCE = 7.5839;
 
 // Convert a fork length value (in mm) to a mass value (in g)
@@ -89,16 +56,7 @@ Fish::Fish(
         lastFlowSpeed_old(0),
         lastFlowVelocity(0, 0),
         taggedTime(-1L),
-        locationHistory(nullptr),
-        pmaxHistory(nullptr),
-        growthHistory(nullptr),
-        mortalityHistory(nullptr),
-        tempHistory(nullptr),
-        depthHistory(nullptr),
-        flowSpeedHistory_old(nullptr),
-        flowVelocityHistory(nullptr),
-        massHistory(nullptr),
-        forkLengthHistory(nullptr)
+        history(nullptr)
     {this->entryMass = this->mass;}
 
 
@@ -173,11 +131,9 @@ void Fish::getReachableNodes(Model &model, std::unordered_map<MapNode *, float>
     float swimSpeed = swimSpeedFromForkLength(this->forkLength);
     float swimRange = swimSpeed*SECONDS_PER_TIMESTEP;
 
-    auto fitness_calculator = [this](Model& model, MapNode& node, float cost) { return this->getFitness(model, node, cost); };
-    auto fishMovement = FishMovementFactory::createFishMovement(model, swimSpeed, swimRange, fitness_calculator, model.getConfigMap());
-
-    fishMovement->determineNextLocation(this->location);
-    auto reachables = fishMovement->getAllReachableNeighborsInTimestep();
+    FishMovement &fishMovement = model.getMovementEngine();
+    fishMovement.determineNextLocationFor(*this, swimSpeed, swimRange);
+    const auto &reachables = fishMovement.getAllReachableNeighborsInTimestep();
     for (auto [node, cost, fitness] : reachables) {
         out[node] = fitness;
     }
@@ -365,6 +321,49 @@ float Fish::getFitness(Model &model, MapNode &loc, float cost) {
     return this->getGrowth(model, loc, cost) / this->getMortality(model, loc);
 }
 
+namespace {
+// Per-thread input/output arrays for getFitnessBatch, reused across calls
+struct BioenergeticsScratch {
+    std::vector<float> temp, pmax, cost, popDensity, habitatMortalityConst;
+    std::vector<float> growth, mortality, fitness;
+
+    void resize(size_t n) {
+        for (auto *v: {&temp, &pmax, &cost, &popDensity, &habitatMortalityConst, &growth, &mortality, &fitness}) {
+            v->resize(n);
+        }
+    }
+};
+
+thread_local BioenergeticsScratch bioenergeticsScratch;
+}
+
+void Fish::getFitnessBatch(Model &model, std::tuple<MapNode *, float, float> *candidates, size_t n) {
+    BioenergeticsScratch &s = bioenergeticsScratch;
+    s.resize(n);
+    const float habitatMortalityMultiplier = model.getParams().habitatMortalityMultiplier;
+    for (size_t i = 0; i < n; ++i) {
+        MapNode &loc = *std::get<0>(candidates[i]);
+        s.temp[i] = this->getBoundedTempForGrowth(model, loc);
+        s.pmax[i] = this->getPmax(model, loc);
+        s.cost[i] = std::get<1>(candidates[i]);
+        s.popDensity[i] = loc.popDensity;
+        s.habitatMortalityConst[i] = habitatTypeMortalityConst(loc.type, habitatMortalityMultiplier);
+    }
+    evaluateBioenergeticsBatch(model.getParams(), this->mass, this->forkLength, n,
+                               s.temp.data(), s.pmax.data(), s.cost.data(), s.popDensity.data(),
+                               s.habitatMortalityConst.data(), s.growth.data(), s.mortality.data(),
+                               s.fitness.data());
+    for (size_t i = 0; i < n; ++i) {
+        std::get<2>(candidates[i]) = s.fitness[i];
+    }
+}
+
+void Fish::getFitnessEach(Model &model, std::tuple<MapNode *, float, float> *candidates, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        std::get<2>(candidates[i]) = this->getFitness(model, *std::get<0>(candidates[i]), std::get<1>(candidates[i]));
+    }
+}
+
 void Fish::incrementExitHabitatHoursByOneTimestep() {
     this->numExitHabitatHours += HOURS_PER_TIMESTEP;
 }
@@ -375,14 +374,14 @@ void Fish::incrementExitHabitatHoursByOneTimestep() {
  */
 
 bool Fish::move(Model &model) {
+    // Random draws for this update depend only on (seed, fish, timestep), not on thread scheduling
+    RandomStreamScope randomStream(RandomStreamPhase::Move, this->id, model.time);
     float swimSpeed = swimSpeedFromForkLength(this->forkLength);
     float swimRange = swimSpeed*SECONDS_PER_TIMESTEP;
     float lastFlowSpeed_node_old = model.hydroModel.getUnsignedFlowSpeedAt(*(this->location));
 
-    auto fitness_calculator = [this](Model& model, MapNode& node, float cost) { return this->getFitness(model, node, cost); };
-    auto fishMovement = FishMovementFactory::createFishMovement(model, swimSpeed, swimRange, fitness_calculator, model.getConfigMap());
-
-    std::pair<MapNode *, float> result = fishMovement->determineNextLocation(this->location);
+    // The model's movement engine for this thread (strategy picked once from AgentAwareness)
+    std::pair<MapNode *, float> result = model.getMovementEngine().determineNextLocationFor(*this, swimSpeed, swimRange);
     MapNode *point = result.first;
     float accumulatedCost = result.second;
 
@@ -446,13 +445,14 @@ void Fish::dieStarvation(Model &model) {
 // ReSharper disable once CppMemberFunctionMayBeStatic
 float Fish::getPmax(const Model &model, const MapNode &loc) { // NOLINT(*-convert-member-functions-to-static)
     const bool isNearshoreHabitat = isNearshore(loc.type);
+    const ModelParams &params = model.getParams();
     const float growthSlope = (isNearshoreHabitat)
-                                  ? model.getFloat(ModelParamKey::GrowthSlopeNearshore)
-                                  : model.getFloat(ModelParamKey::GrowthSlope);
+                                  ? params.growthSlopeNearshore
+                                  : params.growthSlope;
     const float upperLimit = (isNearshoreHabitat)
-                           ? model.getFloat(ModelParamKey::PmaxUpperLimitNearshore)
-                           : model.getFloat(ModelParamKey::PmaxUpperLimit);
-    const float lowerLimit = model.getFloat(ModelParamKey::PmaxLowerLimit);
+                           ? params.pmaxUpperLimitNearshore
+                           : params.pmaxUpperLimit;
+    const float lowerLimit = params.pmaxLowerLimit;
 
     constexpr float SQ_METER_TO_HECTARE_CONVERSION = 10000.0;
     const float populationDensity = loc.popDensity * SQ_METER_TO_HECTARE_CONVERSION;
@@ -479,16 +479,15 @@ float Fish::getGrowth(Model &model, MapNode &loc, float cost) {
 
 float Fish::getGrowth(Model &model, MapNode &loc, float cost, float Pmax) const {
     const float my_temp = this->getBoundedTempForGrowth(model, loc);
+    const TemperatureFactors factors = temperatureFactors(model.getParams(), my_temp);
 
-    // TODO: Should fish die if temp > CTM? Otherwise have to cap temp
-    const float V = (CTM - my_temp)/(CTM - CTO);
-    const float fTcons = pow(V, CONS_X) * exp(CONS_X * (1 - V));
+    const float fTcons = factors.consumption;
     const float Cmax = CA * pow(mass, CB);
     const float Consumption = Cmax * Pmax * fTcons;
 
     // Egestion and Excretion
-    const float Egestion = FA * pow(my_temp, FB) * exp(FG * Pmax) * Consumption;
-    const float Excretion = UA * pow(my_temp, UB) * exp(UG * Pmax) * (Consumption - Egestion);
+    const float Egestion = FA * factors.egestion * exp(FG * Pmax) * Consumption;
+    const float Excretion = UA * factors.excretion * exp(UG * Pmax) * (Consumption - Egestion);
 
     // Respiration (g*g^-1*d^-1)
     // cost is distance traveled this timestep, in m
@@ -499,7 +498,7 @@ float Fish::getGrowth(Model &model, MapNode &loc, float cost, float Pmax) const
     //else:
     //	vel = ACT * mass ** RK4 * math.e ** (BACT * my_temp)
     const float Activity = exp(RTO * Velocity);
-    const float fTresp = exp(RQ * my_temp);
+    const float fTresp = factors.respiration;
     const float Respiration = RA * pow(mass, RB) * fTresp * Activity;
     const float SpecificDynamicAction = SDA * (Consumption - Egestion);
 
@@ -512,14 +511,15 @@ float Fish::getGrowth(Model &model, MapNode &loc, float cost, float Pmax) const
 
 // Calculate mortality risk for a given node
 float Fish::getMortality(Model &model, MapNode &loc) const {
-    const double mort_min_c = model.getFloat(ModelParamKey::MortMin);
-    const double mort_max_d = model.getFloat(ModelParamKey::MortMax);
-    const float habitat_mortality_multiplier = model.getFloat(ModelParamKey::HabitatMortalityMultiplier);
+    const ModelParams &params = model.getParams();
+    const double mort_min_c = params.mortMin;
+    const double mort_max_d = params.mortMax;
+    const float habitat_mortality_multiplier = params.habitatMortalityMultiplier;
     const double habTypeMortConst = habitatTypeMortalityConst(loc.type, habitat_mortality_multiplier);
     const double a = 1.849; // slope
     const double b_m = -0.8; //slope at inflection
     const double b_s = -2.395; // intercept
-    const double e = model.getFloat(ModelParamKey::MortalityInflectionPoint); // inflection point on x
+    const double e = params.mortalityInflectionPoint; // inflection point on x
     const double L = this->forkLength;
     const double X = loc.popDensity; // * 1000; // convert m^2 to ha
     const double S = 250; // scaling factor numerator
@@ -530,6 +530,7 @@ float Fish::getMortality(Model &model, MapNode &loc) const {
 // Calculate growth amount and mortality risk at this fish's current location,
 // then apply growth and check mortality risk (and die if that's the way it goes)
 bool Fish::growAndDie(Model &model) {
+    RandomStreamScope randomStream(RandomStreamPhase::GrowAndDie, this->id, model.time);
     const float pMax = this->getPmax(model, *(this->location));
     const float growth = this->getGrowth(model, *(this->location), this->travel, pMax);
     const float mortality = this->getMortality(model, *(this->location));
@@ -560,34 +561,42 @@ bool Fish::growAndDie(Model &model) {
     return true;
 }
 
-void Fish::addHistoryBuffers() {
-    this->locationHistory = new std::vector<int>();
-    this->growthHistory = new std::vector<float>();
-    this->pmaxHistory = new std::vector<float>();
-    this->mortalityHistory = new std::vector<float>();
-    this->tempHistory = new std::vector<float>();
-    this->depthHistory = new std::vector<float>();
-    this->flowSpeedHistory_old = new std::vector<float>();
-    this->flowVelocityHistory = new std::vector<FlowVelocity>();
+void Fish::addHistoryBuffers(bool compact) {
+    this->history = std::make_unique<FishHistory>();
+    if (compact) {
+        this->history->compact = std::make_unique<CompactHistory>();
+    }
 }
 
 void Fish::calculateMassHistory() {
-    this->massHistory = new std::vector<float>();
-    this->forkLengthHistory = new std::vector<float>();
-    size_t T = this->locationHistory->size();
-    this->massHistory->resize(T, 0.0f);
-    this->forkLengthHistory->resize(T, 0.0f);
+    FishHistory &h = *this->history;
+    size_t T = h.length();
+    // Compact histories back-calculate from their decoded growth and keep the results quantized
+    std::vector<float> decodedGrowth;
+    const float *growth = h.growth.data();
+    if (h.compact != nullptr) {
+        decodedGrowth.resize(T);
+        h.copy(HistoryChannel::Growth, 0, T, decodedGrowth.data());
+        growth = decodedGrowth.data();
+    }
+    h.mass.assign(T, 0.0f);
+    h.forkLength.assign(T, 0.0f);
     for (size_t i = 0; i < T; ++i) {
-        (*this->massHistory)[T - i - 1] = this->mass;
-        (*this->forkLengthHistory)[T - i - 1] = forkLengthFromMass(this->mass);
-        this->mass -= (*this->growthHistory)[T - i - 1];
+        h.mass[T - i - 1] = this->mass;
+        h.forkLength[T - i - 1] = forkLengthFromMass(this->mass);
+        this->mass -= growth[T - i - 1];
+    }
+    this->mass = h.mass[0];
+    this->forkLength = h.forkLength[0];
+    if (h.compact != nullptr) {
+        h.compact->setSizeHistory(h.mass, h.forkLength);
+        std::vector<float>().swap(h.mass);
+        std::vector<float>().swap(h.forkLength);
     }
-    this->mass = (*this->massHistory)[0];
-    this->forkLength = (*this->forkLengthHistory)[0];
 }
 
 bool Fish::isNotTagged() const {
-    return this->locationHistory == nullptr;
+    return this->history == nullptr;
 }
 
 void Fish::trackHistory() const {
@@ -596,24 +605,114 @@ void Fish::trackHistory() const {
     }
     if (this->location->type == HabitatType::Nearshore && this->lastPmax != 1.0) {
         std::cout << "Tracking nearshore Pmax: " << this->lastPmax << " for ID: " << this->location->id
-        << " at step: " << this->locationHistory->size() -1 << std::endl;
+        << " at step: " << (long) this->history->length() - 1 << std::endl;
     }
-    this->locationHistory->push_back(this->location->id);
-    this->growthHistory->push_back(this->lastGrowth);
-    this->pmaxHistory->push_back(this->lastPmax);
-    this->mortalityHistory->push_back(this->lastMortality);
-    this->tempHistory->push_back(this->lastTemp);
-    this->depthHistory->push_back(this->lastDepth);
-    this->flowSpeedHistory_old->push_back(this->lastFlowSpeed_old);
-    this->flowVelocityHistory->push_back(this->lastFlowVelocity);
+    this->history->append(this->location->id, this->lastGrowth, this->lastPmax, this->lastMortality, this->lastTemp,
+                          this->lastDepth, this->lastFlowSpeed_old, this->lastFlowVelocity);
 }
 
 void Fish::tag(Model &model) {
-    constexpr int TAG_FREQUENCY = 2500;
-    if (this->taggedTime != -1 || (this->id % TAG_FREQUENCY) != 0) {
+    if (this->taggedTime != -1) {
         return;
     }
-    this->addHistoryBuffers();
+    this->addHistoryBuffers(model.getParams().compactHistories);
     this->taggedTime = model.time;
     this->trackHistory();
 }
+
+void Fish::untag() {
+    this->taggedTime = -1;
+    this->history.reset();
+}
+
+size_t FishHistory::length() const {
+    return this->compact != nullptr ? this->compact->size() : this->location.size();
+}
+
+void FishHistory::reserve(size_t timesteps) {
+    if (this->compact != nullptr) {
+        this->compact->reserve(timesteps);
+        return;
+    }
+    this->location.reserve(timesteps);
+    this->growth.reserve(timesteps);
+    this->pmax.reserve(timesteps);
+    this->mortality.reserve(timesteps);
+    this->temp.reserve(timesteps);
+    this->depth.reserve(timesteps);
+    this->flowSpeed_old.reserve(timesteps);
+    this->flowVelocity.reserve(timesteps);
+}
+
+void FishHistory::append(int location, float growth, float pmax, float mortality, float temp, float depth,
+                         float flowSpeed, FlowVelocity flowVelocity) {
+    if (this->compact != nullptr) {
+        this->compact->append(location, growth, pmax, mortality, temp, depth, flowVelocity);
+        return;
+    }
+    this->location.push_back(location);
+    this->growth.push_back(growth);
+    this->pmax.push_back(pmax);
+    this->mortality.push_back(mortality);
+    this->temp.push_back(temp);
+    this->depth.push_back(depth);
+    this->flowSpeed_old.push_back(flowSpeed);
+    this->flowVelocity.push_back(flowVelocity);
+}
+
+HistorySample FishHistory::at(size_t i) const {
+    if (this->compact != nullptr) {
+        return this->compact->at(i);
+    }
+    return {
+        this->location[i], this->growth[i], this->pmax[i], this->mortality[i], this->temp[i], this->depth[i],
+        this->flowSpeed_old[i], this->flowVelocity[i],
+        i < this->mass.size() ? this->mass[i] : 0.0f,
+        i < this->forkLength.size() ? this->forkLength[i] : 0.0f
+    };
+}
+
+void FishHistory::copyLocations(size_t first, size_t count, int *out) const {
+    if (this->compact != nullptr) {
+        this->compact->copyLocations(first, count, out);
+    } else {
+        std::copy_n(this->location.begin() + first, count, out);
+    }
+}
+
+void FishHistory::copy(HistoryChannel channel, size_t first, size_t count, float *out) const {
+    if (this->compact != nullptr) {
+        this->compact->copy(channel, first, count, out);
+        return;
+    }
+    const std::vector<float> *values = nullptr;
+    switch (channel) {
+        case HistoryChannel::Growth: values = &this->growth; break;
+        case HistoryChannel::Pmax: values = &this->pmax; break;
+        case HistoryChannel::Mortality: values = &this->mortality; break;
+        case HistoryChannel::Temp: values = &this->temp; break;
+        case HistoryChannel::Depth: values = &this->depth; break;
+        case HistoryChannel::FlowSpeed: values = &this->flowSpeed_old; break;
+        case HistoryChannel::Mass: values = &this->mass; break;
+        case HistoryChannel::ForkLength: values = &this->forkLength; break;
+        case HistoryChannel::FlowVelocityU:
+        case HistoryChannel::FlowVelocityV:
+            for (size_t i = 0; i < count; ++i) {
+                const FlowVelocity &velocity = this->flowVelocity[first + i];
+                out[i] = channel == HistoryChannel::FlowVelocityU ? velocity.u : velocity.v;
+            }
+            return;
+    }
+    // Mass and fork length are only known in replay mode
+    const size_t available = first < values->size() ? std::min(count, values->size() - first) : 0;
+    std::copy_n(values->begin() + first, available, out);
+    std::fill(out + available, out + count, 0.0f);
+}
+
+size_t FishHistory::bytes() const {
+    auto vectorBytes = [](const auto &v) { return v.capacity() * sizeof(v[0]); };
+    return sizeof(FishHistory) + vectorBytes(this->location) + vectorBytes(this->pmax) + vectorBytes(this->growth)
+           + vectorBytes(this->mortality) + vectorBytes(this->temp) + vectorBytes(this->depth)
+           + vectorBytes(this->flowSpeed_old) + vectorBytes(this->flowVelocity) + vectorBytes(this->mass)
+           + vectorBytes(this->forkLength) + (this->compact != nullptr ? this->compact->bytes() : 0);
+}
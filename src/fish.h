@@ -1,10 +1,14 @@
 #ifndef __FISH_FISH_H
 #define __FISH_FISH_H
 
+#include <cstddef>
+#include <memory>
+#include <tuple>
 #include <unordered_map>
 
 #include "model.h"
 #include "map.h"
+#include "compact_history.h"
 
 /*
 * Alive: currently active (this fish is in Model::livingIndividuals)
@@ -36,6 +40,40 @@ inline float swimSpeedFromForkLength(float forkLength) {
     return SWIM_SPEED_BODY_LENGTHS_PER_SEC * forkLength * 0.001f;
 }
 
+// Full life history of a tagged fish (one entry per timestep since tagging)
+struct FishHistory {
+    std::vector<int> location;
+    std::vector<float> pmax;
+    std::vector<float> growth;
+    std::vector<float> mortality;
+    std::vector<float> temp;
+    std::vector<float> depth;
+    std::vector<float> flowSpeed_old;
+    std::vector<FlowVelocity> flowVelocity;
+    // mass and fork length histories (only filled in replay mode, see Fish::calculateMassHistory)
+    std::vector<float> mass;
+    std::vector<float> forkLength;
+    // Set for compact histories (see compactHistories), which are recorded here instead of in the vectors above
+    std::unique_ptr<CompactHistory> compact;
+
+    // Readers go through these, which work for either form
+    size_t length() const;
+    void reserve(size_t timesteps);
+    void append(int location, float growth, float pmax, float mortality, float temp, float depth, float flowSpeed,
+                FlowVelocity flowVelocity);
+    HistorySample at(size_t i) const;
+    // Copy count values starting at the timestep first
+    void copyLocations(size_t first, size_t count, int *out) const;
+    void copy(HistoryChannel channel, size_t first, size_t count, float *out) const;
+    // Bytes held
+    size_t bytes() const;
+};
+
+/*
+ * Per-fish state. The fields touched by every per-step pass (location, mass, fork length,
+ * travel, status, ranks) are mirrored in Model::population in structure-of-arrays form;
+ * see population.h. Tag histories live in a separate, lazily allocated FishHistory.
+ */
 class Fish {
 public:
     // index in Model::individuals
@@ -72,28 +110,10 @@ public:
     float lastFlowSpeed_old; // deprecated
     FlowVelocity lastFlowVelocity;
 
-    // the mass rank of this fish among fish at its location
-    int massRank;
-    // the arrival time rank of this fish among fish at its location
-    int arrivalTimeRank;
     // when this fish was tagged (-1 if it's not a tagged fish)
     long taggedTime;
-    // location history (only present if tagged)
-    std::vector<int> *locationHistory;
-    // Pmax history (only present if tagged)
-    std::vector<float> *pmaxHistory;
-    // growth history (only present if tagged)
-    std::vector<float> *growthHistory;
-    // mortality history (only present if tagged)
-    std::vector<float> *mortalityHistory;
-    std::vector<float> *tempHistory;
-    std::vector<float> *depthHistory;
-    std::vector<float> *flowSpeedHistory_old;
-    std::vector<FlowVelocity> *flowVelocityHistory;
-    // mass history (only present if in replay mode)
-    std::vector<float> *massHistory;
-    // fork length history (only present if in replay mode)
-    std::vector<float> *forkLengthHistory;
+    // life history (only present if tagged)
+    std::unique_ptr<FishHistory> history;
 
     Fish(
         unsigned long id,
@@ -142,6 +162,12 @@ public:
     float getMortality(Model &model, MapNode &loc) const;
     // Compute the ratio of growth to mortality for a given location and movement cost
     virtual float getFitness(Model &model, MapNode &loc, float cost);
+    // Fill in the fitness (third element) of n (location, cost, fitness) candidates. Fish evaluates them all at
+    // once with evaluateBioenergeticsBatch, which matches its own getFitness; a subclass that overrides getFitness
+    // overrides this too, usually with getFitnessEach
+    virtual void getFitnessBatch(Model &model, std::tuple<MapNode *, float, float> *candidates, size_t n);
+    // getFitnessBatch with one (virtual) getFitness call per candidate
+    void getFitnessEach(Model &model, std::tuple<MapNode *, float, float> *candidates, size_t n);
     /*
     * Run this fish's growth update:
     *   Get the growth (g) and mortality risk for the current location
@@ -150,14 +176,16 @@ public:
     * Returns true if this fish is alive post-update
     */
     bool growAndDie(Model &model);
-    // Create lists to keep track of vital rates and location
-    void addHistoryBuffers();
+    // Create lists to keep track of vital rates and location (quantized, if compact; see CompactHistory)
+    void addHistoryBuffers(bool compact = false);
     // Back-calculate mass and fork length histories from growth and final mass
     void calculateMassHistory();
 
 
     // Mark this fish as "tagged" (so that its full life history will be recorded)
     void tag(Model &model);
+    // Stop recording this fish's life history and discard what was recorded
+    void untag();
 
 private:
     float getBoundedTempForGrowth(Model &model, MapNode &loc) const;
@@ -5,9 +5,22 @@
 #include <cmath> // keep for Linux
 #include <vector>
 #include "fish_movement.h"
+#include "fish.h"
 #include "model.h"
 #include "hydro.h"
 #include "map.h"
+#include "sampling.h"
+
+namespace {
+// Per-thread buffers reused across every fish a thread moves, so that a movement step
+// doesn't touch the heap once they have grown to their working size
+struct MovementScratch {
+    std::vector<std::tuple<MapNode *, float, float> > neighbors;
+    std::vector<float> weights;
+};
+
+thread_local MovementScratch movementScratch;
+}
 
 
 void FishMovement::addCurrentLocation(std::vector<std::tuple<MapNode *, float, float> > &neighbors, MapNode *point,
@@ -18,23 +31,12 @@ void FishMovement::addCurrentLocation(std::vector<std::tuple<MapNode *, float, f
 
 void FishMovement::addReachableNeighbors(std::vector<std::tuple<MapNode *, float, float> > &neighbors, MapNode *point,
                                          float spentCost, MapNode *map_node) {
-    auto reachableNeighbors = getReachableNeighbors(point, spentCost, map_node);
-
-    allReachableNeighborsInTimestep.reserve(
-       allReachableNeighborsInTimestep.size() + reachableNeighbors.size()
-   );
-    neighbors.reserve(neighbors.size() + reachableNeighbors.size());
-
+    const size_t first = neighbors.size();
+    appendReachableNeighbors(neighbors, point, spentCost, map_node);
     allReachableNeighborsInTimestep.insert(
         allReachableNeighborsInTimestep.end(),
-        reachableNeighbors.begin(),
-        reachableNeighbors.end()
-    );
-
-    neighbors.insert(
-        neighbors.end(),
-        reachableNeighbors.begin(),
-        reachableNeighbors.end()
+        neighbors.begin() + first,
+        neighbors.end()
     );
 }
 
@@ -46,13 +48,6 @@ float FishMovement::getCurrentV(const MapNode &node) const {
     return hydroModel->getCurrentV(node);
 }
 
-/**
- * Calculate the dot product of two 2D vectors
- */
-double dotProduct(double ax, double ay, double bx, double by) {
-    return ax * bx + ay * by;
-}
-
 /**
  * Normalize a 2D vector (modifies the input variables)
  */
@@ -80,22 +75,14 @@ double FishMovement::calculateEffectiveSwimSpeed(const MapNode &startNode, const
 
     normalizeVector(dirX, dirY);
 
-    auto startNodeVelocity = hydroModel->getScaledFlowVelocityAt(startNode);
-    auto endNodeVelocity = hydroModel->getScaledFlowVelocityAt(endNode);
-
-    double uStart = static_cast<double>(startNodeVelocity.u);
-    double uEnd = static_cast<double>(endNodeVelocity.u);
-    double vStart = static_cast<double>(startNodeVelocity.v);
-    double vEnd = static_cast<double>(endNodeVelocity.v);
-
-    double avgU = (uStart + uEnd) / 2.0;
-    double avgV = (vStart + vEnd) / 2.0;
-
-    double waterVelocityInDirectionOfMovement = dotProduct(avgU, avgV, dirX, dirY);
-    double effectiveSpeed = stillWaterSwimSpeed + waterVelocityInDirectionOfMovement;
+    return calculateEffectiveSwimSpeed(startNode, endNode, dirX, dirY, stillWaterSwimSpeed);
+}
 
-    // Ensure the effective speed is non-negative
-    return std::max(0.0, effectiveSpeed);
+double FishMovement::calculateEffectiveSwimSpeed(const MapNode &startNode, const MapNode &endNode,
+                                                 double dirX, double dirY, double stillWaterSwimSpeed) const {
+    // Mean of the flow at both ends, projected onto the direction of movement
+    double waterVelocityInDirectionOfMovement = hydroModel->getWaterVelocityAlong(startNode, endNode, dirX, dirY);
+    return effectiveSwimSpeed(stillWaterSwimSpeed, waterVelocityInDirectionOfMovement);
 }
 
 /**
@@ -129,16 +116,54 @@ float FishMovement::calculateStayCost(MapNode *point, float spentCost) const {
     return remainingTime > 0.0f ? remainingTime * pointFlowSpeed : 0.0f;
 }
 
+float FishMovement::fitnessAt(MapNode &node, float cost) const {
+    if (fitnessSource != nullptr) {
+        return fitnessSource->getFitness(model, node, cost);
+    }
+    return fitnessCalculator(model, node, cost);
+}
+
 size_t FishMovement::selectNeighborIndex(const std::vector<std::tuple<MapNode *, float, float> > &neighbors) const {
-    std::vector<float> weights;
-    float totalFitness = 0.0f;
+    double totalFitness = 0.0;
     for (const auto &neighbor : neighbors) {
         totalFitness += std::get<2>(neighbor);
     }
-    for (const auto &neighbor : neighbors) {
-        weights.emplace_back(std::get<2>(neighbor) / totalFitness);
+    if (sampleOverrideForTesting != nullptr) {
+        // Tests see (and choose from) the normalized weights
+        std::vector<float> &weights = movementScratch.weights;
+        weights.clear();
+        for (const auto &neighbor : neighbors) {
+            weights.emplace_back((float) (std::get<2>(neighbor) / totalFitness));
+        }
+        return sample(weights.data(), neighbors.size());
+    }
+    return sampleWeighted(neighbors.size(), [&neighbors](size_t i) { return std::get<2>(neighbors[i]); },
+                          totalFitness);
+}
+
+void FishMovement::tryAddNeighbor(std::vector<std::tuple<MapNode *, float, float> > &neighbors, MapNode *startPoint,
+                                  MapNode *endNode, float length, double dirX, double dirY, float spentCost,
+                                  MapNode *initialFishLocation) const {
+    if (model.hydroModel.getDepth(*endNode) < MOVEMENT_DEPTH_CUTOFF) return;
+
+    float transitSpeed = (float) calculateEffectiveSwimSpeed(*startPoint, *endNode, dirX, dirY, swimSpeed);
+    addNeighborAtSpeed(neighbors, startPoint, endNode, length, transitSpeed, spentCost, initialFishLocation);
+}
+
+void FishMovement::addNeighborAtSpeed(std::vector<std::tuple<MapNode *, float, float> > &neighbors,
+                                      MapNode *startPoint, MapNode *endNode, float length, float transitSpeed,
+                                      float spentCost, MapNode *initialFishLocation) const {
+    if (canMoveInDirectionOfEndNode(transitSpeed, swimSpeed)) {
+        float edgeCost = (length / transitSpeed) * swimSpeed;
+        if (isDistributary(endNode->type) && startPoint == initialFishLocation) {
+            edgeCost = std::min(edgeCost, swimRange - spentCost);
+        }
+        float totalCost = spentCost + edgeCost;
+        if (totalCost <= swimRange) {
+            // Fitness is filled in afterwards, for all new neighbors at once
+            neighbors.emplace_back(endNode, totalCost, 0.0f);
+        }
     }
-    return sample(weights.data(), neighbors.size());
 }
 
 std::vector<std::tuple<MapNode *, float, float> > FishMovement::getReachableNeighbors(
@@ -147,40 +172,79 @@ std::vector<std::tuple<MapNode *, float, float> > FishMovement::getReachableNeig
     MapNode *initialFishLocation
 ) const {
     std::vector<std::tuple<MapNode *, float, float> > neighbors;
-    std::vector<Edge> allEdges;
-    allEdges.reserve(startPoint->edgesIn.size() + startPoint->edgesOut.size());
-    allEdges.insert(allEdges.end(), startPoint->edgesIn.begin(), startPoint->edgesIn.end());
-    allEdges.insert(allEdges.end(), startPoint->edgesOut.begin(), startPoint->edgesOut.end());
-
-    for (Edge &edge: allEdges) {
-        MapNode *startNode = startPoint;
-        MapNode *endNode = (startNode == edge.source ? edge.target : edge.source);
-
-        if (model.hydroModel.getDepth(*endNode) < MOVEMENT_DEPTH_CUTOFF) continue;
-
-        float transitSpeed = (float) calculateTransitSpeed(edge, startNode, swimSpeed);
-        if (canMoveInDirectionOfEndNode(transitSpeed, swimSpeed)) {
-            float edgeCost = (edge.length / transitSpeed) * swimSpeed;
-            if (isDistributary(endNode->type) && startPoint == initialFishLocation) {
-                edgeCost = std::min(edgeCost, swimRange - spentCost);
-            }
-            float totalCost = spentCost + edgeCost;
-            if (totalCost <= swimRange) {
-                float fitness = fitnessCalculator(model, *endNode, totalCost);
-                neighbors.emplace_back(endNode, totalCost, fitness);
+    appendReachableNeighbors(neighbors, startPoint, spentCost, initialFishLocation);
+    return neighbors;
+}
+
+void FishMovement::appendReachableNeighbors(
+    std::vector<std::tuple<MapNode *, float, float> > &neighbors,
+    MapNode *startPoint,
+    float spentCost,
+    MapNode *initialFishLocation
+) const {
+    const size_t first = neighbors.size();
+    appendReachableNodes(neighbors, startPoint, spentCost, initialFishLocation);
+    fillFitness(neighbors, first);
+}
+
+void FishMovement::fillFitness(std::vector<std::tuple<MapNode *, float, float> > &candidates, size_t first) const {
+    if (first >= candidates.size()) return;
+    // A fish scores all the candidates at once; a standalone fitness calculator is called once per candidate
+    if (fitnessSource != nullptr) {
+        fitnessSource->getFitnessBatch(model, candidates.data() + first, candidates.size() - first);
+        return;
+    }
+    for (size_t i = first; i < candidates.size(); ++i) {
+        std::get<2>(candidates[i]) = fitnessAt(*std::get<0>(candidates[i]), std::get<1>(candidates[i]));
+    }
+}
+
+void FishMovement::appendReachableNodes(
+    std::vector<std::tuple<MapNode *, float, float> > &neighbors,
+    MapNode *startPoint,
+    float spentCost,
+    MapNode *initialFishLocation
+) const {
+    const MapGraph &graph = model.mapGraph;
+    const int startIndex = graph.indexOf(startPoint);
+    if (startIndex != MapGraph::NOT_IN_GRAPH) {
+        // Frozen model map: walk the packed arcs, with this timestep's water velocity along each one if available
+        const double *arcWaterVelocity = hydroModel->getArcWaterVelocities(graph);
+        if (arcWaterVelocity != nullptr) {
+            for (uint32_t arc = graph.arcOffsets[startIndex]; arc < graph.arcOffsets[startIndex + 1]; ++arc) {
+                MapNode *endNode = graph.nodes[graph.arcTarget[arc]];
+                if (hydroModel->getDepth(*endNode) < MOVEMENT_DEPTH_CUTOFF) continue;
+                float transitSpeed = (float) effectiveSwimSpeed(swimSpeed, arcWaterVelocity[arc]);
+                addNeighborAtSpeed(neighbors, startPoint, endNode, graph.arcLength[arc], transitSpeed, spentCost,
+                                   initialFishLocation);
             }
+            return;
         }
+        for (uint32_t arc = graph.arcOffsets[startIndex]; arc < graph.arcOffsets[startIndex + 1]; ++arc) {
+            tryAddNeighbor(neighbors, startPoint, graph.nodes[graph.arcTarget[arc]], graph.arcLength[arc],
+                           graph.arcDirX[arc], graph.arcDirY[arc], spentCost, initialFishLocation);
+        }
+        return;
     }
-    return neighbors;
+
+    // Node isn't part of a frozen graph (e.g. a standalone node): walk the pointer edges
+    auto visit = [&](const Edge &edge) {
+        MapNode *endNode = (startPoint == edge.source ? edge.target : edge.source);
+        double dirX = endNode->x - startPoint->x;
+        double dirY = endNode->y - startPoint->y;
+        normalizeVector(dirX, dirY);
+        tryAddNeighbor(neighbors, startPoint, endNode, edge.length, dirX, dirY, spentCost, initialFishLocation);
+    };
+    for (const Edge &edge: startPoint->edgesIn) visit(edge);
+    for (const Edge &edge: startPoint->edgesOut) visit(edge);
 }
 
 std::pair<MapNode *, float> FishMovement::determineNextLocation(MapNode *originalLocation) {
     allReachableNeighborsInTimestep.clear();
     MapNode *point = originalLocation;
     float accumulatedCost = 0.0f;
-    std::vector<std::tuple<MapNode *, float, float> > neighbors;
-    std::vector<float> weights;
-    float currentLocationFitness = fitnessCalculator(model, *point, 0.0f);
+    std::vector<std::tuple<MapNode *, float, float> > &neighbors = movementScratch.neighbors;
+    float currentLocationFitness = fitnessAt(*point, 0.0f);
     while (true) {
         neighbors.clear();
         float remainingTime = getRemainingTime(accumulatedCost);
@@ -206,3 +270,16 @@ std::pair<MapNode *, float> FishMovement::determineNextLocation(MapNode *origina
     }
     return {point, accumulatedCost};
 }
+
+std::pair<MapNode *, float> FishMovement::determineNextLocationFor(Fish &fish, float fishSwimSpeed,
+                                                                   float fishSwimRange) {
+    swimSpeed = fishSwimSpeed;
+    swimRange = fishSwimRange;
+    // The engine outlives the call, so let go of the fish however determineNextLocation ends
+    struct FitnessSourceScope {
+        Fish *&source;
+        ~FitnessSourceScope() { source = nullptr; }
+    } fitnessSourceScope{fitnessSource};
+    fitnessSource = &fish;
+    return determineNextLocation(fish.location);
+}
@@ -5,6 +5,7 @@
 #ifndef FISHMOVEMENT_H
 #define FISHMOVEMENT_H
 
+#include <algorithm>
 #include <functional>
 
 #include "model.h"
@@ -12,6 +13,8 @@
 
 #define MOVEMENT_DEPTH_CUTOFF 0.2f
 
+class Fish;
+
 class FishMovement {
 public:
     virtual ~FishMovement() = default;
@@ -21,7 +24,7 @@ public:
         : model(model), hydroModel(&model.hydroModel), swimSpeed(swimSpeed), swimRange(swimRange),
           fitnessCalculator(fitnessCalculator) {}
 
-    std::vector<std::tuple<MapNode *, float, float> > getAllReachableNeighborsInTimestep() const {
+    const std::vector<std::tuple<MapNode *, float, float> > &getAllReachableNeighborsInTimestep() const {
         return allReachableNeighborsInTimestep;
     }
     double calculateTransitSpeed(const Edge &edge, const MapNode *startNode, double stillWaterSwimSpeed) const;
@@ -31,12 +34,24 @@ public:
                                     float spentCost, float stay_cost, float current_location_fitness) const;
     void addReachableNeighbors(std::vector<std::tuple<MapNode *, float, float> > &neighbors, MapNode *point,
                                float spentCost, MapNode *map_node);
-    virtual std::vector<std::tuple<MapNode *, float, float> > getReachableNeighbors(
+    // Convenience wrapper around appendReachableNeighbors that returns the neighbors in a new vector
+    std::vector<std::tuple<MapNode *, float, float> > getReachableNeighbors(
+        MapNode *startPoint,
+        float spentCost,
+        MapNode *initialFishLocation
+    ) const;
+    // Append the nodes reachable from startPoint (with their total cost and fitness) to out,
+    // without allocating beyond out's own growth
+    virtual void appendReachableNeighbors(
+        std::vector<std::tuple<MapNode *, float, float> > &out,
         MapNode *startPoint,
         float spentCost,
         MapNode *initialFishLocation
     ) const;
     virtual std::pair<MapNode *, float> determineNextLocation(MapNode *originalLocation);
+    // Reusable-engine entry point: run determineNextLocation from fish's location using the given swim
+    // parameters and the fish's own fitness function in place of the ones this object was built with
+    std::pair<MapNode *, float> determineNextLocationFor(Fish &fish, float fishSwimSpeed, float fishSwimRange);
 
 protected:
     Model &model;
@@ -45,7 +60,16 @@ protected:
     float swimRange;
     const std::function<float(Model &, MapNode &, float)> fitnessCalculator;
     std::vector<std::tuple<MapNode *, float, float> > allReachableNeighborsInTimestep;
+    // The fish being moved by determineNextLocationFor, if any (its getFitness replaces fitnessCalculator)
+    Fish *fitnessSource = nullptr;
 
+    // Fitness of arriving at node with the given accumulated swim cost
+    virtual float fitnessAt(MapNode &node, float cost) const;
+    // Set the fitness of candidates[first..] from their nodes and costs (batched where the fitness source allows)
+    virtual void fillFitness(std::vector<std::tuple<MapNode *, float, float> > &candidates, size_t first) const;
+    // appendReachableNeighbors without the fitness (left at 0), for callers that only need nodes and costs
+    void appendReachableNodes(std::vector<std::tuple<MapNode *, float, float> > &out, MapNode *startPoint,
+                              float spentCost, MapNode *initialFishLocation) const;
     float getRemainingTime(float spentCost) const;
     float calculateStayCost(MapNode *point, float spentCost) const;
     size_t selectNeighborIndex(const std::vector<std::tuple<MapNode *, float, float> > &neighbors) const;
@@ -53,6 +77,22 @@ protected:
 private:
     double calculateEffectiveSwimSpeed(const MapNode &startNode, const MapNode &endNode,
                                        double stillWaterSwimSpeed) const;
+    // As above, with a precomputed unit direction vector from startNode to endNode
+    double calculateEffectiveSwimSpeed(const MapNode &startNode, const MapNode &endNode,
+                                       double dirX, double dirY, double stillWaterSwimSpeed) const;
+    // Evaluate moving from startPoint to endNode along an edge of the given length, adding endNode to neighbors
+    // if it is deep enough and within swim range
+    void tryAddNeighbor(std::vector<std::tuple<MapNode *, float, float> > &neighbors, MapNode *startPoint,
+                        MapNode *endNode, float length, double dirX, double dirY, float spentCost,
+                        MapNode *initialFishLocation) const;
+    // The cost/range part of tryAddNeighbor, for an edge whose transit speed is already known
+    void addNeighborAtSpeed(std::vector<std::tuple<MapNode *, float, float> > &neighbors, MapNode *startPoint,
+                            MapNode *endNode, float length, float transitSpeed, float spentCost,
+                            MapNode *initialFishLocation) const;
+    // Swim speed over ground given the water velocity along the direction of travel (never negative)
+    static double effectiveSwimSpeed(double stillWaterSwimSpeed, double waterVelocity) {
+        return std::max(0.0, stillWaterSwimSpeed + waterVelocity);
+    }
 
     float getCurrentU(const MapNode &node) const;
     float getCurrentV(const MapNode &node) const;
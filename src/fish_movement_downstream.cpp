@@ -22,3 +22,15 @@ void FishMovementDownstream::addCurrentLocation(std::vector<std::tuple<MapNode *
                                                 [[maybe_unused]] float current_location_fitness) const {
     FishMovement::addCurrentLocation(neighbors, point, spentCost, stay_cost, fixedFitness);
 }
+
+// Downstream movement ignores fitness entirely, including that of a fish supplied per call
+float FishMovementDownstream::fitnessAt([[maybe_unused]] MapNode &node, [[maybe_unused]] float cost) const {
+    return fixedFitness;
+}
+
+void FishMovementDownstream::fillFitness(std::vector<std::tuple<MapNode *, float, float> > &candidates,
+                                         size_t first) const {
+    for (size_t i = first; i < candidates.size(); ++i) {
+        std::get<2>(candidates[i]) = fixedFitness;
+    }
+}
@@ -15,6 +15,10 @@ public:
     bool canMoveInDirectionOfEndNode(float transitSpeed, float swimSpeed) const override;
     void addCurrentLocation(std::vector<std::tuple<MapNode *, float, float> > &neighbors, MapNode * point, float spentCost, float stay_cost, float current_location_fitness) const override;
 
+protected:
+    float fitnessAt(MapNode &node, float cost) const override;
+    void fillFitness(std::vector<std::tuple<MapNode *, float, float> > &candidates, size_t first) const override;
+
 private:
     bool isTravelDirectionDownstream(float transitSpeed, float swimSpeed) const;
 
@@ -3,86 +3,206 @@
 //
 
 #include "fish_movement_high_awareness.h"
-#include <queue>
-#include <map>
-
-class MinPriorityTupleComparator {
-public:
-    bool operator()(const std::tuple<float, MapNode *> &lhs,
-                    const std::tuple<float, MapNode *> &rhs) const {
-        return std::get<0>(lhs) > std::get<0>(rhs);
-    }
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace {
+// Dial-style buckets spanning [0, swimRange]; costs never exceed the swim range, so no wrap-around is needed
+constexpr size_t COST_BUCKET_COUNT = 128;
+
+// A node waiting to be expanded at the given cost (stale entries are skipped when a cheaper cost is known)
+struct QueuedNode {
+    MapNode *node;
+    float cost;
+    uint32_t slot;
 };
 
-using DijkstraMinQueue = std::priority_queue<
-    std::tuple<float, MapNode *>,
-    std::vector<std::tuple<float, MapNode *> >,
-    MinPriorityTupleComparator
->;
+// Per-thread state reused by every walk on a thread (see MovementScratch in fish_movement.cpp).
+// Best costs live in flat arrays indexed by a node slot (the node's MapGraph index, or for nodes outside
+// the frozen graph a slot handed out per walk); a slot's cost is only valid if its stamp matches the
+// current walk's generation, so nothing has to be cleared between walks.
+struct HighAwarenessScratch {
+    std::vector<std::vector<QueuedNode> > buckets{COST_BUCKET_COUNT};
+    std::vector<float> bestCost;
+    std::vector<uint32_t> stamp;
+    uint32_t generation = 0;
+    // Nodes reached by the current walk (other than the start), in discovery order, with their slots
+    std::vector<std::pair<MapNode *, uint32_t> > reached;
+    // Slots for nodes that are not in the model's MapGraph (standalone nodes, e.g. in tests)
+    std::unordered_map<MapNode *, uint32_t> localSlots;
+    // Single-hop neighbors of the node being expanded
+    std::vector<std::tuple<MapNode *, float, float> > hop;
+    std::vector<std::tuple<MapNode *, float, float> > neighbors;
 
-std::vector<std::tuple<MapNode *, float, float> > FishMovementHighAwareness::getReachableNeighbors(MapNode *startPoint,
-    float spentCost, [[maybe_unused]] MapNode *initialFishLocation) const {
-    // Dijkstra walk to find all nodes within swim range for this timestep, regardless of how many hops away.
-    // include shortest distance (cost) for each
+    // Start a new walk over slots [0, slotCount)
+    void beginWalk(size_t slotCount) {
+        if (bestCost.size() < slotCount) {
+            bestCost.resize(slotCount);
+            stamp.resize(slotCount, 0);
+        }
+        if (++generation == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+        reached.clear();
+        localSlots.clear();
+    }
 
-    DijkstraMinQueue dijkstraMinQueue{MinPriorityTupleComparator()};
-    dijkstraMinQueue.emplace(0.0f, startPoint);
+    // Record cost for slot if it is the first or a cheaper way there; returns whether it was
+    bool improve(uint32_t slot, float cost, bool &firstVisit) {
+        firstVisit = stamp[slot] != generation;
+        if (!firstVisit && cost >= bestCost[slot]) {
+            return false;
+        }
+        stamp[slot] = generation;
+        bestCost[slot] = cost;
+        return true;
+    }
+};
 
-    std::map<MapNode *, float> minCosts;
-    minCosts[startPoint] = 0.0f;
+thread_local HighAwarenessScratch highAwarenessScratch;
+}
 
-    //struct Destination { MapNode* node; float cost; float fitness; };
-    std::vector<std::tuple<MapNode *, float, float> > candidates;
+void FishMovementHighAwareness::walkReachable(MapNode *startPoint) const {
+    // Dijkstra walk to find all nodes within swim range for this timestep, regardless of how many hops away.
+    // include shortest distance (cost) for each
+    HighAwarenessScratch &s = highAwarenessScratch;
+    const MapGraph &graph = model.mapGraph;
+    const bool inGraph = graph.indexOf(startPoint) != MapGraph::NOT_IN_GRAPH;
+    s.beginWalk(inGraph ? graph.nodeCount() : 1);
+
+    // Every node reachable from a graph node is in the graph; otherwise slots are handed out as nodes are found
+    auto slotOf = [&s, inGraph](MapNode *node) -> uint32_t {
+        if (inGraph) {
+            return (uint32_t) node->graphIndex;
+        }
+        auto [it, inserted] = s.localSlots.emplace(node, (uint32_t) s.localSlots.size());
+        if (inserted && s.bestCost.size() <= it->second) {
+            s.bestCost.push_back(0.0f);
+            s.stamp.push_back(0);
+        }
+        return it->second;
+    };
+    const float bucketWidth = swimRange > 0.0f ? swimRange / COST_BUCKET_COUNT : 1.0f;
+    auto bucketOf = [bucketWidth](float cost) {
+        return std::min(COST_BUCKET_COUNT - 1, (size_t) std::max(0.0f, std::floor(cost / bucketWidth)));
+    };
+
+    bool firstVisit;
+    const uint32_t startSlot = slotOf(startPoint);
+    s.improve(startSlot, 0.0f, firstVisit);
+    s.buckets[0].push_back({startPoint, 0.0f, startSlot});
+
+    // Buckets are drained in cost order. Within a bucket entries are not sorted, so a node may be expanded
+    // again if a cheaper way to it turns up in the same bucket; the final costs are exact shortest paths.
+    for (size_t b = 0; b < COST_BUCKET_COUNT; ++b) {
+        std::vector<QueuedNode> &bucket = s.buckets[b];
+        while (!bucket.empty()) {
+            const QueuedNode current = bucket.back();
+            bucket.pop_back();
+            // If we found a cheaper way to node already, skip
+            if (current.cost > s.bestCost[current.slot]) continue;
+
+            s.hop.clear();
+            appendReachableNodes(s.hop, current.node, current.cost, startPoint);
+            for (const auto &[nextDest, totalCost, unusedFitness]: s.hop) {
+                const uint32_t slot = slotOf(nextDest);
+                if (s.improve(slot, totalCost, firstVisit)) {
+                    if (firstVisit) {
+                        s.reached.emplace_back(nextDest, slot);
+                    }
+                    s.buckets[std::max(b, bucketOf(totalCost))].push_back({nextDest, totalCost, slot});
+                }
+            }
+        }
+    }
 
-    // 3. Dijkstra Walk
-    while (!dijkstraMinQueue.empty()) {
-        auto [currentCost, node] = dijkstraMinQueue.top();
-        dijkstraMinQueue.pop();
+}
 
-        // If we found a cheaper way to node already, skip
-        auto it = minCosts.find(node);
-        if (it != minCosts.end() && currentCost > it->second) continue;
+void FishMovementHighAwareness::appendReachableNeighbors(std::vector<std::tuple<MapNode *, float, float> > &out,
+    MapNode *startPoint, [[maybe_unused]] float spentCost, [[maybe_unused]] MapNode *initialFishLocation) const {
+    walkReachable(startPoint);
+    const HighAwarenessScratch &s = highAwarenessScratch;
 
+    // Candidates are appended to out in discovery order, then their fitness is filled in all at once
+    const size_t firstCandidate = out.size();
+    for (const auto &[node, slot]: s.reached) {
         if (node != startPoint) {
-            candidates.emplace_back(node, currentCost, 0.0);
+            out.emplace_back(node, s.bestCost[slot], 0.0f);
         }
+    }
+    fillFitness(out, firstCandidate);
+}
 
-        auto directNeighbors = FishMovement::getReachableNeighbors(node, currentCost, startPoint);
-        for (const auto &neighborTuple: directNeighbors) {
-            MapNode *nextDest = std::get<0>(neighborTuple);
-            float totalCost = std::get<1>(neighborTuple);
-
-            const auto nextCostFinder = minCosts.find(nextDest);
-            const bool isNewNode = (nextCostFinder == minCosts.end());
-            const bool isCheaperPath = (!isNewNode && totalCost < nextCostFinder->second);
-
-            if (isNewNode || isCheaperPath) {
-                minCosts[nextDest] = totalCost;
-                dijkstraMinQueue.emplace(totalCost, nextDest);
+void FishMovementHighAwareness::appendSharedReachableNeighbors(std::vector<std::tuple<MapNode *, float, float> > &out,
+                                                               MapNode *startPoint) {
+    ReachabilityCache &cache = model.getReachabilityCache();
+    const long bucket = cache.bucketOf(swimRange);
+    const std::vector<ReachableNode> *reachable = cache.find(startPoint, bucket);
+    if (reachable == nullptr) {
+        // Walk as a fish swimming the bucket's upper bound would, so the set doesn't depend on which fish
+        // in the bucket happened to compute it and holds everything the others can reach
+        const float fishSwimSpeed = swimSpeed;
+        const float fishSwimRange = swimRange;
+        swimRange = cache.representativeRange(bucket);
+        swimSpeed = fishSwimSpeed * (swimRange / fishSwimRange);
+        walkReachable(startPoint);
+        HighAwarenessScratch &s = highAwarenessScratch;
+        // The walk's first hops, to tell which distributary hops were capped
+        s.hop.clear();
+        appendReachableNodes(s.hop, startPoint, 0.0f, startPoint);
+        swimSpeed = fishSwimSpeed;
+        swimRange = fishSwimRange;
+
+        std::vector<ReachableNode> walked;
+        walked.reserve(s.reached.size());
+        for (const auto &[node, slot]: s.reached) {
+            if (node != startPoint) {
+                const bool firstHop = isDistributary(node->type)
+                                      && std::any_of(s.hop.begin(), s.hop.end(), [node = node](const auto &hop) {
+                                          return std::get<0>(hop) == node;
+                                      });
+                walked.push_back({node, s.bestCost[slot], firstHop});
             }
         }
+        reachable = cache.insert(startPoint, bucket, std::move(walked));
     }
 
-    for (auto &candidate: candidates) {
-        MapNode *node = std::get<0>(candidate);
-        float candCost = std::get<1>(candidate);
-
-        float fitness = fitnessCalculator(model, *node, candCost);
-        std::get<2>(candidate) = fitness;
+    // Rebuild this fish's own walk: its capped first hops cost at most its own range, and anything else
+    // beyond that range is out of reach
+    const size_t firstCandidate = out.size();
+    for (const ReachableNode &r: *reachable) {
+        if (r.cappedFirstHop) {
+            out.emplace_back(r.node, std::min(r.cost, swimRange), 0.0f);
+        } else if (r.cost <= swimRange) {
+            out.emplace_back(r.node, r.cost, 0.0f);
+        }
     }
-
-    return candidates;
+    fillFitness(out, firstCandidate);
 }
 
 std::pair<MapNode *, float> FishMovementHighAwareness::determineNextLocation(MapNode *originalLocation) {
+    allReachableNeighborsInTimestep.clear();
     float startingCost = 0.0f;
-    std::vector<std::tuple<MapNode *, float, float> > neighbors;
-    std::vector<float> weights;
-    float currentLocationFitness = fitnessCalculator(model, *originalLocation, startingCost);
+    auto &neighbors = highAwarenessScratch.neighbors;
+    neighbors.clear();
+    float currentLocationFitness = fitnessAt(*originalLocation, startingCost);
     float stayCost = calculateStayCost(originalLocation, startingCost);
 
     addCurrentLocation(neighbors, originalLocation, startingCost, stayCost, currentLocationFitness);
-    addReachableNeighbors(neighbors, originalLocation, startingCost, nullptr);
+    // Sets can only be shared for graph nodes (the cache key) and fish that can actually swim
+    const bool shareReachable = model.getReachabilityCache().enabled() && swimSpeed > 0.0f && swimRange > 0.0f
+                                && model.mapGraph.indexOf(originalLocation) != MapGraph::NOT_IN_GRAPH;
+    if (shareReachable) {
+        const size_t first = neighbors.size();
+        appendSharedReachableNeighbors(neighbors, originalLocation);
+        allReachableNeighborsInTimestep.insert(allReachableNeighborsInTimestep.end(),
+                                               neighbors.begin() + first, neighbors.end());
+    } else {
+        addReachableNeighbors(neighbors, originalLocation, startingCost, nullptr);
+    }
 
     MapNode *point = originalLocation;
     float cost = stayCost;
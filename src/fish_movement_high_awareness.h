@@ -13,13 +13,22 @@ public:
                                        const std::function<float(Model &, MapNode &, float)> &fitnessCalculator)
         : FishMovement(model, swimSpeed, swimRange, fitnessCalculator) {}
 
-    std::vector<std::tuple<MapNode *, float, float> > getReachableNeighbors(
+    void appendReachableNeighbors(
+        std::vector<std::tuple<MapNode *, float, float> > &out,
         MapNode *startPoint,
         float spentCost,
         MapNode *initialFishLocation
     ) const override;
 
     std::pair<MapNode *, float> determineNextLocation(MapNode *originalLocation) override;
+
+private:
+    // Find every node within swim range of startPoint; leaves them in this thread's walk scratch
+    void walkReachable(MapNode *startPoint) const;
+    // appendReachableNeighbors via the model's ReachabilityCache: the walk is done with the upper bound of
+    // this fish's swim range bucket, shared with the other fish starting from the same node in that bucket,
+    // and cut back to this fish's own range
+    void appendSharedReachableNeighbors(std::vector<std::tuple<MapNode *, float, float> > &out, MapNode *startPoint);
 };
 
 
@@ -25,6 +25,7 @@
 #include "model.h"
 #include "fish.h"
 #include "hydro.h"
+#include "spatial_index.h"
 
 wxPen infoBorderPen(wxColour(72, 72, 72));
 wxBrush infoBgBrush(wxColour(255, 255, 255, 192), wxSOLID);
@@ -279,6 +280,8 @@ public:
     float preGrabCenterY;
     MapNode *selectedNode;
     std::unordered_set<MapNode *> mapSet;
+    // For hit-testing double clicks
+    SpatialIndex nodeIndex;
     long selectedFishId;
     std::unordered_map<MapNode *, float> selectedFishRange;
     wxChoice *fishSelector;
@@ -311,7 +314,7 @@ wxEND_EVENT_TABLE()
 
 MapView::MapView(wxWindow *parent, Model *model, wxChoice *fishSelector, wxButton *tagButton, int w, int h)
     : wxPanel(parent), model(model), _buffer(nullptr),
-    isGrabbed(false), selectedNode(nullptr), selectedFishId(-1L), fishSelector(fishSelector), tagButton(tagButton)
+    isGrabbed(false), selectedNode(nullptr), nodeIndex(model->map), selectedFishId(-1L), fishSelector(fishSelector), tagButton(tagButton)
 {
     bool first = true;
     for (MapNode *n : model->map) {
@@ -585,17 +588,7 @@ void MapView::selectNode(wxMouseEvent &evt) {
     this->GetClientSize(&w, &h);
     float x = unzoom((float) evt.GetX(), this->mapCenterX, ((float) w) / 2.0f, this->viewZoom);
     float y = unzoom((float) evt.GetY(), this->mapCenterY, ((float) h) / 2.0f, -this->viewZoom);
-    this->selectedNode = nullptr;
-    float minDistance;
-    for (MapNode *n : this->model->map) {
-        float dx = n->x - x;
-        float dy = n->y - y;
-        float distance = sqrt((dx*dx) + (dy*dy));
-        if (this->selectedNode == nullptr || distance < minDistance) {
-            minDistance = distance;
-            this->selectedNode = n;
-        }
-    }
+    this->selectedNode = this->nodeIndex.nearest(x, y);
     this->updateDropdown();
     this->Refresh();
 }
@@ -215,10 +215,19 @@ int main(int argc, char **argv) {
     ss << outputPath << "/output_" << runID << ".nc";
     std::cout << "Sample data will be saved to " << ss.str() << std::endl;
 
+    std::stringstream th;
+    th << outputPath << "/taggedhist_" << runID << ".nc";
+    const bool streamTaggedHistories = m->getInt(ModelParamKey::StreamTaggedHistories) != 0;
+    if (streamTaggedHistories) {
+        std::cout << "Tagged histories will be streamed to " << th.str() << std::endl;
+        m->streamTaggedHistories(th.str());
+    }
+
     void (*prevHandler)(int);
     prevHandler = signal(SIGINT, handleInterrupt);
     double totalElapsed = 0.0;
     const long TOTAL_STEPS = 166*24;
+    const int checkpointInterval = m->getInt(ModelParamKey::CheckpointInterval);
     while (m->time < TOTAL_STEPS) {
         auto start = std::chrono::steady_clock::now();
         m->masterUpdate();
@@ -256,17 +265,20 @@ int main(int argc, char **argv) {
 #endif
             std::cout << "\rStep " << m->time << ": " << elapsed << "s elapsed; " << remainingStr << " remaining; " << m->livingIndividuals.size() << " living fish; " << m->exitedCount << " exited; " << m->deadCount << " dead" << std::endl;
             std::cout.flush();
+        }
 
-#if !defined(QUICK_DEBUG_HACK) || defined(NDEBUG)
-            // std::cout << "Writing intermediary file at step: " << m->time << std::endl;
-            // std::stringstream interruptfile;
-            // interruptfile << outputPath << "/run_" << runID <<"_step_" << m->time << ".nc";
-            // m->saveState(interruptfile.str());
-#endif
+        if (checkpointInterval > 0 && m->time % checkpointInterval == 0) {
+            std::stringstream checkpointFile;
+            checkpointFile << outputPath << "/run_" << runID << "_step_" << m->time << ".nc";
+            m->saveState(checkpointFile.str());
         }
     }
 
     std::cout << std::endl << "Finished at step " << m->time << "; " << totalElapsed << "s elapsed since start" << std::endl;
+    m->getThreadPool().printStats(std::cout);
+    if (m->getReachabilityCache().enabled()) {
+        m->getReachabilityCache().printStats(std::cout);
+    }
 
     std::stringstream ss2;
     ss2 << outputPath << "/summary_" << runID << ".nc";
@@ -275,8 +287,10 @@ int main(int argc, char **argv) {
     //std::cout << "Summary statistics saved to summary.nc" << std::endl;
     m->saveSampleData(ss.str());
 
-    std::stringstream th;
-    th << outputPath << "/taggedhist_" << runID << ".nc";
-    m->saveTaggedHistories(th.str());
+    if (streamTaggedHistories) {
+        m->finishTaggedHistoryStream();
+    } else {
+        m->saveTaggedHistories(th.str());
+    }
     delete m;
 }
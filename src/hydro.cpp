@@ -1,8 +1,13 @@
 #include "hydro.h"
 #include "load.h"
+#include "thread_pool.h"
 
 #include <cmath>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
 
 #define WSE_intercept 0.3373725
 #define WSE_flow_m3ps 0.00011386 // flow = m3/s
@@ -48,7 +53,9 @@ HydroModel::HydroModel(
     std::string airTempFilename,
     std::string flowSpeedFilename,
     std::string distribWseTempFilename,
-    int hydroTimeIntercept
+    int hydroTimeIntercept,
+    std::string hydroCacheFilename,
+    size_t loadThreadCount
 ) :
     cresTideData(loadFloatListInterleaved(cresTideFilename, 4)),
     flowVolData(loadFloatListInterleaved(flowVolFilename, 4)),
@@ -57,10 +64,39 @@ HydroModel::HydroModel(
     useSimData(false),
     hydroTimeIntercept(hydroTimeIntercept)
 {
-    loadDistribHydro(flowSpeedFilename, distribWseTempFilename, this->hydroNodes);
+    if (hydroCacheFilename.empty()) {
+        loadDistribHydro(flowSpeedFilename, distribWseTempFilename, this->hydroNodes, loadThreadCount);
+    } else {
+        this->loadThroughHydroCache(flowSpeedFilename, distribWseTempFilename, hydroCacheFilename, loadThreadCount);
+    }
     this->updateTime(0L);
 }
 
+void HydroModel::loadThroughHydroCache(std::string &flowSpeedFilename, std::string &distribWseTempFilename,
+                                       const std::string &cachePath, size_t loadThreadCount) {
+    const HydroCacheSources sources = HydroCacheSources::of(flowSpeedFilename, distribWseTempFilename);
+    try {
+        auto cache = std::make_unique<HydroCache>(cachePath);
+        if (cache->sources() == sources) {
+            std::cout << "using hydro cache " << cachePath << std::endl;
+            this->useHydroCache(std::move(cache));
+            return;
+        }
+        std::cout << "hydro cache " << cachePath << " is out of date; rebuilding it" << std::endl;
+    } catch (std::runtime_error &e) {
+        std::cout << e.what() << "; building the hydro cache" << std::endl;
+    }
+
+    loadDistribHydro(flowSpeedFilename, distribWseTempFilename, this->hydroNodes, loadThreadCount);
+    try {
+        HydroCache::write(cachePath, this->hydroNodes, sources);
+        // Swap the in-memory copy for the mapping
+        this->useHydroCache(std::make_unique<HydroCache>(cachePath));
+    } catch (std::runtime_error &e) {
+        std::cerr << e.what() << "; using the hydro data loaded into memory" << std::endl;
+    }
+}
+
 HydroModel::HydroModel(
     std::vector<MapNode *> &map,
     std::vector<std::vector<float>> &depths,
@@ -80,13 +116,94 @@ long HydroModel::getTime() const {
     return currTimestep + hydroTimeIntercept;
 }
 
+void HydroModel::useHydroCache(std::unique_ptr<HydroCache> cache) {
+    cache->loadNodes(this->hydroNodes);
+    this->hydroCache = std::move(cache);
+    this->updateTime(this->currTimestep);
+}
+
 void HydroModel::updateTime(long newTime) {
     this->currTimestep = newTime;
+    if (this->hydroCache != nullptr) {
+        const long hour = this->getTime();
+        if (hour < 0 || (size_t) hour >= this->hydroCache->timeCount()) {
+            throw std::out_of_range("Timestep " + std::to_string(hour) + " is outside the hydro data");
+        }
+        this->hourU = this->hydroCache->u(hour);
+        this->hourV = this->hydroCache->v(hour);
+        this->hourWse = this->hydroCache->wse(hour);
+        this->hourTemp = this->hydroCache->temp(hour);
+    }
     if (!this->useSimData) {
         this->currCresTide = this->cresTideData[getTime()];
         this->currFlowVol = this->flowVolData[getTime()];
         this->currAirTemp = this->airTempData[getTime()];
     }
+    this->refreshNodeEnvironment();
+}
+
+void HydroModel::attachMap(const MapGraph &graph, ThreadPool *pool) {
+    this->environmentGraph = &graph;
+    this->environmentPool = pool;
+    this->refreshNodeEnvironment();
+}
+
+void HydroModel::detachMap() {
+    this->environmentGraph = nullptr;
+    this->environmentPool = nullptr;
+    this->environmentValid = false;
+    this->nodeEnvironment.clear();
+    this->arcVelocitiesValid = false;
+    this->arcWaterVelocity.clear();
+}
+
+// Nodes per work chunk when filling the snapshot
+constexpr size_t ENVIRONMENT_CHUNK_SIZE = 512;
+
+void HydroModel::refreshNodeEnvironment() {
+    // Getters must compute from scratch while the snapshot is being rebuilt
+    this->environmentValid = false;
+    this->arcVelocitiesValid = false;
+    if (this->environmentGraph == nullptr) {
+        return;
+    }
+    const MapGraph &graph = *this->environmentGraph;
+    this->nodeEnvironment.resize(graph.nodeCount());
+    auto parallelFor = [this](size_t count, const std::function<void(size_t, size_t)> &body) {
+        if (this->environmentPool != nullptr && this->environmentPool->size() > 1) {
+            this->environmentPool->parallelFor(count, ENVIRONMENT_CHUNK_SIZE, body);
+        } else {
+            body(0, count);
+        }
+    };
+    parallelFor(graph.nodeCount(), [this, &graph](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            MapNode &node = *graph.nodes[i];
+            if (node.nearestHydroNodeID >= this->hydroNodes.size()) continue;
+            NodeEnvironment &env = this->nodeEnvironment[i];
+            env.depth = this->computeDepth(node);
+            env.temp = this->computeTemp(node);
+            env.flowSpeedScalar = this->computeFlowSpeedScalar(node);
+            env.flowVelocity = this->computeScaledFlowVelocityAt(node);
+            env.unsignedFlowSpeed = this->computeUnsignedFlowSpeedAt(node);
+        }
+    });
+    this->environmentValid = true;
+
+    // The per-arc table needs flow at both ends of every arc
+    for (const MapNode *node: graph.nodes) {
+        if (node->nearestHydroNodeID >= this->hydroNodes.size()) return;
+    }
+    this->arcWaterVelocity.resize(graph.arcTarget.size());
+    parallelFor(graph.nodeCount(), [this, &graph](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            for (uint32_t arc = graph.arcOffsets[i]; arc < graph.arcOffsets[i + 1]; ++arc) {
+                this->arcWaterVelocity[arc] = this->getWaterVelocityAlong(
+                    *graph.nodes[i], *graph.nodes[graph.arcTarget[arc]], graph.arcDirX[arc], graph.arcDirY[arc]);
+            }
+        }
+    });
+    this->arcVelocitiesValid = true;
 }
 
 bool HydroModel::isHighTide() {
@@ -117,6 +234,9 @@ float HydroModel::getCurrentU(const MapNode &node) const {
     return this->getCurrentU(this->hydroNodes[node.nearestHydroNodeID]);
 }
 float HydroModel::getCurrentU(const DistribHydroNode &hydroNode) const {
+    if (this->hourU != nullptr) {
+        return this->hourU[this->hydroIndexOf(hydroNode)];
+    }
     return hydroNode.us[this->getTime()];
 }
 
@@ -125,6 +245,9 @@ float HydroModel::getCurrentV(const MapNode &node) const {
     return this->getCurrentV(this->hydroNodes[node.nearestHydroNodeID]);
 }
 float HydroModel::getCurrentV(const DistribHydroNode &hydroNode) const {
+    if (this->hourV != nullptr) {
+        return this->hourV[this->hydroIndexOf(hydroNode)];
+    }
     return hydroNode.vs[this->getTime()];
 }
 
@@ -136,11 +259,33 @@ float HydroModel::getUnsignedFlowSpeedAtHydroNode(DistribHydroNode &hydroNode) {
 }
 
 FlowVelocity HydroModel::getScaledFlowVelocityAt(const MapNode &node) {
-    auto scalar = static_cast<float>(calculateFlowSpeedScalar(node));
+    if (const NodeEnvironment *env = this->currentEnvironment(node)) {
+        return env->flowVelocity;
+    }
+    return this->computeScaledFlowVelocityAt(node);
+}
+
+double HydroModel::getWaterVelocityAlong(const MapNode &start, const MapNode &end, double dirX, double dirY) {
+    FlowVelocity startVelocity = this->getScaledFlowVelocityAt(start);
+    FlowVelocity endVelocity = this->getScaledFlowVelocityAt(end);
+    double avgU = (static_cast<double>(startVelocity.u) + static_cast<double>(endVelocity.u)) / 2.0;
+    double avgV = (static_cast<double>(startVelocity.v) + static_cast<double>(endVelocity.v)) / 2.0;
+    return avgU * dirX + avgV * dirY;
+}
+
+FlowVelocity HydroModel::computeScaledFlowVelocityAt(const MapNode &node) {
+    auto scalar = static_cast<float>(computeFlowSpeedScalar(node));
     return {getCurrentU(node) * scalar, getCurrentV(node) * scalar};
 }
 
 double HydroModel::calculateFlowSpeedScalar(const MapNode &node) {
+    if (const NodeEnvironment *env = this->currentEnvironment(node)) {
+        return env->flowSpeedScalar;
+    }
+    return this->computeFlowSpeedScalar(node);
+}
+
+double HydroModel::computeFlowSpeedScalar(const MapNode &node) {
     if (!isBlindChannel(node.type) && !isImpoundment(node.type)) {
         return 1.0;
     }
@@ -167,6 +312,13 @@ float HydroModel::scaledFlowSpeed(const float flowSpeed, const MapNode &node) {
 
 
 float HydroModel::getUnsignedFlowSpeedAt(MapNode &node) {
+    if (const NodeEnvironment *env = this->currentEnvironment(node)) {
+        return env->unsignedFlowSpeed;
+    }
+    return this->computeUnsignedFlowSpeedAt(node);
+}
+
+float HydroModel::computeUnsignedFlowSpeedAt(MapNode &node) {
     if (this->useSimData) {
         return isDistributary(node.type) ? this->simDistFlow / (this->getDepth(node) * sqrt(node.area)) : 0.0f;
     }
@@ -189,11 +341,18 @@ float limitWaterTemp(float waterTemp, HabitatType nodeType) {
 
 // Get the current temperature (C) at the given node
 float HydroModel::getTemp(MapNode &node) {
+    if (const NodeEnvironment *env = this->currentEnvironment(node)) {
+        return env->temp;
+    }
+    return this->computeTemp(node);
+}
+
+float HydroModel::computeTemp(MapNode &node) {
     if (this->useSimData) {
         return this->simTemps[&node][this->getTime()];
     }
 
-    const float hydroTemp = this->hydroNodes[node.nearestHydroNodeID].temps[this->getTime()];
+    const float hydroTemp = this->currentHydroTemp(node.nearestHydroNodeID);
     return limitWaterTemp(hydroTemp, node.type);
 }
 
@@ -206,10 +365,17 @@ float limitDepth(const float depth, const HabitatType nodeType) {
 // Depth is hacked to be 5m in distributary midchannel, 3m at distributary edges
 // (based on blind channel model everywhere else)
 float HydroModel::getDepth(MapNode &node) {
+    if (const NodeEnvironment *env = this->currentEnvironment(node)) {
+        return env->depth;
+    }
+    return this->computeDepth(node);
+}
+
+float HydroModel::computeDepth(MapNode &node) {
     if (this->useSimData) {
         return this->simDepths[&node][this->getTime()];
     }
 
-    const float depth = this->hydroNodes[node.nearestHydroNodeID].wses[this->getTime()] - node.elev;
+    const float depth = this->currentWse(node.nearestHydroNodeID) - node.elev;
     return limitDepth(depth, node.type);
 }
\ No newline at end of file
@@ -1,9 +1,15 @@
 #ifndef __FISH_HYDRO_H
 #define __FISH_HYDRO_H
 
+#include <memory>
+#include <string>
 #include <vector>
 #include <unordered_map>
+#include "hydro_cache.h"
 #include "map.h"
+#include "map_graph.h"
+
+class ThreadPool;
 
 // This struct stores cached hydrology model predictions for a single map location
 typedef struct HydroNode {
@@ -12,6 +18,15 @@ typedef struct HydroNode {
     float flowSpeed; // flow speed in m/s
 } HydroNode;
 
+// This struct stores the hydrology at a single map location for the current timestep (see HydroModel::attachMap)
+typedef struct NodeEnvironment {
+    float depth; // meters of water, as returned by getDepth
+    float temp; // temperature in degrees C, as returned by getTemp
+    FlowVelocity flowVelocity; // as returned by getScaledFlowVelocityAt
+    float unsignedFlowSpeed; // as returned by getUnsignedFlowSpeedAt
+    double flowSpeedScalar; // as returned by calculateFlowSpeedScalar
+} NodeEnvironment;
+
 class HydroModel {
 public:
     HydroModel(
@@ -20,7 +35,11 @@ public:
         std::string airTempFilename,
         std::string flowSpeedFilename,
         std::string distribWseTempFilename,
-        int hydroTimeIntercept // Timesteps between midnight on Jan 1 and the start of the cresTide, flowVol, and airTemp data
+        int hydroTimeIntercept, // Timesteps between midnight on Jan 1 and the start of the cresTide, flowVol, and airTemp data
+        // Path of a time-major HydroCache of the distributary data (built on first use), or "" to load it into memory
+        std::string hydroCacheFilename = "",
+        // Threads used to prepare the distributary data after it is read
+        size_t loadThreadCount = 1
     );
 
     HydroModel(
@@ -38,6 +57,9 @@ public:
     float getUnsignedFlowSpeedAt(MapNode &node);
     float getUnsignedFlowSpeedAtHydroNode(DistribHydroNode &hydroNode);
     virtual FlowVelocity getScaledFlowVelocityAt(const MapNode &node);
+    // Return the component (m/s) of the mean scaled flow velocity of start and end along the
+    // unit vector (dirX, dirY), i.e. how much the water speeds up (or slows down) travel from start to end
+    double getWaterVelocityAlong(const MapNode &start, const MapNode &end, double dirX, double dirY);
 
     double calculateFlowSpeedScalar(const MapNode &node);
 
@@ -50,8 +72,24 @@ public:
     bool isHighTide();
 
     // Set the hydro model's timestep to a given timestep
+    // (and refresh the per-node snapshot, if a map is attached)
     void updateTime(long newTime);
 
+    /*
+     * Keep a dense snapshot of each graph node's environment for the current timestep,
+     * rebuilt by every updateTime call (spread over pool, if given) so that the getters above
+     * are table reads for map nodes instead of being recomputed by every fish that looks at them.
+     * The graph's nodes must not change while attached. Nodes without a hydro node
+     * (e.g. in a model built from simulated data) are left out and computed on demand as before.
+     */
+    void attachMap(const MapGraph &graph, ThreadPool *pool);
+    void detachMap();
+    // getWaterVelocityAlong for every arc of graph at the current timestep (indexed by arc),
+    // or nullptr unless graph is attached and all of its nodes have a hydro node
+    const double *getArcWaterVelocities(const MapGraph &graph) const {
+        return this->arcVelocitiesValid && &graph == this->environmentGraph ? this->arcWaterVelocity.data() : nullptr;
+    }
+
     long getTime() const;
 
 public:
@@ -69,19 +107,69 @@ public:
     // The loaded air temperature data, in degrees C
     std::vector<float> airTempData;
     // The loaded flow data, as DistribHydroNodes (see map.h)
+    // (with a hydro cache, only their positions are loaded; the hourly values stay in the mapped file)
     std::vector<DistribHydroNode> hydroNodes;
 
+    // The mapped hydro cache serving the hourly values, or nullptr if they are in hydroNodes
+    const HydroCache *getHydroCache() const { return this->hydroCache.get(); }
+    // Serve the hourly values from cache from now on, replacing hydroNodes with the cache's nodes
+    void useHydroCache(std::unique_ptr<HydroCache> cache);
+
 private:
+    // Snapshot entry for node if one is current, otherwise nullptr
+    const NodeEnvironment *currentEnvironment(const MapNode &node) const {
+        if (!this->environmentValid) return nullptr;
+        const int index = this->environmentGraph->indexOf(&node);
+        if (index == MapGraph::NOT_IN_GRAPH || node.nearestHydroNodeID >= this->hydroNodes.size()) return nullptr;
+        return &this->nodeEnvironment[index];
+    }
+    void refreshNodeEnvironment();
+    // Load the distributary data through the cache at cachePath, (re)building it from the NetCDF files if needed
+    void loadThroughHydroCache(std::string &flowSpeedFilename, std::string &distribWseTempFilename,
+                               const std::string &cachePath, size_t loadThreadCount);
+    // Position of hydroNode in hydroNodes
+    size_t hydroIndexOf(const DistribHydroNode &hydroNode) const { return &hydroNode - this->hydroNodes.data(); }
+    // The current hour's water surface elevation and temperature at hydro node index i
+    float currentWse(size_t i) const {
+        return this->hourWse != nullptr ? this->hourWse[i] : this->hydroNodes[i].wses[this->getTime()];
+    }
+    float currentHydroTemp(size_t i) const {
+        return this->hourTemp != nullptr ? this->hourTemp[i] : this->hydroNodes[i].temps[this->getTime()];
+    }
+
+    // Uncached versions of the getters above
+    float computeUnsignedFlowSpeedAt(MapNode &node);
+    FlowVelocity computeScaledFlowVelocityAt(const MapNode &node);
+    double computeFlowSpeedScalar(const MapNode &node);
+    float computeTemp(MapNode &node);
+    float computeDepth(MapNode &node);
+
+    const MapGraph *environmentGraph = nullptr;
+    ThreadPool *environmentPool = nullptr;
+    // Indexed by graph index
+    std::vector<NodeEnvironment> nodeEnvironment;
+    bool environmentValid = false;
+    // Indexed by arc index
+    std::vector<double> arcWaterVelocity;
+    bool arcVelocitiesValid = false;
+
     bool useSimData;
     std::unordered_map<MapNode *, std::vector<float>> simDepths;
     std::unordered_map<MapNode *, std::vector<float>> simTemps;
     float simDistFlow;
 
+    std::unique_ptr<HydroCache> hydroCache;
+    // The current hour's records in hydroCache (nullptr without a cache)
+    const float *hourU = nullptr;
+    const float *hourV = nullptr;
+    const float *hourWse = nullptr;
+    const float *hourTemp = nullptr;
+
     int hydroTimeIntercept;
     float currCresTide;
     float currFlowVol;
     float currAirTemp;
-    long currTimestep;
+    long currTimestep = 0;
 
 };
 
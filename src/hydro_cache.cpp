@@ -0,0 +1,177 @@
+#include "hydro_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char HYDRO_CACHE_MAGIC[8] = {'S', 'K', 'H', 'Y', 'D', 'R', 'O', '\0'};
+constexpr uint32_t HYDRO_CACHE_VERSION = 1;
+// Hour records start on a boundary at least as coarse as any common page size
+constexpr uint64_t HOUR_RECORD_ALIGNMENT = 16384;
+
+struct HydroCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nodeCount;
+    uint64_t timeCount;
+    HydroCacheSources sources;
+    uint64_t hourRecordOffset;
+};
+
+struct HydroCacheNode {
+    uint32_t id;
+    float x;
+    float y;
+    float minWse;
+};
+
+uint64_t hourRecordOffsetFor(size_t nodeCount) {
+    const uint64_t nodeRecordsEnd = sizeof(HydroCacheHeader) + nodeCount * sizeof(HydroCacheNode);
+    return (nodeRecordsEnd + HOUR_RECORD_ALIGNMENT - 1) / HOUR_RECORD_ALIGNMENT * HOUR_RECORD_ALIGNMENT;
+}
+
+void statFile(const std::string &path, uint64_t &size, uint64_t &modified) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        throw std::runtime_error("Could not stat hydro source file " + path);
+    }
+    size = (uint64_t) st.st_size;
+    modified = (uint64_t) st.st_mtime;
+}
+}
+
+HydroCacheSources HydroCacheSources::of(const std::string &flowPath, const std::string &wseTempPath) {
+    HydroCacheSources sources{};
+    statFile(flowPath, sources.flowSize, sources.flowModified);
+    statFile(wseTempPath, sources.wseTempSize, sources.wseTempModified);
+    return sources;
+}
+
+bool HydroCacheSources::operator==(const HydroCacheSources &other) const {
+    return this->flowSize == other.flowSize && this->flowModified == other.flowModified
+           && this->wseTempSize == other.wseTempSize && this->wseTempModified == other.wseTempModified;
+}
+
+HydroCache::HydroCache(const std::string &path)
+    : mapping(MAP_FAILED), mappingSize(0), nodes(0), hours(0), hourRecords(nullptr) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open hydro cache " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(HydroCacheHeader)) {
+        close(fd);
+        throw std::runtime_error("Not a hydro cache: " + path);
+    }
+    this->mappingSize = (size_t) st.st_size;
+    this->mapping = mmap(nullptr, this->mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps the file alive
+    close(fd);
+    if (this->mapping == MAP_FAILED) {
+        throw std::runtime_error("Could not map hydro cache " + path);
+    }
+
+    const auto *header = static_cast<const HydroCacheHeader *>(this->mapping);
+    const uint64_t expectedSize = hourRecordOffsetFor(header->nodeCount)
+                                  + header->timeCount * 4 * header->nodeCount * sizeof(float);
+    if (std::memcmp(header->magic, HYDRO_CACHE_MAGIC, sizeof(HYDRO_CACHE_MAGIC)) != 0
+        || header->version != HYDRO_CACHE_VERSION
+        || header->hourRecordOffset != hourRecordOffsetFor(header->nodeCount)
+        || expectedSize != this->mappingSize) {
+        munmap(this->mapping, this->mappingSize);
+        throw std::runtime_error("Not a hydro cache (or from another version): " + path);
+    }
+    this->nodes = header->nodeCount;
+    this->hours = header->timeCount;
+    this->hourRecords = reinterpret_cast<const float *>(static_cast<const char *>(this->mapping)
+                                                        + header->hourRecordOffset);
+    // A run reads the hours in order, mostly once each
+    madvise(const_cast<float *>(this->hourRecords),
+            this->mappingSize - header->hourRecordOffset, MADV_SEQUENTIAL);
+}
+
+HydroCache::~HydroCache() {
+    munmap(this->mapping, this->mappingSize);
+}
+
+void HydroCache::write(const std::string &path, const std::vector<DistribHydroNode> &nodes,
+                       const HydroCacheSources &sources) {
+    const size_t nodeCount = nodes.size();
+    const size_t timeCount = nodes.empty() ? 0 : nodes[0].us.size();
+    for (const DistribHydroNode &node: nodes) {
+        if (node.us.size() != timeCount || node.vs.size() != timeCount
+            || node.wses.size() != timeCount || node.temps.size() != timeCount) {
+            throw std::runtime_error("Hydro nodes have different numbers of hours; cannot write a cache");
+        }
+    }
+
+    const std::string tempPath = path + ".tmp" + std::to_string(getpid());
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not create hydro cache " + tempPath);
+    }
+    HydroCacheHeader header{};
+    std::memcpy(header.magic, HYDRO_CACHE_MAGIC, sizeof(HYDRO_CACHE_MAGIC));
+    header.version = HYDRO_CACHE_VERSION;
+    header.nodeCount = (uint32_t) nodeCount;
+    header.timeCount = timeCount;
+    header.sources = sources;
+    header.hourRecordOffset = hourRecordOffsetFor(nodeCount);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for (const DistribHydroNode &node: nodes) {
+        HydroCacheNode record{node.id, node.x, node.y, node.minWse};
+        out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    }
+    const std::vector<char> padding(header.hourRecordOffset - (uint64_t) out.tellp(), 0);
+    out.write(padding.data(), (std::streamsize) padding.size());
+
+    // Transpose one hour at a time
+    std::vector<float> hour(4 * nodeCount);
+    for (size_t t = 0; t < timeCount; ++t) {
+        for (size_t i = 0; i < nodeCount; ++i) {
+            hour[i] = nodes[i].us[t];
+            hour[nodeCount + i] = nodes[i].vs[t];
+            hour[2 * nodeCount + i] = nodes[i].wses[t];
+            hour[3 * nodeCount + i] = nodes[i].temps[t];
+        }
+        out.write(reinterpret_cast<const char *>(hour.data()), (std::streamsize) (hour.size() * sizeof(float)));
+    }
+    out.close();
+    if (!out || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        throw std::runtime_error("Could not write hydro cache " + path);
+    }
+}
+
+const HydroCacheSources &HydroCache::sources() const {
+    return static_cast<const HydroCacheHeader *>(this->mapping)->sources;
+}
+
+size_t HydroCache::nodeCount() const {
+    return this->nodes;
+}
+
+size_t HydroCache::timeCount() const {
+    return this->hours;
+}
+
+void HydroCache::loadNodes(std::vector<DistribHydroNode> &nodesOut) const {
+    const auto *records = reinterpret_cast<const HydroCacheNode *>(static_cast<const char *>(this->mapping)
+                                                                   + sizeof(HydroCacheHeader));
+    nodesOut.clear();
+    nodesOut.reserve(this->nodes);
+    for (size_t i = 0; i < this->nodes; ++i) {
+        nodesOut.emplace_back(records[i].id);
+        DistribHydroNode &node = nodesOut.back();
+        node.x = records[i].x;
+        node.y = records[i].y;
+        node.minWse = records[i].minWse;
+    }
+}
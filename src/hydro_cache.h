@@ -0,0 +1,75 @@
+#ifndef HYDRO_CACHE_H
+#define HYDRO_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "map.h"
+
+// Identifies the NetCDF files a hydro cache was built from (sizes and modification times),
+// so that a cache is rebuilt when either of them changes
+struct HydroCacheSources {
+    uint64_t flowSize;
+    uint64_t flowModified;
+    uint64_t wseTempSize;
+    uint64_t wseTempModified;
+
+    // Stat the two source files; throws std::runtime_error if either is missing
+    static HydroCacheSources of(const std::string &flowPath, const std::string &wseTempPath);
+    bool operator==(const HydroCacheSources &other) const;
+};
+
+/*
+ * A binary, time-major copy of the distributary hydrology read by loadDistribHydro,
+ * memory-mapped read-only.
+ *
+ * The NetCDF files are node-major (each hydro node's whole year is contiguous), while the model
+ * reads one hour at every node each timestep. The cache stores one record per hour instead, so a
+ * timestep touches four contiguous arrays. Mapping the file makes startup nearly instant, only the
+ * hours that are actually simulated get paged in, and concurrent runs share the same pages.
+ *
+ * File layout (native byte order and float format; the cache is not meant to be moved between machines):
+ *   header (magic, version, node and hour counts, HydroCacheSources, offset of the hour records)
+ *   nodeCount node records: id, x, y, minimum WSE over all hours
+ *   padding to a page boundary
+ *   timeCount hour records, each: u[nodeCount], v[nodeCount], wse[nodeCount], temp[nodeCount]
+ */
+class HydroCache {
+public:
+    // Map the cache at path; throws std::runtime_error if it cannot be opened or is not a hydro cache
+    explicit HydroCache(const std::string &path);
+    ~HydroCache();
+
+    HydroCache(const HydroCache &) = delete;
+    HydroCache &operator=(const HydroCache &) = delete;
+
+    // Write nodes (whose hourly vectors must all have the same length) to a cache at path.
+    // The file is written under a temporary name and renamed into place, so runs sharing a cache
+    // never see a partial file. Throws std::runtime_error if it cannot be written.
+    static void write(const std::string &path, const std::vector<DistribHydroNode> &nodes,
+                      const HydroCacheSources &sources);
+
+    const HydroCacheSources &sources() const;
+    size_t nodeCount() const;
+    size_t timeCount() const;
+    // Replace nodesOut with the cached nodes' ids, positions and minimum WSEs (their hourly vectors are left empty)
+    void loadNodes(std::vector<DistribHydroNode> &nodesOut) const;
+
+    // The values at every hydro node for hour t (indexed like HydroModel::hydroNodes)
+    const float *u(size_t t) const { return this->hour(t); }
+    const float *v(size_t t) const { return this->hour(t) + this->nodes; }
+    const float *wse(size_t t) const { return this->hour(t) + 2 * this->nodes; }
+    const float *temp(size_t t) const { return this->hour(t) + 3 * this->nodes; }
+
+private:
+    void *mapping;
+    size_t mappingSize;
+    size_t nodes;
+    size_t hours;
+    const float *hourRecords;
+
+    const float *hour(size_t t) const { return this->hourRecords + t * 4 * this->nodes; }
+};
+
+#endif
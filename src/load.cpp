@@ -18,6 +18,8 @@
 #include "load_utils.h"
 #include "hydro.h"
 #include "model_config_map.h"
+#include "spatial_index.h"
+#include "thread_pool.h"
 
 // calculate distance between <x1, y1> and <x2, y2>
 inline float distance(float x1, float y1, float x2, float y2) {
@@ -26,12 +28,31 @@ inline float distance(float x1, float y1, float x2, float y2) {
     return sqrt(dx*dx + dy*dy);
 }
 
+// Floats per variable read by one hyperslab call in loadDistribHydro (all hours of a block of nodes)
+constexpr size_t HYDRO_BLOCK_FLOATS = 4 * 1024 * 1024;
+// Nodes per work chunk when transposing and repairing hydro data
+constexpr size_t HYDRO_NODE_CHUNK_SIZE = 16;
+
+// Nodes per hyperslab read of var (dimensions time, node): as many as fit in HYDRO_BLOCK_FLOATS,
+// rounded down to whole chunks along the node dimension if the variable is chunked
+size_t hydroNodeBlockSize(const netCDF::NcVar &var, size_t timeCount) {
+    size_t block = std::max<size_t>(1, HYDRO_BLOCK_FLOATS / std::max<size_t>(1, timeCount));
+    netCDF::NcVar::ChunkMode chunkMode;
+    std::vector<size_t> chunkSizes;
+    var.getChunkingParameters(chunkMode, chunkSizes);
+    if (chunkMode == netCDF::NcVar::nc_CHUNKED && chunkSizes.size() == 2 && chunkSizes[1] > 0) {
+        block = std::max(chunkSizes[1], block / chunkSizes[1] * chunkSizes[1]);
+    }
+    return block;
+}
+
 // Load the distributary hydrology data from two NetCDF files
 // the "nodesOut" argument is an output
 // After this method is called, it will contain a list of
 // "DistribHydroNode" objects, each of which has a 2d position and a list of hourly flow vectors,
 // water surface elevations, and water temperatures
-void loadDistribHydro(std::string &flowPath, std::string &wseTempPath, std::vector<DistribHydroNode> &nodesOut) {
+void loadDistribHydro(std::string &flowPath, std::string &wseTempPath, std::vector<DistribHydroNode> &nodesOut,
+                      size_t threadCount) {
     netCDF::NcFile flowSourceFile(flowPath, netCDF::NcFile::FileMode::read);
     netCDF::NcFile wseTempSourceFile(wseTempPath, netCDF::NcFile::FileMode::read);
     size_t nodeCount = flowSourceFile.getDim("node").getSize();
@@ -42,49 +63,102 @@ void loadDistribHydro(std::string &flowPath, std::string &wseTempPath, std::vect
     netCDF::NcVar v = flowSourceFile.getVar("v");
     netCDF::NcVar wse = wseTempSourceFile.getVar("wse");
     netCDF::NcVar temp = wseTempSourceFile.getVar("temp");
-    // Create each node
+    // The NetCDF library is only called from this thread, so read the fill values for the repair up front
+    const FillModeSnapshot xFill{NetCDFVarFillAdapter(x)};
+    const FillModeSnapshot yFill{NetCDFVarFillAdapter(y)};
+    const FillModeSnapshot uFill{NetCDFVarFillAdapter(u)};
+    const FillModeSnapshot vFill{NetCDFVarFillAdapter(v)};
+    const FillModeSnapshot wseFill{NetCDFVarFillAdapter(wse)};
+    const FillModeSnapshot tempFill{NetCDFVarFillAdapter(temp)};
+    ThreadPool pool(std::max<size_t>(1, threadCount));
     std::cout << std::endl;
-    std::vector<std::string> error_log;
 
+    // Create each node
+    std::vector<DistribHydroNode> nodes;
+    nodes.reserve(nodeCount);
+    std::vector<float> xs(nodeCount);
+    std::vector<float> ys(nodeCount);
+    if (nodeCount > 0) {
+        x.getVar(xs.data());
+        y.getVar(ys.data());
+    }
     for (size_t i = 0; i < nodeCount; ++i) {
-        std::cout << "\rloading distributary hydrology data: " << (i+1) << "/" << nodeCount;
+        nodes.emplace_back(i);
+        nodes.back().x = xs[i];
+        nodes.back().y = ys[i];
+    }
+
+    // Read all hours of a block of nodes per call, then transpose each block into the nodes' hourly vectors
+    const size_t block = std::min(nodeCount, hydroNodeBlockSize(u, timeCount));
+    std::vector<float> uBlock(block * timeCount);
+    std::vector<float> vBlock(block * timeCount);
+    std::vector<float> wseBlock(block * timeCount);
+    std::vector<float> tempBlock(block * timeCount);
+    for (size_t first = 0; first < nodeCount; first += block) {
+        const size_t count = std::min(block, nodeCount - first);
+        std::cout << "\rloading distributary hydrology data: " << (first + count) << "/" << nodeCount;
         std::cout.flush();
-        nodesOut.emplace_back(i);
-        try {
-            DistribHydroNode &node = nodesOut.back();
-            std::vector<size_t> coordIndex{i};
-            x.getVar(coordIndex, &node.x);
-            y.getVar(coordIndex, &node.y);
-            validate_required_value(NetCDFVarFillAdapter(x), node.x, "Unrecoverable error: missing geo 'x' for hydro node: " + std::to_string(i+1));
-            validate_required_value(NetCDFVarFillAdapter(y), node.y, "Unrecoverable error: missing geo 'y' for hydro node: " + std::to_string(i+1));
-
-            // These vectors are passed as indices to getVar to retrieve the NetCDF data
-            std::vector<size_t> flowIndex{0, i};
-            std::vector<size_t> flowCounts{timeCount, 1};
-            // resize the lists' memory footprint ahead of time to fit the right number of timesteps
-            node.us.resize(timeCount);
-            node.vs.resize(timeCount);
-            node.wses.resize(timeCount);
-            node.temps.resize(timeCount);
-            // Retrieve the data from the NetCDF file, store it in the node's flow component lists
-            u.getVar(flowIndex, flowCounts, node.us.data());
-            v.getVar(flowIndex, flowCounts, node.vs.data());
-            wse.getVar(flowIndex, flowCounts, node.wses.data());
-            temp.getVar(flowIndex, flowCounts, node.temps.data());
-
-            fix_all_missing_values(timeCount, NetCDFVarFillAdapter(u), node.us, "u (hydro u velocity), node: " + std::to_string(i+1), &error_log);
-            fix_all_missing_values(timeCount, NetCDFVarFillAdapter(v), node.vs, "v (hydro v velocity), node: " + std::to_string(i+1), &error_log);
-            fix_all_missing_values(timeCount, NetCDFVarFillAdapter(wse), node.wses, "wse (water surface elevation), node: " + std::to_string(i+1), &error_log);
-            fix_all_missing_values(timeCount, NetCDFVarFillAdapter(temp), node.temps, "temp (hydro temperature), node: " + std::to_string(i+1), &error_log);
-        } catch (CustomExceptionWithMessage &e) {
-            std::cout << std::endl;
-            std::cout << "ERROR! " << e.what() << "; skipping hydro node " << i+1 << "..." << std::endl;
-            std::cout << "Please fix this error in " << flowPath << " or " << wseTempPath << std::endl << std::endl;
+        const std::vector<size_t> start{0, first};
+        const std::vector<size_t> counts{timeCount, count};
+        u.getVar(start, counts, uBlock.data());
+        v.getVar(start, counts, vBlock.data());
+        wse.getVar(start, counts, wseBlock.data());
+        temp.getVar(start, counts, tempBlock.data());
+        pool.parallelFor(count, HYDRO_NODE_CHUNK_SIZE, [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; ++j) {
+                DistribHydroNode &node = nodes[first + j];
+                node.us.resize(timeCount);
+                node.vs.resize(timeCount);
+                node.wses.resize(timeCount);
+                node.temps.resize(timeCount);
+            }
+            // Hour by hour, so each hour's values for the chunk are read from one cache line
+            for (size_t t = 0; t < timeCount; ++t) {
+                for (size_t j = begin; j < end; ++j) {
+                    DistribHydroNode &node = nodes[first + j];
+                    node.us[t] = uBlock[t * count + j];
+                    node.vs[t] = vBlock[t * count + j];
+                    node.wses[t] = wseBlock[t * count + j];
+                    node.temps[t] = tempBlock[t * count + j];
+                }
+            }
+        });
+    }
+    std::cout << std::endl;
+
+    // Repair missing values across nodes in parallel; failures and warnings are reported in node order below
+    std::vector<std::string> failures(nodeCount);
+    std::vector<std::vector<std::string>> warnings(nodeCount);
+    pool.parallelFor(nodeCount, HYDRO_NODE_CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            DistribHydroNode &node = nodes[i];
+            std::vector<std::string> *error_log = &warnings[i];
+            try {
+                validate_required_value(xFill, node.x, "Unrecoverable error: missing geo 'x' for hydro node: " + std::to_string(i+1));
+                validate_required_value(yFill, node.y, "Unrecoverable error: missing geo 'y' for hydro node: " + std::to_string(i+1));
+                fix_all_missing_values(timeCount, uFill, node.us, "u (hydro u velocity), node: " + std::to_string(i+1), error_log);
+                fix_all_missing_values(timeCount, vFill, node.vs, "v (hydro v velocity), node: " + std::to_string(i+1), error_log);
+                fix_all_missing_values(timeCount, wseFill, node.wses, "wse (water surface elevation), node: " + std::to_string(i+1), error_log);
+                fix_all_missing_values(timeCount, tempFill, node.temps, "temp (hydro temperature), node: " + std::to_string(i+1), error_log);
+                node.minWse = timeCount > 0 ? *std::min_element(node.wses.begin(), node.wses.end()) : node.minWse;
+            } catch (CustomExceptionWithMessage &e) {
+                failures[i] = e.what();
+            }
+        }
+    });
 
-            nodesOut.pop_back();
+    std::vector<std::string> error_log;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        // A skipped node's warnings from before it failed are still reported
+        error_log.insert(error_log.end(), warnings[i].begin(), warnings[i].end());
+        if (!failures[i].empty()) {
+            std::cout << "ERROR! " << failures[i] << "; skipping hydro node " << i+1 << "..." << std::endl;
+            std::cout << "Please fix this error in " << flowPath << " or " << wseTempPath << std::endl << std::endl;
+            continue;
         }
+        nodesOut.push_back(std::move(nodes[i]));
     }
-    std::cout << std::endl << "done loading hydro" << std::endl;
+    std::cout << "done loading hydro" << std::endl;
     if (error_log.size() > 0) {
         std::cout << "WARNINGS occurred while reading hydro data. Please fix:" << std::endl;
         for (const std::string &error : error_log) {
@@ -100,19 +174,13 @@ void assignHydroNodeToMapNodeWithDistance(const unsigned hydroNodeIndex, MapNode
 }
 
 void initializeEachHydroNodeToNearestMapNode(const std::vector<MapNode *> & map, const std::vector<DistribHydroNode> & hydroNodes, std::unordered_set<MapNode*>& assignedNodes) {
+    const SpatialIndex candidates(map, isDistributaryOrNearshore);
+    if (candidates.empty()) {
+        return;
+    }
     for (unsigned hydroNodeIndex = 0; hydroNodeIndex < hydroNodes.size(); ++hydroNodeIndex) {
-        MapNode* closestNode = nullptr;
-        float closestDistance = std::numeric_limits<float>::max();
-        for (MapNode *node : map) {
-            if (!isDistributaryOrNearshore(node->type)) {
-                continue;;
-            }
-            const float nodeDistance = distance(hydroNodes[hydroNodeIndex].x, hydroNodes[hydroNodeIndex].y, node->x, node->y);
-            if (nodeDistance < closestDistance) {
-                closestDistance = nodeDistance;
-                closestNode = node;
-            }
-        }
+        float closestDistance;
+        MapNode *closestNode = candidates.nearest(hydroNodes[hydroNodeIndex].x, hydroNodes[hydroNodeIndex].y, closestDistance);
         if (closestDistance < closestNode->hydroNodeDistance) {
             assignHydroNodeToMapNodeWithDistance(hydroNodeIndex, closestNode, closestNode->hydroNodeDistance);
             assignedNodes.emplace(closestNode);
@@ -215,11 +283,9 @@ void fixElevations(std::vector<MapNode *> &map, std::vector<DistribHydroNode> &h
     float minDistribDepth = cutoffDepth;
     for (MapNode *node : map) {
         if (isDistributary(node->type)) {
-            for (float wse : hydroNodes[node->nearestHydroNodeID].wses) {
-                float depth = wse - node->elev;
-                if (depth < minDistribDepth) {
-                    minDistribDepth = depth;
-                }
+            float depth = hydroNodes[node->nearestHydroNodeID].minWse - node->elev;
+            if (depth < minDistribDepth) {
+                minDistribDepth = depth;
             }
         }
     }
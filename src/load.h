@@ -13,7 +13,9 @@ std::vector<std::string> split(std::string& s, char c);
 
 // Loads distributary hydrology data from two NetCDF3/4 files into a vector of DistribHydroNodes (defined in map.h)
 // See CONFIG_README for a description of the file formats
-void loadDistribHydro(std::string &flowPath, std::string &wseTempPath, std::vector<DistribHydroNode> &nodesOut);
+// (the data is read in large blocks of nodes; transposing and repairing missing values use up to threadCount threads)
+void loadDistribHydro(std::string &flowPath, std::string &wseTempPath, std::vector<DistribHydroNode> &nodesOut,
+                      size_t threadCount = 1);
 
 // Loads recruit size distributions from a CSV file into a 2d float vector
 // See CONFIG_README for a description of the file format
@@ -32,6 +34,9 @@ std::vector<float> loadFloatListInterleaved(std::string &filePath, int n);
 
 void checkAndAddEdge(Edge e);
 
+// Human-readable name of a habitat type (e.g. "Blind channel")
+std::string getHabitatTypeName(HabitatType t);
+
 // Loads a list of sampling sites from a CSV file into a vector of SamplingSites (defined in map.h)
 //void loadSamplingSites(std::string &filePath, std::vector<MapNode *> &map, std::vector<SamplingSite> &out);
 
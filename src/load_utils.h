@@ -27,6 +27,24 @@ private:
     const netCDF::NcVar &ncVar_;
 };
 
+// The fill mode parameters of another source, read once up front
+// (so that missing values can be repaired on worker threads without calling into the NetCDF library)
+class FillModeSnapshot : public NcVarFillModeInterface {
+public:
+    explicit FillModeSnapshot(const NcVarFillModeInterface &source) {
+        source.getFillModeParameters(fillActive_, &fillValue_);
+    }
+
+    void getFillModeParameters(bool &fillActive, float *fillValue) const override {
+        fillActive = fillActive_;
+        *fillValue = fillValue_;
+    }
+
+private:
+    bool fillActive_;
+    float fillValue_;
+};
+
 bool fix_missing_value(float &cell, float &last_good_value, float missing_indicator);
 void validate_required_value(const NcVarFillModeInterface &ncVar, float actual_value, std::string exception_msg);
 float find_first_non_missing_value(const std::vector<float> &values, float missing_indicator);
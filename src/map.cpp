@@ -51,7 +51,7 @@ MapNode::MapNode(HabitatType type, float area, float elev, float pathDist)
         : id(-1), type(type), area(area), elev(elev), pathDist(pathDist),
         crossChannelA(nullptr), crossChannelB(nullptr),
         nearestHydroNodeID(std::numeric_limits<unsigned>::max()), hydroNodeDistance(std::numeric_limits<float>::max()),
-        popDensity(0.0f)
+        popDensity(0.0f), graphIndex(-1), mapIndex(-1)
 {}
 
 SamplingSite::SamplingSite(std::string siteName, size_t id) : siteName(siteName), id(id), points() {}
@@ -1,6 +1,8 @@
 #ifndef __FISH_MAP_H
 #define __FISH_MAP_H
 
+#include <cstddef>
+#include <limits>
 #include <vector>
 #include <string>
 
@@ -14,7 +16,8 @@ typedef struct DistribHydroNode {
     std::vector<float> vs; // vertical component of the flow speed vector (m/s), in 1hr increments starting from midnight on Jan 1
     std::vector<float> wses; // Water surface elevation (NAVD88) (m) in 1hr increments starting from midnight on Jan 1
     std::vector<float> temps; // Water temperature (c) in 1hr increments starting from midnight on Jan 1
-    DistribHydroNode(unsigned id) : id(id), us(), vs(), wses(), temps() {}
+    float minWse; // Lowest of wses (kept when the hourly data lives in a HydroCache instead)
+    DistribHydroNode(unsigned id) : id(id), us(), vs(), wses(), temps(), minWse(std::numeric_limits<float>::max()) {}
 } DistribHydroNode;
 
 typedef struct FlowVelocity {
@@ -63,6 +66,26 @@ public:
     Edge(MapNode *source, MapNode *target, float length);
 };
 
+// Read-only view of the Fish::id values of the living fish at one location.
+// The ids live in one flat array owned by the Model (see Model::countAll), in living-list order.
+class ResidentIds {
+public:
+    const long *begin() const { return first; }
+    const long *end() const { return first + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    long operator[](size_t i) const { return first[i]; }
+    void assign(const long *ids, size_t n) {
+        first = ids;
+        count = n;
+    }
+    void clear() { assign(nullptr, 0); }
+
+private:
+    const long *first = nullptr;
+    size_t count = 0;
+};
+
 class MapNode {
 public:
     // ID (index in the map node list)
@@ -89,13 +112,17 @@ public:
     unsigned nearestHydroNodeID;
     float hydroNodeDistance;
     // List of Fish::id of living fish such that Fish::location == this -- updated in Model::countAll
-    std::vector<long> residentIds;
+    ResidentIds residentIds;
     // Population density of living fish at this location, in individuals/m^2 -- updated in Model::countAll
     float popDensity;
     // Median fish mass at this location (g) -- updated in Model::countAll
     float medMass;
     // Maximum fish mass at this location (g) -- updated in Model::countAll
     float maxMass;
+    // Index of this node in the model's frozen MapGraph (-1 until the graph is built)
+    int graphIndex;
+    // Index of this node in Model::map as of the last Model::countAll (-1 before that)
+    int mapIndex;
 
     MapNode(HabitatType type, float area, float elev, float pathDist);
 };
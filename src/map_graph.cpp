@@ -0,0 +1,74 @@
+#include "map_graph.h"
+
+#include <cmath>
+#include <stdexcept>
+
+void MapGraph::clear() {
+    for (MapNode *node: this->nodes) {
+        node->graphIndex = NOT_IN_GRAPH;
+    }
+    this->nodes.clear();
+    this->type.clear();
+    this->x.clear();
+    this->y.clear();
+    this->arcOffsets.clear();
+    this->arcTarget.clear();
+    this->arcLength.clear();
+    this->arcDirX.clear();
+    this->arcDirY.clear();
+}
+
+void MapGraph::build(const std::vector<MapNode *> &map) {
+    this->clear();
+    const size_t n = map.size();
+    this->nodes = map;
+    this->type.reserve(n);
+    this->x.reserve(n);
+    this->y.reserve(n);
+    size_t arcCount = 0;
+    for (size_t i = 0; i < n; ++i) {
+        MapNode *node = map[i];
+        node->graphIndex = (int) i;
+        this->type.push_back(node->type);
+        this->x.push_back(node->x);
+        this->y.push_back(node->y);
+        arcCount += node->edgesIn.size() + node->edgesOut.size();
+    }
+
+    this->arcOffsets.reserve(n + 1);
+    this->arcTarget.reserve(arcCount);
+    this->arcLength.reserve(arcCount);
+    this->arcDirX.reserve(arcCount);
+    this->arcDirY.reserve(arcCount);
+
+    auto addArc = [this](const MapNode *start, const MapNode *end, float length) {
+        int endIndex = this->indexOf(end);
+        if (endIndex == NOT_IN_GRAPH) {
+            throw std::runtime_error("MapGraph::build: edge leads to a node that is not in the map");
+        }
+        // Same arithmetic as FishMovement's on-the-fly direction (float difference, double normalization)
+        double dirX = end->x - start->x;
+        double dirY = end->y - start->y;
+        double magnitude = std::sqrt(dirX * dirX + dirY * dirY);
+        if (magnitude > 0) {
+            dirX /= magnitude;
+            dirY /= magnitude;
+        }
+        this->arcTarget.push_back((uint32_t) endIndex);
+        this->arcLength.push_back(length);
+        this->arcDirX.push_back(dirX);
+        this->arcDirY.push_back(dirY);
+    };
+
+    for (size_t i = 0; i < n; ++i) {
+        const MapNode *node = map[i];
+        this->arcOffsets.push_back((uint32_t) this->arcTarget.size());
+        for (const Edge &edge: node->edgesIn) {
+            addArc(node, edge.source == node ? edge.target : edge.source, edge.length);
+        }
+        for (const Edge &edge: node->edgesOut) {
+            addArc(node, edge.source == node ? edge.target : edge.source, edge.length);
+        }
+    }
+    this->arcOffsets.push_back((uint32_t) this->arcTarget.size());
+}
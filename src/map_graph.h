@@ -0,0 +1,55 @@
+#ifndef MAP_GRAPH_H
+#define MAP_GRAPH_H
+
+#include <cstdint>
+#include <vector>
+#include "map.h"
+
+/*
+ * Frozen, index-based adjacency for the map in compressed sparse row (CSR) form.
+ *
+ * The pointer graph (MapNode::edgesIn/edgesOut) is what loadMap mutates while it merges,
+ * prunes and repairs nodes. Once loading is finished, build() packs it into flat arrays,
+ * and from then on the movement code walks these arrays instead of chasing Edge pointers.
+ *
+ * Arcs are undirected traversals: each Edge is visible from both of its endpoints.
+ * For node i, arcs [arcOffsets[i], arcOffsets[i + 1]) list the edgesIn of the node first,
+ * then its edgesOut, which is the same order FishMovement used to visit them.
+ */
+class MapGraph {
+public:
+    static constexpr int NOT_IN_GRAPH = -1;
+
+    // Pack the adjacency of the given nodes; sets MapNode::graphIndex on each of them
+    void build(const std::vector<MapNode *> &map);
+    void clear();
+    bool empty() const { return this->nodes.empty(); }
+    size_t nodeCount() const { return this->nodes.size(); }
+
+    // Index of node in this graph, or NOT_IN_GRAPH (e.g. standalone test nodes, or nodes of another map)
+    int indexOf(const MapNode *node) const {
+        int index = node->graphIndex;
+        if (index < 0 || (size_t) index >= this->nodes.size() || this->nodes[index] != node) {
+            return NOT_IN_GRAPH;
+        }
+        return index;
+    }
+
+    // Node attributes (SoA, indexed by graph index)
+    std::vector<MapNode *> nodes;
+    std::vector<HabitatType> type;
+    std::vector<float> x;
+    std::vector<float> y;
+
+    // Arcs (indexed by arc index)
+    std::vector<uint32_t> arcOffsets;
+    // graph index of the node at the far end of the arc
+    std::vector<uint32_t> arcTarget;
+    // edge length (m)
+    std::vector<float> arcLength;
+    // unit vector pointing from the arc's start node to its far end
+    std::vector<double> arcDirX;
+    std::vector<double> arcDirY;
+};
+
+#endif
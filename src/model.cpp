@@ -3,9 +3,14 @@
 #include <thread>
 #include <algorithm>
 #include "util.h"
+#include "sampling.h"
 #include "load.h"
 #include "map_gen.h"
+#include "nc_output.h"
+#include "tagged_history_stream.h"
 #include "env_sim.h"
+#include "fish_movement.h"
+#include "fish_movement_factory.h"
 #include <cstdio>
 #include <fstream>
 #include <rapidjson/document.h>
@@ -67,9 +72,12 @@ Model::Model(
     std::string flowSpeedFilename,
     // Path of the distributary WSE/temp data (netCDF)
     std::string distribWseTempFilename,
+    // Path of the time-major binary cache of the distributary data, or "" to read the netCDF files into memory
+    std::string hydroCacheFilename,
     const ModelConfigMap &config
 ) : defaultHydroModel(std::make_unique<HydroModel>(cresTideFilename, flowVolFilename, airTempFilename,
-                                                   flowSpeedFilename, distribWseTempFilename, hydroTimeIntercept)),
+                                                   flowSpeedFilename, distribWseTempFilename, hydroTimeIntercept,
+                                                   hydroCacheFilename, maxThreads)),
     hydroModel(*defaultHydroModel),
     recTimeIntercept(recTimeIntercept),
     globalTimeIntercept(globalTimeIntercept),
@@ -82,8 +90,9 @@ Model::Model(
     habitatTypeExitConditionHours(habitatTypeExitConditionHours),
     nextFishID(0UL),
     maxThreads(maxThreads),
-    recruitTagRate(0.5f),
-    configMap(config) {
+    threadPool(std::make_unique<ThreadPool>(maxThreads)),
+    configMap(config),
+    params(configMap) {
     if (getInt(ModelParamKey::DirectionlessEdges)) std::cout << "directionless edges!" << std::endl;
 
     // Load the map
@@ -101,6 +110,10 @@ Model::Model(
         blindChannelSimplificationRadius,
         configMap
     );
+    // The map won't be mutated from here on; pack it for fast traversal
+    this->mapGraph.build(this->map);
+    // ...and let the hydro model snapshot per-node conditions over it each timestep
+    this->hydroModel.attachMap(this->mapGraph, this->threadPool.get());
     for (size_t i = 0; i < this->monitoringPoints.size(); ++i) {
         this->monitoringHistory.emplace_back();
     }
@@ -110,6 +123,8 @@ Model::Model(
     loadRecSizeDists(recSizeDistsFilename, this->recSizeDists);
     // Make room in the recruit plan vector (per-timestep recruit counts for the current day)
     this->recDayPlan.resize(24, 0UL);
+    this->tagSampler.configure(TagSelection::fromConfig(this->configMap));
+    this->resolveMovementStrategy();
 }
 
 // Load model components from simulated data (map & environmental conditions)
@@ -137,11 +152,16 @@ Model::Model(
     mortConstA(MORT_CONST_A),
     mortConstC(MORT_CONST_C),
     habitatTypeExitConditionHours(DEFAULT_EXIT_CONDITION_HOURS),
+    params(configMap),
     nextFishID(0UL),
     maxThreads(maxThreads),
-    recruitTagRate(0.5f) {
+    threadPool(std::make_unique<ThreadPool>(maxThreads)) {
+    this->mapGraph.build(this->map);
+    this->hydroModel.attachMap(this->mapGraph, this->threadPool.get());
     // Make room in the recruit plan vector (per-timestep recruit counts for the current day)
     this->recDayPlan.resize(24, 0UL);
+    this->tagSampler.configure(TagSelection::fromConfig(this->configMap));
+    this->resolveMovementStrategy();
 }
 
 Model::Model(HydroModel *hydroModel)
@@ -156,9 +176,13 @@ Model::Model(HydroModel *hydroModel)
       mortConstA(MORT_CONST_A),
       mortConstC(MORT_CONST_C),
       habitatTypeExitConditionHours(DEFAULT_EXIT_CONDITION_HOURS),
+      params(configMap),
       nextFishID(0UL),
       maxThreads(1),
-      recruitTagRate(0.5f) {}
+      threadPool(std::make_unique<ThreadPool>(maxThreads)) {
+    this->tagSampler.configure(TagSelection::fromConfig(this->configMap));
+    this->resolveMovementStrategy();
+}
 
 void Model::masterUpdate() {
     if (this->time % 24 == 0) {
@@ -188,12 +212,11 @@ void Model::update1h() {
     // We aren't recalculating density between recruitment and movement since we want to turn a blind eye
     // to the recruit entry node bottleneck (by letting them move before counting, we pretend they don't bunch up)
     this->moveAll();
-    // Calculate density, size distributions for each node to provide info needed for consumption/mortality calculations
-    // The "false" here means the sampling trackers won't be updated (to avoid double-counting fish)
-    this->countAll(false);
+    // Update density for each node whose residents changed, to provide info needed for consumption/mortality calculations
+    this->applyResidencyChanges(false);
     this->growAndDieAll();
-    // Recalculate densities to reflect mortality, this time with sampling tracking enabled
-    this->countAll(true);
+    // Update densities to reflect mortality, and the size ranks that growth changed everywhere
+    this->applyResidencyChanges(true);
     // Add an entry to the population history
     this->populationHistory.push_back(this->livingIndividuals.size());
     // Record monitoring sites
@@ -202,6 +225,13 @@ void Model::update1h() {
         MapNode *n = this->monitoringPoints[i];
         this->monitoringHistory[i].emplace_back(n->residentIds.size(), n->popDensity, hydroModel.getDepth(*n), hydroModel.getTemp(*n));
     }
+    if (this->taggedHistoryStream != nullptr) {
+        this->streamFinishedHistories();
+    }
+    this->enforceTagBudget();
+#ifndef NDEBUG
+    this->population.verifyMirrors(this->individuals);
+#endif
 }
 
 // TODO: longer timestep, move based on current state, explore discretely? <-- think about this more
@@ -222,51 +252,56 @@ void moveThread(
     FishIdIter end
 ) {
     for (auto it = start; it != end; ++it) {
-        model->individuals[*it].move(*model);
+        Fish &fish = model->individuals[*it];
+        fish.move(*model);
+        model->population.store(fish);
+        model->recordResidencyChange(fish.id);
     }
 }
 
 
-// Handles launching of movement threads
+// Work is handed out in chunks of at least this many fish; smaller chunks cost more in scheduling than they save
+constexpr size_t MIN_FISH_PER_CHUNK = 32;
+// Target number of chunks per thread, so that threads finishing early have something left to steal
+constexpr size_t CHUNKS_PER_THREAD = 16;
+
+// Pick a chunk size for spreading numFish across numThreads threads
+static size_t fishChunkSize(size_t numFish, size_t numThreads) {
+    return std::max(MIN_FISH_PER_CHUNK, numFish / (std::max((size_t) 1, numThreads) * CHUNKS_PER_THREAD));
+}
+
+// Runs fn over the living fish list in small chunks on the model's thread pool (with work stealing between threads)
+static void runOnLivingBatches(
+    std::vector<size_t> &livingIndividuals,
+    size_t maxThreads,
+    ThreadPool &threadPool,
+    void (*fn)(Model *, FishIdIter, FishIdIter),
+    Model *model
+) {
+    size_t chunkSize = fishChunkSize(livingIndividuals.size(), std::min(maxThreads, threadPool.size()));
+    auto base = livingIndividuals.begin();
+    threadPool.parallelFor(livingIndividuals.size(), chunkSize, [&](size_t begin, size_t end) {
+        fn(model, base + begin, base + end);
+    });
+}
+
+// Handles dispatching movement work to the thread pool
 void Model::moveAll() {
-    // Each thread should handle at minimum 4096 fish
-    unsigned threadBatchSize = std::max(4096U, (unsigned) (this->livingIndividuals.size() / this->maxThreads));
-    // Figure out how many threads to launch based on the calculated per-thread fish count
-    unsigned numThreads = std::max(1U, (unsigned) (this->livingIndividuals.size() / threadBatchSize));
-    // Allocate storage for thread datastructures
-    std::thread *threads = new std::thread[numThreads];
-    // Iterator for the beginning of the living fish list
-    auto start = this->livingIndividuals.begin();
-    size_t remaining = this->livingIndividuals.size();
-
-    for (unsigned i = 0; i < numThreads; ++i) {
-        size_t batch = remaining / (numThreads - i); // How many fish are left to be processed
-        remaining -= batch;
-        // Iterator for the end of the current batch of fish to be processed
-        auto end = start + batch;
-        // Launch a thread
-        threads[i] = std::thread(moveThread, this, start, end);
-        // Shift the start point for the next batch to just past this batch's end
-        start = end;
-    }
-    // Wait for all threads to finish running
-    for (unsigned i = 0; i < numThreads; ++i) {
-        threads[i].join();
-    }
-    // Free the thread storage (it was allocated on the heap)
-    delete[] threads;
+    this->residencyChanges.resize(this->threadPool->size());
+    this->reachabilityCache.clear();
+    runOnLivingBatches(this->livingIndividuals, this->maxThreads, *this->threadPool, moveThread, this);
 
     // Re-pack the living fish into the first part of the living fish list
 
     // Tracker for where to put living fish in the list (start at the start)
     auto targetIt = this->livingIndividuals.begin();
     for (auto sourceIt = this->livingIndividuals.begin(); sourceIt != this->livingIndividuals.end(); ++sourceIt) {
-        Fish &f = this->individuals[*sourceIt];
+        const FishStatus status = this->population.status[*sourceIt];
         // If a fish is alive, move it to the target tracker, then shift the target position over 1
-        if (f.status == FishStatus::Alive) {
+        if (status == FishStatus::Alive) {
             *targetIt = *sourceIt;
             ++targetIt;
-        } else if (f.status == FishStatus::Exited) {
+        } else if (status == FishStatus::Exited) {
             ++this->exitedCount;
         }
     }
@@ -283,50 +318,29 @@ void growAndDieThread(
     FishIdIter end
 ) {
     for (auto it = start; it != end; ++it) {
-        model->individuals[*it].growAndDie(*model);
+        Fish &fish = model->individuals[*it];
+        fish.growAndDie(*model);
+        model->population.store(fish);
+        model->recordResidencyChange(fish.id);
     }
 }
 
-// Handles launching of growth+death threads
+// Handles dispatching growth+death work to the thread pool
 void Model::growAndDieAll() {
-    // Each thread should handle at minimum 4096 fish
-    unsigned threadBatchSize = std::max(4096U, (unsigned) (this->livingIndividuals.size() / this->maxThreads));
-    // Figure out how many threads to launch based on the calculated per-thread fish count
-    unsigned numThreads = std::max(1U, (unsigned) (this->livingIndividuals.size() / threadBatchSize));
-    // Allocate storage for thread datastructures
-    std::thread *threads = new std::thread[numThreads];
-    // Iterator for the beginning of the living fish list
-    auto start = this->livingIndividuals.begin();
-    size_t remaining = this->livingIndividuals.size();
-
-    for (unsigned i = 0; i < numThreads; ++i) {
-        size_t batch = remaining / (numThreads - i); // How many fish are left to be processed
-        remaining -= batch;
-        // Iterator for the end of the current batch of fish to be processed
-        auto end = start + batch;
-        // Launch a thread
-        threads[i] = std::thread(growAndDieThread, this, start, end);
-        // Shift the start point for the next batch to just past this batch's end
-        start = end;
-    }
-    // Wait for all threads to finish
-    for (unsigned i = 0; i < numThreads; ++i) {
-        threads[i].join();
-    }
-    // Free thread storage
-    delete[] threads;
+    this->residencyChanges.resize(this->threadPool->size());
+    runOnLivingBatches(this->livingIndividuals, this->maxThreads, *this->threadPool, growAndDieThread, this);
 
     // Re-pack the living fish into the first part of the living fish list, remove dead fish
 
     // Tracker for where to put living fish in the list (start at the start)
     auto targetIt = this->livingIndividuals.begin();
     for (auto sourceIt = this->livingIndividuals.begin(); sourceIt != this->livingIndividuals.end(); ++sourceIt) {
-        Fish &f = this->individuals[*sourceIt];
+        const FishStatus status = this->population.status[*sourceIt];
         // If a fish is alive, move it to the target tracker, then shift the target position over 1
-        if (f.status == FishStatus::Alive) {
+        if (status == FishStatus::Alive) {
             *targetIt = *sourceIt;
             ++targetIt;
-        } else if (f.status == FishStatus::Exited) {
+        } else if (status == FishStatus::Exited) {
             ++this->exitedCount;
         } else {
             ++this->deadCount;
@@ -348,56 +362,277 @@ struct FishSortDummy {
     }
 };
 
+// Map nodes are handed out to threads in chunks of this many
+constexpr size_t NODE_CHUNK_SIZE = 1024;
+
+// Room left after a node's count residents in residentOrder, for fish arriving before the next full recount
+size_t residentSpare(size_t count) {
+    return count / 4 + 4;
+}
+
+namespace {
+// Per-thread sort buffers for the rank pass in countAll (reused across nodes and timesteps)
+struct RankScratch {
+    std::vector<FishSortDummy> masses;
+    std::vector<FishSortDummy> arrivalTimes;
+};
+
+thread_local RankScratch rankScratch;
+}
+
+size_t Model::mapSlotOf(const MapNode *location) const {
+    const size_t n = (size_t) location->mapIndex;
+    return n < this->map.size() && this->map[n] == location ? n : this->map.size();
+}
+
+void Model::refreshNodeResidency(size_t n, bool refreshRanks) {
+    MapNode *node = this->map[n];
+    node->residentIds.assign(this->residentOrder.data() + this->residentOffsets[n], this->residentCounts[n]);
+    const ResidentIds &residents = node->residentIds;
+    // Calculate population density (pop/area)
+    node->popDensity = ((float) residents.size()) / node->area;
+    if (!refreshRanks) {
+        return;
+    }
+    node->maxMass = 0.0f;
+    if (residents.empty()) {
+        return;
+    }
+    Population &pop = this->population;
+    RankScratch &scratch = rankScratch;
+    scratch.masses.clear();
+    scratch.arrivalTimes.clear();
+    // Make a list of node's resident masses
+    for (long id: residents) {
+        node->maxMass = std::max(node->maxMass, pop.mass[id]);
+        scratch.masses.emplace_back(id, pop.mass[id]);
+        scratch.arrivalTimes.emplace_back(id, pop.travel[id]);
+    }
+    // Set the median to the nth-largest element of the mass list, where n is half the length of the list
+    std::sort(scratch.masses.begin(), scratch.masses.end());
+    std::sort(scratch.arrivalTimes.begin(), scratch.arrivalTimes.end());
+    const size_t count = residents.size();
+    for (size_t i = 0; i < count; ++i) {
+        pop.massRank[scratch.masses[i].id] = i;
+        pop.arrivalTimeRank[scratch.arrivalTimes[i].id] = count - i - 1;
+    }
+}
+
 // Calculate per-node population and median mass
+// Living fish are binned by location with a counting sort: each slice of the living list counts its fish
+// per node, the counts are turned into write positions, and each slice then scatters its ids into
+// residentOrder. Every node's range comes out in living-list order, whatever the number of threads, and is
+// followed by some spare room so that applyResidencyChanges can add arrivals in place.
+// This is the full recount; between full counts update1h maintains residency with applyResidencyChanges.
 void Model::countAll(bool updateTracking) {
-    // Reset node tracker values
-    for (MapNode *node: this->map) {
-        node->residentIds.clear();
-        node->maxMass = 0.0f;
+    ThreadPool &pool = *this->threadPool;
+    Population &pop = this->population;
+    const size_t nodeCount = this->map.size();
+    const size_t livingCount = this->livingIndividuals.size();
+    const size_t slices = std::max((size_t) 1, std::min(pool.size(), livingCount / MIN_FISH_PER_CHUNK));
+    const size_t sliceSize = (livingCount + slices - 1) / slices;
+
+    this->residentOffsets.assign(nodeCount + 1, 0);
+    this->residentCounts.assign(nodeCount, 0);
+    this->residentBins.assign(slices * nodeCount, 0);
+    this->nodeChanged.assign(nodeCount, 0);
+    for (std::vector<ResidencyChange> &changes: this->residencyChanges) {
+        changes.clear();
     }
-    // Place each fish in the trackers for its node
-    for (long i: this->livingIndividuals) {
-        Fish &f = this->individuals[i];
-        f.location->residentIds.push_back(i);
-        f.location->maxMass = std::max(f.location->maxMass, f.mass);
+    std::fill(pop.residence.begin(), pop.residence.end(), nullptr);
+    pool.parallelFor(nodeCount, NODE_CHUNK_SIZE, [this](size_t begin, size_t end) {
+        for (size_t n = begin; n < end; ++n) {
+            this->map[n]->mapIndex = (int) n;
+        }
+    });
+
+    // Count each slice's fish per node (fish at a location outside the map, possible in hand-built
+    // test models, are not binned)
+    pool.run(slices, [&](size_t slice) {
+        size_t *counts = this->residentBins.data() + slice * nodeCount;
+        const size_t end = std::min(livingCount, (slice + 1) * sliceSize);
+        for (size_t i = slice * sliceSize; i < end; ++i) {
+            const size_t n = this->mapSlotOf(pop.location[this->livingIndividuals[i]]);
+            if (n < nodeCount) {
+                ++counts[n];
+            }
+        }
+    });
+    pool.parallelFor(nodeCount, NODE_CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (size_t n = begin; n < end; ++n) {
+            size_t total = 0;
+            for (size_t slice = 0; slice < slices; ++slice) {
+                total += this->residentBins[slice * nodeCount + n];
+            }
+            this->residentCounts[n] = total;
+            this->residentOffsets[n + 1] = total + residentSpare(total);
+        }
+    });
+    for (size_t n = 0; n < nodeCount; ++n) {
+        this->residentOffsets[n + 1] += this->residentOffsets[n];
     }
-    std::vector<FishSortDummy> residentMasses;
-    std::vector<FishSortDummy> residentArrivalTimes;
-    for (MapNode *node: this->map) {
-        // Calculate population density (pop/area)
-        node->popDensity = ((float) node->residentIds.size()) / node->area;
-        // Calculate median mass
-        if (node->residentIds.size() > 0) {
-            residentMasses.clear();
-            residentArrivalTimes.clear();
-            // Make a list of node's resident masses
-            for (long id: node->residentIds) {
-                residentMasses.emplace_back(id, this->individuals[id].mass);
-                residentArrivalTimes.emplace_back(id, this->individuals[id].travel);
+    this->residentOrder.resize(this->residentOffsets[nodeCount]);
+    // Turn the counts into each slice's first write position within each node's range
+    pool.parallelFor(nodeCount, NODE_CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (size_t n = begin; n < end; ++n) {
+            size_t position = this->residentOffsets[n];
+            for (size_t slice = 0; slice < slices; ++slice) {
+                const size_t count = this->residentBins[slice * nodeCount + n];
+                this->residentBins[slice * nodeCount + n] = position;
+                position += count;
+            }
+        }
+    });
+    pool.run(slices, [&](size_t slice) {
+        size_t *positions = this->residentBins.data() + slice * nodeCount;
+        const size_t end = std::min(livingCount, (slice + 1) * sliceSize);
+        for (size_t i = slice * sliceSize; i < end; ++i) {
+            const size_t id = this->livingIndividuals[i];
+            const size_t n = this->mapSlotOf(pop.location[id]);
+            if (n < nodeCount) {
+                pop.residentSlot[id] = positions[n];
+                this->residentOrder[positions[n]++] = (long) id;
+                pop.residence[id] = pop.location[id];
+            }
+        }
+    });
+
+    // Per-node statistics and ranks
+    pool.parallelFor(nodeCount, NODE_CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (size_t n = begin; n < end; ++n) {
+            this->refreshNodeResidency(n, true);
+        }
+    });
+}
+
+void Model::recordResidencyChange(size_t id) {
+    const Population &pop = this->population;
+    if (id >= pop.size()) {
+        return;
+    }
+    MapNode *from = pop.residence[id];
+    MapNode *to = pop.status[id] == FishStatus::Alive ? pop.location[id] : nullptr;
+    if (from != to) {
+        this->residencyChanges[ThreadPool::currentParticipant()].push_back({id, from, to});
+    }
+}
+
+void Model::applyResidencyChanges(bool refreshRanks) {
+    const size_t nodeCount = this->map.size();
+    if (this->residentCounts.size() != nodeCount) {
+        // Nothing has been counted against this map yet
+        this->countAll(refreshRanks);
+        return;
+    }
+    Population &pop = this->population;
+    auto touch = [this](size_t n) {
+        if (!this->nodeChanged[n]) {
+            this->nodeChanged[n] = 1;
+            this->changedNodes.push_back(n);
+        }
+    };
+    this->changedNodes.clear();
+    // A departing fish's slot is filled with the last id in its node's range, and an arrival is appended to
+    // the range (a node with no spare room left means a full recount, which lays out fresh spare room)
+    for (std::vector<ResidencyChange> &changes: this->residencyChanges) {
+        for (const ResidencyChange &change: changes) {
+            const size_t from = change.from ? this->mapSlotOf(change.from) : nodeCount;
+            const size_t to = change.to ? this->mapSlotOf(change.to) : nodeCount;
+            if (to < nodeCount
+                && this->residentOffsets[to] + this->residentCounts[to] == this->residentOffsets[to + 1]) {
+                this->countAll(refreshRanks);
+                return;
             }
-            // Set the median to the nth-largest element of the mass list, where n is half the length of the list
-            std::sort(residentMasses.begin(), residentMasses.end());
-            std::sort(residentArrivalTimes.begin(), residentArrivalTimes.end());
-            for (size_t i = 0; i < residentMasses.size(); ++i) {
-                this->individuals[residentMasses[i].id].massRank = i;
-                this->individuals[residentArrivalTimes[i].id].arrivalTimeRank = residentMasses.size() - i - 1;
+            if (from < nodeCount) {
+                const size_t slot = pop.residentSlot[change.id];
+                const long last = this->residentOrder[this->residentOffsets[from] + --this->residentCounts[from]];
+                this->residentOrder[slot] = last;
+                pop.residentSlot[last] = slot;
+                touch(from);
+            }
+            if (to < nodeCount) {
+                const size_t slot = this->residentOffsets[to] + this->residentCounts[to]++;
+                this->residentOrder[slot] = (long) change.id;
+                pop.residentSlot[change.id] = slot;
+                touch(to);
+            }
+            pop.residence[change.id] = to < nodeCount ? change.to : nullptr;
+        }
+        changes.clear();
+    }
+
+    // Re-sort the changed ranges into ascending id order, which is living-list order
+    ThreadPool &pool = *this->threadPool;
+    pool.parallelFor(this->changedNodes.size(), NODE_CHUNK_SIZE, [this, &pop, refreshRanks](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const size_t n = this->changedNodes[i];
+            long *first = this->residentOrder.data() + this->residentOffsets[n];
+            long *last = first + this->residentCounts[n];
+            std::sort(first, last);
+            for (long *it = first; it != last; ++it) {
+                pop.residentSlot[*it] = this->residentOffsets[n] + (size_t) (it - first);
+            }
+            if (!refreshRanks) {
+                this->refreshNodeResidency(n, false);
             }
         }
+    });
+    if (refreshRanks) {
+        pool.parallelFor(nodeCount, NODE_CHUNK_SIZE, [this](size_t begin, size_t end) {
+            for (size_t n = begin; n < end; ++n) {
+                this->refreshNodeResidency(n, true);
+            }
+        });
+    }
+    for (size_t n: this->changedNodes) {
+        this->nodeChanged[n] = 0;
     }
+#ifndef NDEBUG
+    this->verifyResidency();
+#endif
 }
 
-// Generates a single recruit and adds it to a random recruit start node
-void Model::recruitSingle() {
-    // Get the current slice of the recruit size distribution data
+void Model::verifyResidency() const {
+    const size_t nodeCount = this->map.size();
+    std::vector<std::vector<long>> expected(nodeCount);
+    for (size_t id: this->livingIndividuals) {
+        const size_t n = this->mapSlotOf(this->population.location[id]);
+        if (n < nodeCount) {
+            expected[n].push_back((long) id);
+        }
+    }
+    for (size_t n = 0; n < nodeCount; ++n) {
+        const MapNode *node = this->map[n];
+        std::vector<long> actual(node->residentIds.begin(), node->residentIds.end());
+        std::sort(actual.begin(), actual.end());
+        std::sort(expected[n].begin(), expected[n].end());
+        if (actual != expected[n] || node->popDensity != ((float) expected[n].size()) / node->area) {
+            throw std::logic_error("Residency of map node " + std::to_string(n) + " does not match a full recount ("
+                                   + std::to_string(actual.size()) + " tracked, "
+                                   + std::to_string(expected[n].size()) + " counted)");
+        }
+    }
+}
+
+// The recruit size distribution for the current week
+const std::vector<float> &Model::currentRecruitSizeDist() const {
     constexpr unsigned TIMESTEPS_IN_DAY = 24;
     constexpr unsigned DAYS_IN_WEEK = 7;
     constexpr unsigned TIMESTEPS_IN_WEEK = TIMESTEPS_IN_DAY * DAYS_IN_WEEK;
     const size_t recruitWeek = (this->time + this->recTimeIntercept) / (TIMESTEPS_IN_WEEK);
     const size_t recruitWeekIndex = std::min(recruitWeek, this->recSizeDists.size() - 1);
-    std::vector<float> &recSizeDist = this->recSizeDists[recruitWeekIndex];
+    return this->recSizeDists[recruitWeekIndex];
+}
 
+// Generates a single recruit and adds it to a random recruit start node
+void Model::recruitSingle() {
+    const std::vector<float> &recSizeDist = this->currentRecruitSizeDist();
     // Sample the fork length bucket index from the distribution
-    unsigned flIdx = sample(recSizeDist.data(), recSizeDist.size());
+    this->addRecruit(sampleWeighted(recSizeDist.data(), recSizeDist.size()));
+}
+
+// Adds a recruit from the given fork length bucket at a random recruit start node
+void Model::addRecruit(size_t flIdx) {
     // Calculate the fork length from the bucket index
     float forkLength = 35.0f + 5.0f * flIdx + unit_rand() * 5.0f;
     // Construct a fish and place it in the *ALL* fish list
@@ -411,7 +646,8 @@ void Model::recruitSingle() {
     );
     // this->addHistoryBuffers();
     const size_t last_id = this->individuals.back().id;
-    this->tagIndividual(last_id);
+    this->population.add(this->individuals.back());
+    this->tagRecruit(last_id);
     // Place the new fish's ID in the living fish list
     this->livingIndividuals.push_back(last_id);
 }
@@ -420,9 +656,16 @@ void Model::recruitSingle() {
 void Model::recruit() {
     // Get the current timestep's recruit count from the day's recruit "plan"
     size_t currRecCount = this->recDayPlan[this->time % 24];
+    if (currRecCount == 0) {
+        return;
+    }
+    // Draw all of their fork length buckets from the week's distribution at once
+    const std::vector<float> &recSizeDist = this->currentRecruitSizeDist();
+    this->recruitSizeBuckets.resize(currRecCount);
+    sampleWeightedBatch(recSizeDist.data(), recSizeDist.size(), currRecCount, this->recruitSizeBuckets.data());
     // Recruit that many fish
     for (size_t i = 0; i < currRecCount; ++i) {
-        this->recruitSingle();
+        this->addRecruit(this->recruitSizeBuckets[i]);
     }
 }
 
@@ -453,9 +696,9 @@ void Model::sampling() {
         // (difference is in how sampling nodes are assigned)
         for (MapNode *point: site->points) {
             for (long id: point->residentIds) {
-                totalMass += this->individuals[id].mass;
-                totalLength += this->individuals[id].forkLength;
-                totalSpawnTime += this->individuals[id].spawnTime;
+                totalMass += this->population.mass[id];
+                totalLength += this->population.forkLength[id];
+                totalSpawnTime += this->population.spawnTime[id];
             }
             totalPop += point->residentIds.size();
         }
@@ -491,172 +734,135 @@ void Model::reset() {
     this->time = 0L;
     this->hydroModel.updateTime(this->time);
     this->individuals.clear();
+    this->population.clear();
     this->livingIndividuals.clear();
     this->deadCount = 0;
     this->exitedCount = 0;
     this->populationHistory.clear();
     this->sampleHistory.clear();
+    this->streamingFish.clear();
+    this->tagSampler.clear();
     this->countAll(false);
 }
 
+namespace {
+// Upper bound on the values per variable that loadTaggedHistories reads at once
+constexpr size_t HISTORY_BLOCK_VALUES = 1 << 20;
+
+// Read the first count values of var (all of a variable of that size) in one call
+template<typename T>
+std::vector<T> readVar(const netCDF::NcVar &var, size_t count) {
+    std::vector<T> values(count);
+    if (count > 0) {
+        var.getVar(values.data());
+    }
+    return values;
+}
+
+// Read values [first, first + count) of a 1d variable into out
+template<typename T>
+void readRange(const netCDF::NcVar &var, size_t first, size_t count, std::vector<T> &out) {
+    out.resize(count);
+    if (count > 0) {
+        var.getVar(std::vector<size_t>{first}, std::vector<size_t>{count}, out.data());
+    }
+}
+
+// Read rows [firstRow, firstRow + rowCount) of a 2d variable with rowLength columns into out
+template<typename T>
+void readRows(const netCDF::NcVar &var, size_t firstRow, size_t rowCount, size_t rowLength, std::vector<T> &out) {
+    out.resize(rowCount * rowLength);
+    if (out.empty()) {
+        return;
+    }
+    const std::vector<size_t> start{firstRow, 0};
+    const std::vector<size_t> count{rowCount, rowLength};
+    var.getVar(start, count, out.data());
+}
+
+// Write the sample history variables shared by saveState and saveSampleData
+void putSampleHistory(NcOutputWriter &out, const std::vector<Sample> &samples,
+                      const std::vector<netCDF::NcDim> &dims) {
+    const size_t count = samples.size();
+    out.putEach<int>("sampleSiteID", dims, count, [&samples](size_t i) { return samples[i].siteID; });
+    out.putEach<int>("sampleTime", dims, count, [&samples](size_t i) { return samples[i].time; });
+    out.putEach<int>("samplePop", dims, count, [&samples](size_t i) { return samples[i].population; });
+    out.putEach<float>("sampleMeanMass", dims, count, [&samples](size_t i) { return samples[i].meanMass; });
+    out.putEach<float>("sampleMeanLength", dims, count, [&samples](size_t i) { return samples[i].meanLength; });
+    out.putEach<float>("sampleMeanSpawnTime", dims, count, [&samples](size_t i) { return samples[i].meanSpawnTime; });
+}
+
+// Write the monitoring point variables shared by saveState and saveSummary
+// (dims are (monitoring point, hour))
+void putMonitoringHistory(NcOutputWriter &out, const std::vector<MapNode *> &points,
+                          const std::vector<std::vector<MonitoringRecord>> &history,
+                          const std::vector<netCDF::NcDim> &dims) {
+    const size_t hours = dims[1].getSize();
+    const size_t count = points.size() * hours;
+    auto recordAt = [&history, hours](size_t i) -> const MonitoringRecord & {
+        return history[i / hours][i % hours];
+    };
+    out.putEach<int>("monitoringPopulation", dims, count, [&](size_t i) { return recordAt(i).population; });
+    out.putEach<float>("monitoringPopulationDensity", dims, count, [&](size_t i) { return recordAt(i).populationDensity; });
+    out.putEach<float>("monitoringDepth", dims, count, [&](size_t i) { return recordAt(i).depth; });
+    out.putEach<float>("monitoringTemp", dims, count, [&](size_t i) { return recordAt(i).temp; });
+    out.putEach<int>("monitoringPointIDs", std::vector<netCDF::NcDim>{dims[0]}, points.size(),
+                     [&points](size_t i) { return points[i]->id; });
+}
+}
+
 // Save model state to a given filename
 void Model::saveState(std::string savePath) {
-    netCDF::NcFile targetFile(savePath, netCDF::NcFile::FileMode::replace);
+    NcOutputWriter out(savePath);
     size_t N = this->individuals.size();
     // Add dimensions
     std::vector<netCDF::NcDim> noDims;
-    netCDF::NcDim populationHistoryLength = targetFile.
-            addDim("populationHistoryLength", this->populationHistory.size());
+    netCDF::NcDim populationHistoryLength = out.addDim("populationHistoryLength", this->populationHistory.size());
     std::vector<netCDF::NcDim> populationHistoryDims;
     populationHistoryDims.push_back(populationHistoryLength);
-    netCDF::NcDim sampleHistoryLength = targetFile.addDim("sampleHistoryLength", this->sampleHistory.size());
+    netCDF::NcDim sampleHistoryLength = out.addDim("sampleHistoryLength", this->sampleHistory.size());
     std::vector<netCDF::NcDim> sampleHistoryDims;
     sampleHistoryDims.push_back(sampleHistoryLength);
-    netCDF::NcDim nDim = targetFile.addDim("n", N);
+    netCDF::NcDim nDim = out.addDim("n", N);
     std::vector<netCDF::NcDim> fishDims;
     fishDims.push_back(nDim);
     std::vector<netCDF::NcDim> monitoringDims;
-    netCDF::NcDim monitoringPoints = targetFile.addDim("monitoringPoints", this->monitoringPoints.size());
+    netCDF::NcDim monitoringPoints = out.addDim("monitoringPoints", this->monitoringPoints.size());
     monitoringDims.push_back(monitoringPoints);
     monitoringDims.push_back(populationHistoryLength);
-    std::vector<netCDF::NcDim> monitoringPointsDims;
-    monitoringPointsDims.push_back(monitoringPoints);
 
     // Record model fields
     std::vector<size_t> noIndex;
-    netCDF::NcVar modelTime = targetFile.addVar("modelTime", netCDF::ncInt, noDims);
+    netCDF::NcVar modelTime = out.file().addVar("modelTime", netCDF::ncInt, noDims);
     modelTime.putVar(noIndex, this->time);
+    netCDF::NcVar tagEligibleRecruits = out.file().addVar("tagEligibleRecruits", netCDF::ncInt64, noDims);
+    tagEligibleRecruits.putVar(noIndex, (long long) this->tagSampler.eligibleCount());
 
     // Record fish
-    int *recruitTimeOut = new int[N];
-    int *exitTimeOut = new int[N];
-    float *entryForkLengthOut = new float[N];
-    float *entryMassOut = new float[N];
-    float *forkLengthOut = new float[N];
-    float *massOut = new float[N];
-    int *statusOut = new int[N];
-    int *locationOut = new int[N];
-    float *travelOut = new float[N];
-    float *lastGrowthOut = new float[N];
-    float *lastPmaxOut = new float[N];
-    float *lastMortalityOut = new float[N];
-    float *lastTempOut = new float[N];
-    float *lastDepthOut = new float[N];
-    float *lastFlowSpeedOut = new float[N];
-    float *lastFlowVelocityUOut = new float[N];
-    float *lastFlowVelocityVOut = new float[N];
-    for (size_t n = 0; n < N; ++n) {
-        Fish &f = this->individuals[n];
-        recruitTimeOut[n] = f.spawnTime;
-        exitTimeOut[n] = f.exitTime;
-        entryForkLengthOut[n] = f.entryForkLength;
-        entryMassOut[n] = f.entryMass;
-        forkLengthOut[n] = f.forkLength;
-        massOut[n] = f.mass;
-        statusOut[n] = (int) f.status;
-        locationOut[n] = f.location->id;
-        travelOut[n] = f.travel;
-        lastGrowthOut[n] = f.lastGrowth;
-        lastPmaxOut[n] = f.lastPmax;
-        lastMortalityOut[n] = f.lastMortality;
-        lastTempOut[n] = f.lastTemp;
-        lastDepthOut[n] = f.lastDepth;
-        lastFlowSpeedOut[n] = f.lastFlowSpeed_old;
-        lastFlowVelocityUOut[n] = f.lastFlowVelocity.u;
-        lastFlowVelocityVOut[n] = f.lastFlowVelocity.v;
-    }
-    netCDF::NcVar recruitTime = targetFile.addVar("recruitTime", netCDF::ncInt, fishDims);
-    recruitTime.putVar(recruitTimeOut);
-    netCDF::NcVar exitTime = targetFile.addVar("exitTime", netCDF::ncInt, fishDims);
-    exitTime.putVar(exitTimeOut);
-    netCDF::NcVar entryForkLength = targetFile.addVar("entryForkLength", netCDF::ncFloat, fishDims);
-    entryForkLength.putVar(entryForkLengthOut);
-    netCDF::NcVar entryMass = targetFile.addVar("entryMass", netCDF::ncFloat, fishDims);
-    entryMass.putVar(entryMassOut);
-    netCDF::NcVar forkLength = targetFile.addVar("forkLength", netCDF::ncFloat, fishDims);
-    forkLength.putVar(forkLengthOut);
-    netCDF::NcVar mass = targetFile.addVar("mass", netCDF::ncFloat, fishDims);
-    mass.putVar(massOut);
-    netCDF::NcVar status = targetFile.addVar("status", netCDF::ncInt, fishDims);
-    status.putVar(statusOut);
-    netCDF::NcVar location = targetFile.addVar("location", netCDF::ncInt, fishDims);
-    location.putVar(locationOut);
-    netCDF::NcVar travel = targetFile.addVar("travel", netCDF::ncFloat, fishDims);
-    travel.putVar(travelOut);
-    netCDF::NcVar lastGrowth = targetFile.addVar("lastGrowth", netCDF::ncFloat, fishDims);
-    lastGrowth.putVar(lastGrowthOut);
-    netCDF::NcVar lastPmax = targetFile.addVar("lastPmax", netCDF::ncFloat, fishDims);
-    lastPmax.putVar(lastPmaxOut);
-    netCDF::NcVar lastMortality = targetFile.addVar("lastMortality", netCDF::ncFloat, fishDims);
-    lastMortality.putVar(lastMortalityOut);
-    netCDF::NcVar lastTemp = targetFile.addVar("lastTemp", netCDF::ncFloat, fishDims);
-    lastTemp.putVar(lastTempOut);
-    netCDF::NcVar lastDepth = targetFile.addVar("lastDepth", netCDF::ncFloat, fishDims);
-    lastDepth.putVar(lastDepthOut);
-    netCDF::NcVar lastFlowSpeed = targetFile.addVar("lastFlowSpeed", netCDF::ncFloat, fishDims);
-    lastFlowSpeed.putVar(lastFlowSpeedOut);
-    netCDF::NcVar lastVelocityU = targetFile.addVar("lastFlowVelocityU", netCDF::ncFloat, fishDims);
-    lastVelocityU.putVar(lastFlowVelocityUOut);
-    netCDF::NcVar lastVelocityV = targetFile.addVar("lastFlowVelocityV", netCDF::ncFloat, fishDims);
-    lastVelocityV.putVar(lastFlowVelocityVOut);
+    const std::vector<Fish> &fish = this->individuals;
+    out.putEach<int>("recruitTime", fishDims, N, [&fish](size_t n) { return fish[n].spawnTime; });
+    out.putEach<int>("exitTime", fishDims, N, [&fish](size_t n) { return fish[n].exitTime; });
+    out.putEach<float>("entryForkLength", fishDims, N, [&fish](size_t n) { return fish[n].entryForkLength; });
+    out.putEach<float>("entryMass", fishDims, N, [&fish](size_t n) { return fish[n].entryMass; });
+    out.putEach<float>("forkLength", fishDims, N, [&fish](size_t n) { return fish[n].forkLength; });
+    out.putEach<float>("mass", fishDims, N, [&fish](size_t n) { return fish[n].mass; });
+    out.putEach<int>("status", fishDims, N, [&fish](size_t n) { return (int) fish[n].status; });
+    out.putEach<int>("location", fishDims, N, [&fish](size_t n) { return fish[n].location->id; });
+    out.putEach<float>("travel", fishDims, N, [&fish](size_t n) { return fish[n].travel; });
+    out.putEach<float>("lastGrowth", fishDims, N, [&fish](size_t n) { return fish[n].lastGrowth; });
+    out.putEach<float>("lastPmax", fishDims, N, [&fish](size_t n) { return fish[n].lastPmax; });
+    out.putEach<float>("lastMortality", fishDims, N, [&fish](size_t n) { return fish[n].lastMortality; });
+    out.putEach<float>("lastTemp", fishDims, N, [&fish](size_t n) { return fish[n].lastTemp; });
+    out.putEach<float>("lastDepth", fishDims, N, [&fish](size_t n) { return fish[n].lastDepth; });
+    out.putEach<float>("lastFlowSpeed", fishDims, N, [&fish](size_t n) { return fish[n].lastFlowSpeed_old; });
+    out.putEach<float>("lastFlowVelocityU", fishDims, N, [&fish](size_t n) { return fish[n].lastFlowVelocity.u; });
+    out.putEach<float>("lastFlowVelocityV", fishDims, N, [&fish](size_t n) { return fish[n].lastFlowVelocity.v; });
 
     // Write population history
-    netCDF::NcVar populationHistoryVar = targetFile.addVar("populationHistory", netCDF::ncInt, populationHistoryDims);
-    populationHistoryVar.putVar(this->populationHistory.data());
-
-    // Write sample history
-    int *sampleSiteIDOut = new int[this->sampleHistory.size()];
-    int *sampleTimeOut = new int[this->sampleHistory.size()];
-    int *samplePopOut = new int[this->sampleHistory.size()];
-    float *sampleMeanMassOut = new float[this->sampleHistory.size()];
-    float *sampleMeanLengthOut = new float[this->sampleHistory.size()];
-    float *sampleMeanSpawnTimeOut = new float[this->sampleHistory.size()];
-    for (size_t i = 0; i < this->sampleHistory.size(); ++i) {
-        sampleSiteIDOut[i] = this->sampleHistory[i].siteID;
-        sampleTimeOut[i] = this->sampleHistory[i].time;
-        samplePopOut[i] = this->sampleHistory[i].population;
-        sampleMeanMassOut[i] = this->sampleHistory[i].meanMass;
-        sampleMeanLengthOut[i] = this->sampleHistory[i].meanLength;
-        sampleMeanSpawnTimeOut[i] = this->sampleHistory[i].meanSpawnTime;
-    }
-    netCDF::NcVar sampleSiteID = targetFile.addVar("sampleSiteID", netCDF::ncInt, sampleHistoryDims);
-    sampleSiteID.putVar(sampleSiteIDOut);
-    netCDF::NcVar sampleTime = targetFile.addVar("sampleTime", netCDF::ncInt, sampleHistoryDims);
-    sampleTime.putVar(sampleTimeOut);
-    netCDF::NcVar samplePop = targetFile.addVar("samplePop", netCDF::ncInt, sampleHistoryDims);
-    samplePop.putVar(samplePopOut);
-    netCDF::NcVar sampleMeanMass = targetFile.addVar("sampleMeanMass", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanMass.putVar(sampleMeanMassOut);
-    netCDF::NcVar sampleMeanLength = targetFile.addVar("sampleMeanLength", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanLength.putVar(sampleMeanLengthOut);
-    netCDF::NcVar sampleMeanSpawnTime = targetFile.addVar("sampleMeanSpawnTime", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanSpawnTime.putVar(sampleMeanSpawnTimeOut);
-
-    int *monitoringPopulationOut = new int[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringPopulationDensityOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringDepthOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringTempOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    int *monitoringPointsOut = new int[this->monitoringPoints.size()];
-    for (size_t i = 0; i < this->monitoringPoints.size(); ++i) {
-        monitoringPointsOut[i] = this->monitoringPoints[i]->id;
-        for (size_t t = 0; t < this->populationHistory.size(); ++t) {
-            monitoringPopulationOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].population;
-            monitoringPopulationDensityOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].populationDensity;
-            monitoringDepthOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].depth;
-            monitoringTempOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].temp;
-        }
-    }
+    out.put("populationHistory", populationHistoryDims, this->populationHistory.data());
 
-    netCDF::NcVar monitoringPopulation = targetFile.addVar("monitoringPopulation", netCDF::ncInt, monitoringDims);
-    monitoringPopulation.putVar(monitoringPopulationOut);
-    netCDF::NcVar monitoringPopulationDensity = targetFile.addVar("monitoringPopulationDensity", netCDF::ncFloat, monitoringDims);
-    monitoringPopulationDensity.putVar(monitoringPopulationDensityOut);
-    netCDF::NcVar monitoringDepth = targetFile.addVar("monitoringDepth", netCDF::ncFloat, monitoringDims);
-    monitoringDepth.putVar(monitoringDepthOut);
-    netCDF::NcVar monitoringTemp = targetFile.addVar("monitoringTemp", netCDF::ncFloat, monitoringDims);
-    monitoringTemp.putVar(monitoringTempOut);
-    netCDF::NcVar monitoringPointIDs = targetFile.addVar("monitoringPointIDs", netCDF::ncInt, monitoringPointsDims);
-    monitoringPointIDs.putVar(monitoringPointsOut);
+    putSampleHistory(out, this->sampleHistory, sampleHistoryDims);
+    putMonitoringHistory(out, this->monitoringPoints, this->monitoringHistory, monitoringDims);
 }
 
 // Load model state from a given filename
@@ -664,112 +870,89 @@ void Model::saveState(std::string savePath) {
 void Model::loadState(std::string loadPath) {
     netCDF::NcFile sourceFile(loadPath, netCDF::NcFile::FileMode::read);
     size_t N = sourceFile.getDim("n").getSize();
-    long recruitTimeDummy;
-    float forkLengthDummy;
-    long locationDummy;
-    int statusDummy;
-    netCDF::NcVar recruitTime = sourceFile.getVar("recruitTime");
-    netCDF::NcVar exitTime = sourceFile.getVar("exitTime");
-    netCDF::NcVar entryForkLength = sourceFile.getVar("entryForkLength");
-    netCDF::NcVar entryMass = sourceFile.getVar("entryMass");
-    netCDF::NcVar forkLength = sourceFile.getVar("forkLength");
-    netCDF::NcVar mass = sourceFile.getVar("mass");
-    netCDF::NcVar status = sourceFile.getVar("status");
-    netCDF::NcVar location = sourceFile.getVar("location");
-    netCDF::NcVar travel = sourceFile.getVar("travel");
-    netCDF::NcVar lastGrowth = sourceFile.getVar("lastGrowth");
-    netCDF::NcVar lastPmax = sourceFile.getVar("lastPmax");
-    netCDF::NcVar lastMortality = sourceFile.getVar("lastMortality");
-    netCDF::NcVar lastTemp = sourceFile.getVar("lastTemp");
-    netCDF::NcVar lastDepth = sourceFile.getVar("lastDepth");
-    netCDF::NcVar lastFlowSpeed = sourceFile.getVar("lastFlowSpeed");
-    netCDF::NcVar lastFlowVelocityU = sourceFile.getVar("lastFlowVelocityU");
-    netCDF::NcVar lastFlowVelocityV = sourceFile.getVar("lastFlowVelocityV");
+    // One read per variable, then scatter into the fish
+    const std::vector<int> recruitTime = readVar<int>(sourceFile.getVar("recruitTime"), N);
+    const std::vector<int> exitTime = readVar<int>(sourceFile.getVar("exitTime"), N);
+    const std::vector<float> entryForkLength = readVar<float>(sourceFile.getVar("entryForkLength"), N);
+    const std::vector<float> entryMass = readVar<float>(sourceFile.getVar("entryMass"), N);
+    const std::vector<float> forkLength = readVar<float>(sourceFile.getVar("forkLength"), N);
+    const std::vector<float> mass = readVar<float>(sourceFile.getVar("mass"), N);
+    const std::vector<int> status = readVar<int>(sourceFile.getVar("status"), N);
+    const std::vector<int> location = readVar<int>(sourceFile.getVar("location"), N);
+    const std::vector<float> travel = readVar<float>(sourceFile.getVar("travel"), N);
+    const std::vector<float> lastGrowth = readVar<float>(sourceFile.getVar("lastGrowth"), N);
+    const std::vector<float> lastPmax = readVar<float>(sourceFile.getVar("lastPmax"), N);
+    const std::vector<float> lastMortality = readVar<float>(sourceFile.getVar("lastMortality"), N);
+    const std::vector<float> lastTemp = readVar<float>(sourceFile.getVar("lastTemp"), N);
+    const std::vector<float> lastDepth = readVar<float>(sourceFile.getVar("lastDepth"), N);
+    const std::vector<float> lastFlowSpeed = readVar<float>(sourceFile.getVar("lastFlowSpeed"), N);
+    const std::vector<float> lastFlowVelocityU = readVar<float>(sourceFile.getVar("lastFlowVelocityU"), N);
+    const std::vector<float> lastFlowVelocityV = readVar<float>(sourceFile.getVar("lastFlowVelocityV"), N);
     this->individuals.clear();
-    std::vector<size_t> idxVec{0U};
+    this->tagSampler.clear();
+    this->individuals.reserve(N);
     for (size_t id = 0; id < N; ++id) {
-        idxVec[0] = id;
-        recruitTime.getVar(idxVec, &recruitTimeDummy);
-        forkLength.getVar(idxVec, &forkLengthDummy);
-        location.getVar(idxVec, &locationDummy);
-        this->individuals.emplace_back(id, recruitTimeDummy, forkLengthDummy, this->map[locationDummy]);
+        this->individuals.emplace_back(id, recruitTime[id], forkLength[id], this->map[location[id]]);
         Fish &f = this->individuals[id];
-        exitTime.getVar(idxVec, &f.exitTime);
-        entryForkLength.getVar(idxVec, &f.entryForkLength);
-        entryMass.getVar(idxVec, &f.entryMass);
-        mass.getVar(idxVec, &f.mass);
-        status.getVar(idxVec, &statusDummy);
-        f.status = (FishStatus) statusDummy;
-        travel.getVar(idxVec, &f.travel);
-        lastGrowth.getVar(idxVec, &f.lastGrowth);
-        lastPmax.getVar(idxVec, &f.lastPmax);
-        lastMortality.getVar(idxVec, &f.lastMortality);
-        lastTemp.getVar(idxVec, &f.lastTemp);
-        lastDepth.getVar(idxVec, &f.lastDepth);
-        lastFlowSpeed.getVar(idxVec, &f.lastFlowSpeed_old);
-        lastFlowVelocityU.getVar(idxVec, &f.lastFlowVelocity.u);
-        lastFlowVelocityV.getVar(idxVec, &f.lastFlowVelocity.v);
+        f.exitTime = exitTime[id];
+        f.entryForkLength = entryForkLength[id];
+        f.entryMass = entryMass[id];
+        f.mass = mass[id];
+        f.status = (FishStatus) status[id];
+        f.travel = travel[id];
+        f.lastGrowth = lastGrowth[id];
+        f.lastPmax = lastPmax[id];
+        f.lastMortality = lastMortality[id];
+        f.lastTemp = lastTemp[id];
+        f.lastDepth = lastDepth[id];
+        f.lastFlowSpeed_old = lastFlowSpeed[id];
+        f.lastFlowVelocity.u = lastFlowVelocityU[id];
+        f.lastFlowVelocity.v = lastFlowVelocityV[id];
     }
+    this->population.rebuild(this->individuals);
+    // Carry on the systematic tag selection where the saved run left off (files saved before the count was
+    // recorded only allow an estimate from the loaded recruits)
+    const netCDF::NcVar tagEligibleRecruits = sourceFile.getVar("tagEligibleRecruits");
+    long long tagEligible = (long long) this->tagSampler.eligibleAmong(this->individuals);
+    if (!tagEligibleRecruits.isNull()) {
+        tagEligibleRecruits.getVar(&tagEligible);
+    }
+    this->tagSampler.resume((uint64_t) tagEligible);
 
-    this->populationHistory.clear();
     size_t populationHistoryLength = sourceFile.getDim("populationHistoryLength").getSize();
-    this->populationHistory.resize(populationHistoryLength);
-    sourceFile.getVar("populationHistory").getVar(this->populationHistory.data());
+    this->populationHistory = readVar<int>(sourceFile.getVar("populationHistory"), populationHistoryLength);
 
     this->sampleHistory.clear();
     size_t sampleHistoryLength = sourceFile.getDim("sampleHistoryLength").getSize();
-    int sampleSiteIDDummy;
-    int sampleTimeDummy;
-    int samplePopDummy;
-    float sampleMeanMassDummy;
-    float sampleMeanLengthDummy;
-    float sampleMeanSpawnTimeDummy;
-    netCDF::NcVar sampleSiteID = sourceFile.getVar("sampleSiteID");
-    netCDF::NcVar sampleTime = sourceFile.getVar("sampleTime");
-    netCDF::NcVar samplePop = sourceFile.getVar("samplePop");
-    netCDF::NcVar sampleMeanMass = sourceFile.getVar("sampleMeanMass");
-    netCDF::NcVar sampleMeanLength = sourceFile.getVar("sampleMeanLength");
-    netCDF::NcVar sampleMeanSpawnTime = sourceFile.getVar("sampleMeanSpawnTime");
+    const std::vector<int> sampleSiteID = readVar<int>(sourceFile.getVar("sampleSiteID"), sampleHistoryLength);
+    const std::vector<int> sampleTime = readVar<int>(sourceFile.getVar("sampleTime"), sampleHistoryLength);
+    const std::vector<int> samplePop = readVar<int>(sourceFile.getVar("samplePop"), sampleHistoryLength);
+    const std::vector<float> sampleMeanMass = readVar<float>(sourceFile.getVar("sampleMeanMass"), sampleHistoryLength);
+    const std::vector<float> sampleMeanLength = readVar<float>(sourceFile.getVar("sampleMeanLength"), sampleHistoryLength);
+    const std::vector<float> sampleMeanSpawnTime = readVar<float>(sourceFile.getVar("sampleMeanSpawnTime"), sampleHistoryLength);
+    this->sampleHistory.reserve(sampleHistoryLength);
     for (size_t i = 0; i < sampleHistoryLength; ++i) {
-        idxVec[0] = i;
-        sampleSiteID.getVar(idxVec, &sampleSiteIDDummy);
-        sampleTime.getVar(idxVec, &sampleTimeDummy);
-        samplePop.getVar(idxVec, &samplePopDummy);
-        sampleMeanMass.getVar(idxVec, &sampleMeanMassDummy);
-        sampleMeanLength.getVar(idxVec, &sampleMeanLengthDummy);
-        sampleMeanSpawnTime.getVar(idxVec, &sampleMeanSpawnTimeDummy);
-        this->sampleHistory.emplace_back((size_t) sampleSiteIDDummy, sampleTimeDummy, (size_t) samplePopDummy,
-                                         sampleMeanMassDummy, sampleMeanLengthDummy, sampleMeanSpawnTimeDummy);
+        this->sampleHistory.emplace_back((size_t) sampleSiteID[i], sampleTime[i], (size_t) samplePop[i],
+                                         sampleMeanMass[i], sampleMeanLength[i], sampleMeanSpawnTime[i]);
     }
 
     this->monitoringHistory.clear();
     this->monitoringPoints.clear();
     size_t numMonitoringPoints = sourceFile.getDim("monitoringPoints").getSize();
-    std::vector<size_t> idxVec2{0U, 0U};
-    netCDF::NcVar monitoringPointIDs = sourceFile.getVar("monitoringPointIDs");
-    netCDF::NcVar monitoringPopulation = sourceFile.getVar("monitoringPopulation");
-    netCDF::NcVar monitoringPopulationDensity = sourceFile.getVar("monitoringPopulationDensity");
-    netCDF::NcVar monitoringDepth = sourceFile.getVar("monitoringDepth");
-    netCDF::NcVar monitoringTemp = sourceFile.getVar("monitoringTemp");
-    int monitoringPointIDDummy;
-    int monitoringPopulationDummy;
-    float monitoringPopulationDensityDummy;
-    float monitoringDepthDummy;
-    float monitoringTempDummy;
+    const size_t monitoringCount = numMonitoringPoints * populationHistoryLength;
+    const std::vector<int> monitoringPointIDs = readVar<int>(sourceFile.getVar("monitoringPointIDs"), numMonitoringPoints);
+    const std::vector<int> monitoringPopulation = readVar<int>(sourceFile.getVar("monitoringPopulation"), monitoringCount);
+    const std::vector<float> monitoringPopulationDensity = readVar<float>(sourceFile.getVar("monitoringPopulationDensity"), monitoringCount);
+    const std::vector<float> monitoringDepth = readVar<float>(sourceFile.getVar("monitoringDepth"), monitoringCount);
+    const std::vector<float> monitoringTemp = readVar<float>(sourceFile.getVar("monitoringTemp"), monitoringCount);
     for (size_t i = 0; i < numMonitoringPoints; ++i) {
-        idxVec2[0] = i;
-        idxVec[0] = i;
-        monitoringPointIDs.getVar(idxVec, &monitoringPointIDDummy);
-        this->monitoringPoints.push_back(this->map[monitoringPointIDDummy]);
+        this->monitoringPoints.push_back(this->map[monitoringPointIDs[i]]);
         this->monitoringHistory.emplace_back();
+        this->monitoringHistory[i].reserve(populationHistoryLength);
         for (size_t t = 0; t < populationHistoryLength; ++t) {
-            idxVec2[1] = t;
-            monitoringPopulation.getVar(idxVec2, &monitoringPopulationDummy);
-            monitoringPopulationDensity.getVar(idxVec2, &monitoringPopulationDensityDummy);
-            monitoringDepth.getVar(idxVec2, &monitoringDepthDummy);
-            monitoringTemp.getVar(idxVec2, &monitoringTempDummy);
-            this->monitoringHistory[i].emplace_back((size_t)
-                monitoringPopulationDummy, monitoringPopulationDensityDummy, monitoringDepthDummy, monitoringTempDummy);
+            const size_t cell = i * populationHistoryLength + t;
+            this->monitoringHistory[i].emplace_back((size_t) monitoringPopulation[cell],
+                monitoringPopulationDensity[cell], monitoringDepth[cell], monitoringTemp[cell]);
         }
     }
 
@@ -778,116 +961,39 @@ void Model::loadState(std::string loadPath) {
     this->countAll(false);
 }
 
-
 // Write a summary of all individuals' vital statistics to the provided filename
 void Model::saveSummary(std::string savePath) {
-    netCDF::NcFile targetFile(savePath, netCDF::NcFile::FileMode::replace);
+    NcOutputWriter out(savePath);
     size_t N = this->individuals.size();
-    int *recruitTimeOut = new int[N];
-    int *exitTimeOut = new int[N];
-    float *entryForkLengthOut = new float[N];
-    float *entryMassOut = new float[N];
-    float *finalForkLengthOut = new float[N];
-    float *finalMassOut = new float[N];
-    int *finalStatusOut = new int[N];
-    for (size_t n = 0; n < N; ++n) {
-        Fish &f = this->individuals[n];
-        recruitTimeOut[n] = f.spawnTime;
-        exitTimeOut[n] = f.exitTime;
-        entryForkLengthOut[n] = f.entryForkLength;
-        entryMassOut[n] = f.entryMass;
-        finalForkLengthOut[n] = f.forkLength;
-        finalMassOut[n] = f.mass;
-        finalStatusOut[n] = (int) f.status;
-    }
-    netCDF::NcDim nDim = targetFile.addDim("n", N);
+    netCDF::NcDim nDim = out.addDim("n", N);
     std::vector<netCDF::NcDim> dims;
     dims.push_back(nDim);
     std::vector<netCDF::NcDim> monitoringDims;
-    netCDF::NcDim monitoringPoints = targetFile.addDim("monitoringPoints", this->monitoringPoints.size());
-    netCDF::NcDim historyLength = targetFile.addDim("historyLength", this->populationHistory.size());
+    netCDF::NcDim monitoringPoints = out.addDim("monitoringPoints", this->monitoringPoints.size());
+    netCDF::NcDim historyLength = out.addDim("historyLength", this->populationHistory.size());
     monitoringDims.push_back(monitoringPoints);
     monitoringDims.push_back(historyLength);
-    std::vector<netCDF::NcDim> monitoringPointsDims;
-    monitoringPointsDims.push_back(monitoringPoints);
-
-    netCDF::NcVar recruitTime = targetFile.addVar("recruitTime", netCDF::ncInt, dims);
-    recruitTime.putVar(recruitTimeOut);
-    netCDF::NcVar exitTime = targetFile.addVar("exitTime", netCDF::ncInt, dims);
-    exitTime.putVar(exitTimeOut);
-    netCDF::NcVar entryForkLength = targetFile.addVar("entryForkLength", netCDF::ncFloat, dims);
-    entryForkLength.putVar(entryForkLengthOut);
-    netCDF::NcVar entryMass = targetFile.addVar("entryMass", netCDF::ncFloat, dims);
-    entryMass.putVar(entryMassOut);
-    netCDF::NcVar finalForkLength = targetFile.addVar("finalForkLength", netCDF::ncFloat, dims);
-    finalForkLength.putVar(finalForkLengthOut);
-    netCDF::NcVar finalMass = targetFile.addVar("finalMass", netCDF::ncFloat, dims);
-    finalMass.putVar(finalMassOut);
-    netCDF::NcVar finalStatus = targetFile.addVar("finalStatus", netCDF::ncInt, dims);
-    finalStatus.putVar(finalStatusOut);
-
-    int *monitoringPopulationOut = new int[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringPopulationDensityOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringDepthOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringTempOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    int *monitoringPointsOut = new int[this->monitoringPoints.size()];
-    for (size_t i = 0; i < this->monitoringPoints.size(); ++i) {
-        monitoringPointsOut[i] = this->monitoringPoints[i]->id;
-        for (size_t t = 0; t < this->populationHistory.size(); ++t) {
-            monitoringPopulationOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].population;
-            monitoringPopulationDensityOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].populationDensity;
-            monitoringDepthOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].depth;
-            monitoringTempOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].temp;
-        }
-    }
 
-    netCDF::NcVar monitoringPopulation = targetFile.addVar("monitoringPopulation", netCDF::ncInt, monitoringDims);
-    monitoringPopulation.putVar(monitoringPopulationOut);
-    netCDF::NcVar monitoringPopulationDensity = targetFile.addVar("monitoringPopulationDensity", netCDF::ncFloat, monitoringDims);
-    monitoringPopulationDensity.putVar(monitoringPopulationDensityOut);
-    netCDF::NcVar monitoringDepth = targetFile.addVar("monitoringDepth", netCDF::ncFloat, monitoringDims);
-    monitoringDepth.putVar(monitoringDepthOut);
-    netCDF::NcVar monitoringTemp = targetFile.addVar("monitoringTemp", netCDF::ncFloat, monitoringDims);
-    monitoringTemp.putVar(monitoringTempOut);
-    netCDF::NcVar monitoringPointIDs = targetFile.addVar("monitoringPointIDs", netCDF::ncInt, monitoringPointsDims);
-    monitoringPointIDs.putVar(monitoringPointsOut);
+    const std::vector<Fish> &fish = this->individuals;
+    out.putEach<int>("recruitTime", dims, N, [&fish](size_t n) { return fish[n].spawnTime; });
+    out.putEach<int>("exitTime", dims, N, [&fish](size_t n) { return fish[n].exitTime; });
+    out.putEach<float>("entryForkLength", dims, N, [&fish](size_t n) { return fish[n].entryForkLength; });
+    out.putEach<float>("entryMass", dims, N, [&fish](size_t n) { return fish[n].entryMass; });
+    out.putEach<float>("finalForkLength", dims, N, [&fish](size_t n) { return fish[n].forkLength; });
+    out.putEach<float>("finalMass", dims, N, [&fish](size_t n) { return fish[n].mass; });
+    out.putEach<int>("finalStatus", dims, N, [&fish](size_t n) { return (int) fish[n].status; });
+
+    putMonitoringHistory(out, this->monitoringPoints, this->monitoringHistory, monitoringDims);
 }
 
 void Model::saveSampleData(std::string savePath) {
-    netCDF::NcFile targetFile(savePath, netCDF::NcFile::FileMode::replace);
+    NcOutputWriter out(savePath);
     // Add dimensions
-    std::vector<netCDF::NcDim> noDims;
-    netCDF::NcDim sampleHistoryLength = targetFile.addDim("sampleHistoryLength", this->sampleHistory.size());
+    netCDF::NcDim sampleHistoryLength = out.addDim("sampleHistoryLength", this->sampleHistory.size());
     std::vector<netCDF::NcDim> sampleHistoryDims;
     sampleHistoryDims.push_back(sampleHistoryLength);
 
-    // Write sample history
-    int *sampleSiteIDOut = new int[this->sampleHistory.size()];
-    int *sampleTimeOut = new int[this->sampleHistory.size()];
-    int *samplePopOut = new int[this->sampleHistory.size()];
-    float *sampleMeanMassOut = new float[this->sampleHistory.size()];
-    float *sampleMeanLengthOut = new float[this->sampleHistory.size()];
-    float *sampleMeanSpawnTimeOut = new float[this->sampleHistory.size()];
-    for (size_t i = 0; i < this->sampleHistory.size(); ++i) {
-        sampleSiteIDOut[i] = this->sampleHistory[i].siteID;
-        sampleTimeOut[i] = this->sampleHistory[i].time;
-        samplePopOut[i] = this->sampleHistory[i].population;
-        sampleMeanMassOut[i] = this->sampleHistory[i].meanMass;
-        sampleMeanLengthOut[i] = this->sampleHistory[i].meanLength;
-        sampleMeanSpawnTimeOut[i] = this->sampleHistory[i].meanSpawnTime;
-    }
-    netCDF::NcVar sampleSiteID = targetFile.addVar("sampleSiteID", netCDF::ncInt, sampleHistoryDims);
-    sampleSiteID.putVar(sampleSiteIDOut);
-    netCDF::NcVar sampleTime = targetFile.addVar("sampleTime", netCDF::ncInt, sampleHistoryDims);
-    sampleTime.putVar(sampleTimeOut);
-    netCDF::NcVar samplePop = targetFile.addVar("samplePop", netCDF::ncInt, sampleHistoryDims);
-    samplePop.putVar(samplePopOut);
-    netCDF::NcVar sampleMeanMass = targetFile.addVar("sampleMeanMass", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanMass.putVar(sampleMeanMassOut);
-    netCDF::NcVar sampleMeanLength = targetFile.addVar("sampleMeanLength", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanLength.putVar(sampleMeanLengthOut);
-    netCDF::NcVar sampleMeanSpawnTime = targetFile.addVar("sampleMeanSpawnTime", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanSpawnTime.putVar(sampleMeanSpawnTimeOut);
+    putSampleHistory(out, this->sampleHistory, sampleHistoryDims);
 }
 
 // void Model::saveNodeIdMapping(const std::string &nodeIdMappingPath) {
@@ -937,172 +1043,172 @@ void Model::saveHydroMapping(const std::string &hydroMappingCsvPath) const {
 }
 
 // Set the proportion of recruits that should be tagged for full life history recording
-void Model::setRecruitTagRate(float rate) { this->recruitTagRate = rate; }
+void Model::setRecruitTagRate(float rate) { this->setConfigValue(ModelParamKey::RecruitTagRate, rate); }
+
+void Model::tagRecruit(const size_t id) {
+    size_t evicted;
+    if (!this->tagSampler.offer(id, this->individuals[id].location->type, this->time, evicted)) {
+        return;
+    }
+    if (evicted != TagSampler::NO_FISH) {
+        this->individuals[evicted].untag();
+    }
+    this->tagIndividual(id);
+}
+
+// Checked once per timestep, after the histories of finished fish may have been streamed
+void Model::enforceTagBudget() {
+    this->untaggedFish.clear();
+    this->tagSampler.enforceBudget(this->individuals, this->untaggedFish);
+    for (size_t id: this->untaggedFish) {
+        this->individuals[id].untag();
+    }
+}
 
 // Tag an individual so that its full life history is recorded
-void Model::tagIndividual(const size_t id) { this->individuals[id].tag(*this); }
+void Model::tagIndividual(const size_t id) {
+    Fish &f = this->individuals[id];
+    const bool wasTagged = f.taggedTime != -1L;
+    f.tag(*this);
+    if (this->taggedHistoryStream != nullptr && !wasTagged && f.taggedTime != -1L) {
+        this->streamingFish.push_back(id);
+    }
+}
+
+void Model::streamTaggedHistories(const std::string &savePath) {
+    this->taggedHistoryStream = std::make_unique<TaggedHistoryStream>(savePath);
+    this->streamingFish.clear();
+    for (const Fish &f: this->individuals) {
+        if (f.taggedTime != -1L && f.history != nullptr) {
+            this->streamingFish.push_back(f.id);
+        }
+    }
+}
+
+// Append the histories of tagged fish that have died or exited to the stream
+// (and, at the end of each day, write them out)
+void Model::streamFinishedHistories() {
+    size_t kept = 0;
+    for (size_t id: this->streamingFish) {
+        Fish &f = this->individuals[id];
+        if (f.history == nullptr) {
+            // Untagged by the tag sampler
+            continue;
+        }
+        if (f.status == FishStatus::Alive) {
+            this->streamingFish[kept++] = id;
+        } else {
+            this->taggedHistoryStream->append(f);
+        }
+    }
+    this->streamingFish.resize(kept);
+    if ((this->time + 1) % 24 == 0) {
+        this->taggedHistoryStream->flush();
+    }
+}
+
+void Model::finishTaggedHistoryStream() {
+    if (this->taggedHistoryStream == nullptr) {
+        return;
+    }
+    for (size_t id: this->streamingFish) {
+        if (this->individuals[id].history != nullptr) {
+            this->taggedHistoryStream->append(this->individuals[id]);
+        }
+    }
+    this->streamingFish.clear();
+    this->taggedHistoryStream->flush();
+    std::cout << "Streamed " << this->taggedHistoryStream->trajectoryCount() << " tagged histories ("
+              << this->taggedHistoryStream->observationCount() << " fish-hours)" << std::endl;
+    this->taggedHistoryStream.reset();
+}
 
 
 // Write the full life histories for tagged individuals to the provided filename
 void Model::saveTaggedHistories(std::string savePath) {
     std::cout << "In saveTaggedHistories" << std::endl;
 
-    netCDF::NcFile targetFile(savePath, netCDF::NcFile::FileMode::replace);
+    NcOutputWriter out(savePath);
 
-    std::vector<size_t> taggedFish;
-    for (size_t i = 0; i < this->individuals.size(); ++i) {
-        // std::cout << std::endl << "individual taggedTime: " << this->individuals[i].taggedTime << std::endl;
-        if (this->individuals[i].taggedTime != -1L) {
-            taggedFish.push_back(i);
+    std::vector<const Fish *> taggedFish;
+    for (const Fish &f: this->individuals) {
+        // (fish whose histories were streamed no longer have them)
+        if (f.taggedTime != -1L && f.history != nullptr) {
+            taggedFish.push_back(&f);
         }
     }
     size_t N = taggedFish.size();
     long T = this->time + 1;
     std::cout << std::endl << "Values for N: " << N << ", and T: " << T << std::endl;
-    int *recruitTimeOut = new int[N];
-    int *taggedTimeOut = new int[N];
-    int *exitTimeOut = new int[N];
-    float *entryForkLengthOut = new float[N];
-    float *entryMassOut = new float[N];
-    float *finalForkLengthOut = new float[N];
-    float *finalMassOut = new float[N];
-    int *finalStatusOut = new int[N];
-    int *locationHistoryOut = new int[N * T];
-    float *growthHistoryOut = new float[N * T];
-    float *pmaxHistoryOut = new float[N * T];
-    float *mortalityHistoryOut = new float[N * T];
-    float *tempHistoryOut = new float[N * T];
-    float *depthHistoryOut = new float[N * T];
-    float *flowSpeedHistoryOut = new float[N * T];
-    float *flowVelocityUHistoryOut = new float[N * T];
-    float *flowVelocityVHistoryOut = new float[N * T];
-    std::cout << std::endl << "N: " << N << ",   T: " << T << std::endl;
-
-    for (size_t n = 0; n < N; ++n) {
-        Fish &f = this->individuals[taggedFish[n]];
-        // std::cout << std::endl << "loaded Fish: " << n << std::endl;
-        recruitTimeOut[n] = f.spawnTime;
-        // std::cout << std::endl << "set spawnTime: " << recruitTimeOut[n] << std::endl;
-        taggedTimeOut[n] = f.taggedTime;
-        exitTimeOut[n] = f.exitTime;
-        entryForkLengthOut[n] = f.entryForkLength;
-        entryMassOut[n] = f.entryMass;
-        finalForkLengthOut[n] = f.forkLength;
-        finalMassOut[n] = f.mass;
-        finalStatusOut[n] = (int) f.status;
-        // std::cout << std::endl << "finished loading Fish: " << n << std::endl;
-        for (long t = 0; t < T; ++t) {
-            // std::cout << std::endl << "Starting Time Steps with t = " << t << std::endl;
-            // std::cout << std::endl << "Calculated [n*T+t] as: " << n*T+t << std::endl;
-            // std::cout << std::endl << "f.taggedTime: " << f.taggedTime << std::endl;
-            // std::cout << std::endl << "f.locationHistory->size(): " << f.locationHistory->size() << std::endl;
-            // std::cout << std::endl << "f.growthHistory->size(): " << f.growthHistory->size() << std::endl;
-            // std::cout << std::endl << "f.mortalityHistory->size(): " << f.mortalityHistory->size() << std::endl;
-            if (t < f.taggedTime || t >= f.taggedTime + (long) f.locationHistory->size()) {
-                // std::cout << std::endl << "Condition 1.1" << std::endl;
-                locationHistoryOut[n * T + t] = -1;
-            } else {
-                // std::cout << std::endl << "Condition 1.2" << std::endl;
-                locationHistoryOut[n * T + t] = (*f.locationHistory)[t - f.taggedTime];
-            }
-
-            // std::cout << std::endl << "Condition 2.2" << std::endl;
-            bool outsideTaggedRange = t < f.taggedTime || t >= f.taggedTime + (long) f.growthHistory->size();
-            growthHistoryOut[n * T + t] = outsideTaggedRange ? 0.0f : (*f.growthHistory)[t - f.taggedTime];
-            pmaxHistoryOut[n * T + t] = outsideTaggedRange ? 0.0f : (*f.pmaxHistory)[t - f.taggedTime];
-            mortalityHistoryOut[n * T + t] = outsideTaggedRange ? 0.0f : (*f.mortalityHistory)[t - f.taggedTime];
-            tempHistoryOut[n * T + t] = outsideTaggedRange ? 0.0f : (*f.tempHistory)[t - f.taggedTime];
-            depthHistoryOut[n * T + t] = outsideTaggedRange ? 0.0f : (*f.depthHistory)[t - f.taggedTime];
-            flowSpeedHistoryOut[n * T + t] = outsideTaggedRange ? 0.0f : (*f.flowSpeedHistory_old)[t - f.taggedTime];
-            flowVelocityUHistoryOut[n * T + t] =
-                    outsideTaggedRange ? 0.0 : (*f.flowVelocityHistory)[t - f.taggedTime].u;
-            flowVelocityVHistoryOut[n * T + t] =
-                    outsideTaggedRange ? 0.0 : (*f.flowVelocityHistory)[t - f.taggedTime].v;
-
-            // int locationIndex = locationHistoryOut[n*T+t];
-            // float pMax = pmaxHistoryOut[n*T+t];
-            // if (locationIndex != -1 && this->map[locationIndex]->type == HabitatType::Nearshore && pMax != 1.0) {
-            //     std::cout << "Writing nearshore Pmax: " << pMax << " for ID: " << this->map[locationIndex]->id
-            //     << " at step: " << t << std::endl;
-            // }
-            //
-            // if (locationIndex != this->map[locationIndex]->id) {
-            //     std::cout << "Location index from history: " << locationIndex << " is not equal to map ID: " << this->map[locationIndex]->id << std::endl;
-            //     std::cout << std::endl;
-            // }
 
-        }
-        // std::cout << std::endl << "finished loading all T data: " << T << std::endl;
-    }
-    std::cout << std::endl << "Finished loading all tracks" << std::endl;
-    netCDF::NcDim nDim = targetFile.addDim("n", N);
-    netCDF::NcDim tDim = targetFile.addDim("t", T);
+    netCDF::NcDim nDim = out.addDim("n", N);
+    netCDF::NcDim tDim = out.addDim("t", T);
     std::vector<netCDF::NcDim> dimsN;
     std::vector<netCDF::NcDim> dimsNT;
     dimsN.push_back(nDim);
     dimsNT.push_back(nDim);
     dimsNT.push_back(tDim);
 
-    netCDF::NcVar recruitTime = targetFile.addVar("recruitTime", netCDF::ncInt, dimsN);
-    recruitTime.putVar(recruitTimeOut);
-    netCDF::NcVar taggedTime = targetFile.addVar("taggedTime", netCDF::ncInt, dimsN);
-    taggedTime.putVar(taggedTimeOut);
-    netCDF::NcVar exitTime = targetFile.addVar("exitTime", netCDF::ncInt, dimsN);
-    exitTime.putVar(exitTimeOut);
-    netCDF::NcVar entryForkLength = targetFile.addVar("entryForkLength", netCDF::ncFloat, dimsN);
-    entryForkLength.putVar(entryForkLengthOut);
-    netCDF::NcVar entryMass = targetFile.addVar("entryMass", netCDF::ncFloat, dimsN);
-    entryMass.putVar(entryMassOut);
-    netCDF::NcVar finalForkLength = targetFile.addVar("finalForkLength", netCDF::ncFloat, dimsN);
-    finalForkLength.putVar(finalForkLengthOut);
-    netCDF::NcVar finalMass = targetFile.addVar("finalMass", netCDF::ncFloat, dimsN);
-    finalMass.putVar(finalMassOut);
-    netCDF::NcVar finalStatus = targetFile.addVar("finalStatus", netCDF::ncInt, dimsN);
-    finalStatus.putVar(finalStatusOut);
-    netCDF::NcVar locationHistory = targetFile.addVar("locationHistory", netCDF::ncInt, dimsNT);
-    locationHistory.putVar(locationHistoryOut);
-    netCDF::NcVar growthHistory = targetFile.addVar("growthHistory", netCDF::ncFloat, dimsNT);
-    growthHistory.putVar(growthHistoryOut);
-    netCDF::NcVar pmaxHistory = targetFile.addVar("pmaxHistory", netCDF::ncFloat, dimsNT);
-    pmaxHistory.putVar(pmaxHistoryOut);
-    netCDF::NcVar mortalityHistory = targetFile.addVar("mortalityHistory", netCDF::ncFloat, dimsNT);
-    mortalityHistory.putVar(mortalityHistoryOut);
-    netCDF::NcVar tempHistory = targetFile.addVar("tempHistory", netCDF::ncFloat, dimsNT);
-    tempHistory.putVar(tempHistoryOut);
-    netCDF::NcVar depthHistory = targetFile.addVar("depthHistory", netCDF::ncFloat, dimsNT);
-    depthHistory.putVar(depthHistoryOut);
-    netCDF::NcVar flowSpeedHistory = targetFile.addVar("flowSpeedHistory", netCDF::ncFloat, dimsNT);
-    flowSpeedHistory.putVar(flowSpeedHistoryOut);
-    netCDF::NcVar flowVelocityUHistory = targetFile.addVar("flowVelocityUHistory", netCDF::ncFloat, dimsNT);
-    flowVelocityUHistory.putVar(flowVelocityUHistoryOut);
-    netCDF::NcVar flowVelocityVHistory = targetFile.addVar("flowVelocityVHistory", netCDF::ncFloat, dimsNT);
-    flowVelocityVHistory.putVar(flowVelocityVHistoryOut);
+    out.putEach<int>("recruitTime", dimsN, N, [&taggedFish](size_t n) { return taggedFish[n]->spawnTime; });
+    out.putEach<int>("taggedTime", dimsN, N, [&taggedFish](size_t n) { return taggedFish[n]->taggedTime; });
+    out.putEach<int>("exitTime", dimsN, N, [&taggedFish](size_t n) { return taggedFish[n]->exitTime; });
+    out.putEach<float>("entryForkLength", dimsN, N, [&taggedFish](size_t n) { return taggedFish[n]->entryForkLength; });
+    out.putEach<float>("entryMass", dimsN, N, [&taggedFish](size_t n) { return taggedFish[n]->entryMass; });
+    out.putEach<float>("finalForkLength", dimsN, N, [&taggedFish](size_t n) { return taggedFish[n]->forkLength; });
+    out.putEach<float>("finalMass", dimsN, N, [&taggedFish](size_t n) { return taggedFish[n]->mass; });
+    out.putEach<int>("finalStatus", dimsN, N, [&taggedFish](size_t n) { return (int) taggedFish[n]->status; });
+
+    // Each (n, t) variable holds a fish's recorded values from its tag time on, and outside
+    // of them -1 (location) or 0 (everything else)
+    // (compact histories are decoded here, so the file is the same either way)
+    auto putHistory = [&](const std::string &name, auto blank, auto copyRange) {
+        using Value = decltype(blank);
+        out.putFilled<Value>(name, dimsNT, N * T, [&](Value *row) {
+            for (size_t n = 0; n < N; ++n, row += T) {
+                const Fish &f = *taggedFish[n];
+                const long first = std::min(std::max(f.taggedTime, 0L), T);
+                const long last = std::min(f.taggedTime + (long) f.history->length(), T);
+                std::fill(row, row + first, blank);
+                if (last > first) {
+                    copyRange(*f.history, (size_t) (first - f.taggedTime), (size_t) (last - first), row + first);
+                }
+                std::fill(row + std::max(first, last), row + T, blank);
+            }
+        });
+    };
+    auto channel = [](HistoryChannel c) {
+        return [c](const FishHistory &h, size_t first, size_t count, float *out) { h.copy(c, first, count, out); };
+    };
+    putHistory("locationHistory", -1, [](const FishHistory &h, size_t first, size_t count, int *out) {
+        h.copyLocations(first, count, out);
+    });
+    putHistory("growthHistory", 0.0f, channel(HistoryChannel::Growth));
+    putHistory("pmaxHistory", 0.0f, channel(HistoryChannel::Pmax));
+    putHistory("mortalityHistory", 0.0f, channel(HistoryChannel::Mortality));
+    putHistory("tempHistory", 0.0f, channel(HistoryChannel::Temp));
+    putHistory("depthHistory", 0.0f, channel(HistoryChannel::Depth));
+    putHistory("flowSpeedHistory", 0.0f, channel(HistoryChannel::FlowSpeed));
+    putHistory("flowVelocityUHistory", 0.0f, channel(HistoryChannel::FlowVelocityU));
+    putHistory("flowVelocityVHistory", 0.0f, channel(HistoryChannel::FlowVelocityV));
 }
 
 void Model::loadTaggedHistories(std::string loadPath) {
     this->reset();
     netCDF::NcFile sourceFile(loadPath, netCDF::NcFile::FileMode::read);
+    if (!sourceFile.getDim("obs").isNull()) {
+        this->loadStreamedTaggedHistories(sourceFile);
+        return;
+    }
     size_t N = sourceFile.getDim("n").getSize();
     long T = sourceFile.getDim("t").getSize();
-    long recruitTimeDummy;
-    float forkLengthDummy;
-    long locationDummy;
-    int statusDummy;
-    float growthDummy;
-    float pmaxDummy;
-    float mortalityDummy;
-    float tempDummy;
-    float depthDummy;
-    float flowSpeedDummy;
-    FlowVelocity flowVelocityDummy;
-    netCDF::NcVar recruitTime = sourceFile.getVar("recruitTime");
-    netCDF::NcVar taggedTime = sourceFile.getVar("taggedTime");
-    netCDF::NcVar exitTime = sourceFile.getVar("exitTime");
-    netCDF::NcVar entryForkLength = sourceFile.getVar("entryForkLength");
-    netCDF::NcVar entryMass = sourceFile.getVar("entryMass");
-    netCDF::NcVar finalForkLength = sourceFile.getVar("finalForkLength");
-    netCDF::NcVar finalMass = sourceFile.getVar("finalMass");
-    netCDF::NcVar finalStatus = sourceFile.getVar("finalStatus");
+    const std::vector<int> recruitTime = readVar<int>(sourceFile.getVar("recruitTime"), N);
+    const std::vector<int> taggedTime = readVar<int>(sourceFile.getVar("taggedTime"), N);
+    const std::vector<int> exitTime = readVar<int>(sourceFile.getVar("exitTime"), N);
+    const std::vector<float> entryForkLength = readVar<float>(sourceFile.getVar("entryForkLength"), N);
+    const std::vector<float> entryMass = readVar<float>(sourceFile.getVar("entryMass"), N);
+    const std::vector<float> finalForkLength = readVar<float>(sourceFile.getVar("finalForkLength"), N);
+    const std::vector<float> finalMass = readVar<float>(sourceFile.getVar("finalMass"), N);
+    const std::vector<int> finalStatus = readVar<int>(sourceFile.getVar("finalStatus"), N);
     netCDF::NcVar locationHistory = sourceFile.getVar("locationHistory");
     netCDF::NcVar growthHistory = sourceFile.getVar("growthHistory");
     netCDF::NcVar pmaxHistory = sourceFile.getVar("pmaxHistory");
@@ -1113,50 +1219,129 @@ void Model::loadTaggedHistories(std::string loadPath) {
     netCDF::NcVar flowVelocityUHistory = sourceFile.getVar("flowVelocityUHistory");
     netCDF::NcVar flowVelocityVHistory = sourceFile.getVar("flowVelocityVHistory");
     this->individuals.clear();
-    std::vector<size_t> idxVecN{0U};
-    std::vector<size_t> idxVecNT{0U, 0U};
-    for (size_t id = 0; id < N; ++id) {
-        idxVecN[0] = id;
-        idxVecNT[0] = id;
-        idxVecNT[1] = T - 1;
-        recruitTime.getVar(idxVecN, &recruitTimeDummy);
-        finalForkLength.getVar(idxVecN, &forkLengthDummy);
-        finalStatus.getVar(idxVecN, &statusDummy);
-        locationHistory.getVar(idxVecNT, &locationDummy);
-        this->individuals.emplace_back(id, recruitTimeDummy, forkLengthDummy, this->map[locationDummy]);
-        Fish &f = this->individuals[id];
-        taggedTime.getVar(idxVecN, &f.taggedTime);
-        exitTime.getVar(idxVecN, &f.exitTime);
-        entryForkLength.getVar(idxVecN, &f.entryForkLength);
-        entryMass.getVar(idxVecN, &f.entryMass);
-        finalMass.getVar(idxVecN, &f.mass);
-        f.exitStatus = (FishStatus) statusDummy;
-        f.addHistoryBuffers();
-        for (long t = f.taggedTime; t < T; ++t) {
-            idxVecNT[1] = t;
-            locationHistory.getVar(idxVecNT, &locationDummy);
-            if (locationDummy == -1L) {
-                break;
+    this->individuals.reserve(N);
+
+    // The (n, t) histories are read a block of fish at a time, so the buffers stay bounded however many fish were tagged
+    const size_t blockRows = T > 0 ? std::max((size_t) 1, HISTORY_BLOCK_VALUES / (size_t) T) : N;
+    std::vector<int> location;
+    std::vector<float> growth, pmax, mortality, temp, depth, flowSpeed, flowVelocityU, flowVelocityV;
+    for (size_t firstRow = 0; firstRow < N; firstRow += blockRows) {
+        const size_t rows = std::min(blockRows, N - firstRow);
+        readRows(locationHistory, firstRow, rows, T, location);
+        readRows(growthHistory, firstRow, rows, T, growth);
+        readRows(pmaxHistory, firstRow, rows, T, pmax);
+        readRows(mortalityHistory, firstRow, rows, T, mortality);
+        readRows(tempHistory, firstRow, rows, T, temp);
+        readRows(depthHistory, firstRow, rows, T, depth);
+        readRows(flowSpeedHistory, firstRow, rows, T, flowSpeed);
+        readRows(flowVelocityUHistory, firstRow, rows, T, flowVelocityU);
+        readRows(flowVelocityVHistory, firstRow, rows, T, flowVelocityV);
+        for (size_t row = 0; row < rows; ++row) {
+            const size_t id = firstRow + row;
+            const size_t rowStart = row * T;
+            // The recorded hours run from the tag time to the first -1 location (or the end of the file)
+            const long begin = std::min(std::max((long) taggedTime[id], 0L), T);
+            long end = begin;
+            while (end < T && location[rowStart + end] != -1) {
+                ++end;
+            }
+            const size_t first = rowStart + begin;
+            const size_t last = rowStart + end;
+            // Fish that left before the last hour are placed at their last recorded location
+            // (setHistoryTimestep moves fish as the replay proceeds)
+            MapNode *finalLocation = last > first ? this->map[location[last - 1]] : nullptr;
+            this->individuals.emplace_back(id, recruitTime[id], finalForkLength[id], finalLocation);
+            Fish &f = this->individuals[id];
+            f.taggedTime = taggedTime[id];
+            f.exitTime = exitTime[id];
+            f.entryForkLength = entryForkLength[id];
+            f.entryMass = entryMass[id];
+            f.mass = finalMass[id];
+            f.exitStatus = (FishStatus) finalStatus[id];
+            f.addHistoryBuffers(this->params.compactHistories);
+            FishHistory &h = *f.history;
+            h.reserve(last - first);
+            for (size_t cell = first; cell < last; ++cell) {
+                h.append(location[cell], growth[cell], pmax[cell], mortality[cell], temp[cell], depth[cell],
+                         flowSpeed[cell], FlowVelocity(flowVelocityU[cell], flowVelocityV[cell]));
+            }
+            f.calculateMassHistory();
+        }
+    }
+    this->population.rebuild(this->individuals);
+}
+
+// Read histories written by a TaggedHistoryStream (contiguous ragged arrays)
+void Model::loadStreamedTaggedHistories(const netCDF::NcFile &sourceFile) {
+    size_t N = sourceFile.getDim("n").getSize();
+    const std::vector<int> rowSize = readVar<int>(sourceFile.getVar("rowSize"), N);
+    const std::vector<int> recruitTime = readVar<int>(sourceFile.getVar("recruitTime"), N);
+    const std::vector<int> taggedTime = readVar<int>(sourceFile.getVar("taggedTime"), N);
+    const std::vector<int> exitTime = readVar<int>(sourceFile.getVar("exitTime"), N);
+    const std::vector<float> entryForkLength = readVar<float>(sourceFile.getVar("entryForkLength"), N);
+    const std::vector<float> entryMass = readVar<float>(sourceFile.getVar("entryMass"), N);
+    const std::vector<float> finalForkLength = readVar<float>(sourceFile.getVar("finalForkLength"), N);
+    const std::vector<float> finalMass = readVar<float>(sourceFile.getVar("finalMass"), N);
+    const std::vector<int> finalStatus = readVar<int>(sourceFile.getVar("finalStatus"), N);
+    netCDF::NcVar locationHistory = sourceFile.getVar("locationHistory");
+    netCDF::NcVar growthHistory = sourceFile.getVar("growthHistory");
+    netCDF::NcVar pmaxHistory = sourceFile.getVar("pmaxHistory");
+    netCDF::NcVar mortalityHistory = sourceFile.getVar("mortalityHistory");
+    netCDF::NcVar tempHistory = sourceFile.getVar("tempHistory");
+    netCDF::NcVar depthHistory = sourceFile.getVar("depthHistory");
+    netCDF::NcVar flowSpeedHistory = sourceFile.getVar("flowSpeedHistory");
+    netCDF::NcVar flowVelocityUHistory = sourceFile.getVar("flowVelocityUHistory");
+    netCDF::NcVar flowVelocityVHistory = sourceFile.getVar("flowVelocityVHistory");
+    this->individuals.clear();
+    this->individuals.reserve(N);
+
+    // Observations are read a run of whole fish at a time (at least one fish, otherwise at most
+    // HISTORY_BLOCK_VALUES observations)
+    std::vector<int> location;
+    std::vector<float> growth, pmax, mortality, temp, depth, flowSpeed, flowVelocityU, flowVelocityV;
+    size_t firstObservation = 0;
+    for (size_t firstFish = 0; firstFish < N;) {
+        size_t endFish = firstFish;
+        size_t observations = 0;
+        while (endFish < N && (endFish == firstFish || observations + rowSize[endFish] <= HISTORY_BLOCK_VALUES)) {
+            observations += rowSize[endFish];
+            ++endFish;
+        }
+        readRange(locationHistory, firstObservation, observations, location);
+        readRange(growthHistory, firstObservation, observations, growth);
+        readRange(pmaxHistory, firstObservation, observations, pmax);
+        readRange(mortalityHistory, firstObservation, observations, mortality);
+        readRange(tempHistory, firstObservation, observations, temp);
+        readRange(depthHistory, firstObservation, observations, depth);
+        readRange(flowSpeedHistory, firstObservation, observations, flowSpeed);
+        readRange(flowVelocityUHistory, firstObservation, observations, flowVelocityU);
+        readRange(flowVelocityVHistory, firstObservation, observations, flowVelocityV);
+        size_t first = 0;
+        for (size_t id = firstFish; id < endFish; ++id) {
+            const size_t last = first + rowSize[id];
+            MapNode *finalLocation = last > first ? this->map[location[last - 1]] : nullptr;
+            this->individuals.emplace_back(id, recruitTime[id], finalForkLength[id], finalLocation);
+            Fish &f = this->individuals[id];
+            f.taggedTime = taggedTime[id];
+            f.exitTime = exitTime[id];
+            f.entryForkLength = entryForkLength[id];
+            f.entryMass = entryMass[id];
+            f.mass = finalMass[id];
+            f.exitStatus = (FishStatus) finalStatus[id];
+            f.addHistoryBuffers(this->params.compactHistories);
+            FishHistory &h = *f.history;
+            h.reserve(last - first);
+            for (size_t cell = first; cell < last; ++cell) {
+                h.append(location[cell], growth[cell], pmax[cell], mortality[cell], temp[cell], depth[cell],
+                         flowSpeed[cell], FlowVelocity(flowVelocityU[cell], flowVelocityV[cell]));
             }
-            growthHistory.getVar(idxVecNT, &growthDummy);
-            pmaxHistory.getVar(idxVecNT, &pmaxDummy);
-            mortalityHistory.getVar(idxVecNT, &mortalityDummy);
-            tempHistory.getVar(idxVecNT, &tempDummy);
-            depthHistory.getVar(idxVecNT, &depthDummy);
-            flowSpeedHistory.getVar(idxVecNT, &flowSpeedDummy);
-            flowVelocityUHistory.getVar(idxVecNT, &flowVelocityDummy.u);
-            flowVelocityVHistory.getVar(idxVecNT, &flowVelocityDummy.v);
-            f.locationHistory->push_back(locationDummy);
-            f.growthHistory->push_back(growthDummy);
-            f.pmaxHistory->push_back(pmaxDummy);
-            f.mortalityHistory->push_back(mortalityDummy);
-            f.tempHistory->push_back(tempDummy);
-            f.depthHistory->push_back(depthDummy);
-            f.flowSpeedHistory_old->push_back(flowSpeedDummy);
-            f.flowVelocityHistory->push_back(flowVelocityDummy);
+            f.calculateMassHistory();
+            first = last;
         }
-        f.calculateMassHistory();
+        firstFish = endFish;
+        firstObservation += observations;
     }
+    this->population.rebuild(this->individuals);
 }
 
 void Model::setHistoryTimestep(long timestep) {
@@ -1164,22 +1349,25 @@ void Model::setHistoryTimestep(long timestep) {
     this->hydroModel.updateTime(timestep);
     this->livingIndividuals.clear();
     for (Fish &f: this->individuals) {
-        if (timestep >= f.taggedTime && timestep < f.taggedTime + (long) f.locationHistory->size()) {
-            f.location = this->map[(*f.locationHistory)[timestep - f.taggedTime]];
-            f.lastGrowth = (*f.growthHistory)[timestep - f.taggedTime];
-            f.lastPmax = (*f.pmaxHistory)[timestep - f.taggedTime];
-            f.lastMortality = (*f.mortalityHistory)[timestep - f.taggedTime];
-            f.lastTemp = (*f.tempHistory)[timestep - f.taggedTime];
-            f.lastDepth = (*f.depthHistory)[timestep - f.taggedTime];
-            f.lastFlowSpeed_old = (*f.flowSpeedHistory_old)[timestep - f.taggedTime];
-            f.lastFlowVelocity = (*f.flowVelocityHistory)[timestep - f.taggedTime];
+        const FishHistory &h = *f.history;
+        if (timestep >= f.taggedTime && timestep < f.taggedTime + (long) h.length()) {
+            const HistorySample sample = h.at(timestep - f.taggedTime);
+            f.location = this->map[sample.location];
+            f.lastGrowth = sample.growth;
+            f.lastPmax = sample.pmax;
+            f.lastMortality = sample.mortality;
+            f.lastTemp = sample.temp;
+            f.lastDepth = sample.depth;
+            f.lastFlowSpeed_old = sample.flowSpeed;
+            f.lastFlowVelocity = sample.flowVelocity;
             f.status = FishStatus::Alive;
-            f.mass = (*f.massHistory)[timestep - f.taggedTime];
-            f.forkLength = (*f.forkLengthHistory)[timestep - f.taggedTime];
+            f.mass = sample.mass;
+            f.forkLength = sample.forkLength;
             this->livingIndividuals.push_back(f.id);
         } else if (timestep >= f.exitTime) {
             f.status = f.exitStatus;
         }
+        this->population.store(f);
     }
     this->countAll(false);
 }
@@ -1196,6 +1384,32 @@ std::string Model::getString(ModelParamKey key) const {
     return configMap.getString(key);
 }
 
+const ThreadPool &Model::getThreadPool() const {
+    return *this->threadPool;
+}
+
+void Model::resolveMovementStrategy() {
+    this->movementEngines.clear();
+    this->reachabilityCache.reset(this->params.reachabilityBucketWidth);
+    for (size_t i = 0; i < this->threadPool->size(); ++i) {
+        // Swim speed, range and fitness are supplied by each fish in FishMovement::determineNextLocationFor
+        this->movementEngines.push_back(FishMovementFactory::createFishMovement(
+            *this, 0.0f, 0.0f, nullptr, this->configMap));
+    }
+}
+
+FishMovement &Model::getMovementEngine() {
+    return *this->movementEngines[ThreadPool::currentParticipant()];
+}
+
+void Model::setConfigValue(ModelParamKey key, const ConfigValue &value) {
+    this->configMap.set(key, value);
+    this->configMap.validate();
+    this->params = ModelParams(this->configMap);
+    this->tagSampler.configure(TagSelection::fromConfig(this->configMap));
+    this->resolveMovementStrategy();
+}
+
 const ModelConfigMap& Model::getConfigMap() const {
     return configMap;
 }
@@ -1224,10 +1438,6 @@ Model *modelFromConfig(std::string configPath) {
     if (d.HasMember("threadCount")) {
         desiredThreads = d["threadCount"].GetInt();
     }
-    if (rng_seed != GlobalRand::USE_RANDOM_SEED) {
-        desiredThreads = 1;
-        std::cout << "Forcing max threads to 1 due to non-zero RNG seed (" << rng_seed << ")" << std::endl;
-    }
     if (desiredThreads <= 0) {
         desiredThreads = hwThreads;
     }
@@ -1271,6 +1481,9 @@ Model *modelFromConfig(std::string configPath) {
             std::string(d["airTempFile"].GetString()),
             std::string(d["flowSpeedFile"].GetString()),
             std::string(d["distribWseTempFile"].GetString()),
+            d.HasMember("hydroCacheFile")
+                ? std::string(d["hydroCacheFile"].GetString())
+                : std::string(),
             config
         );
     } else {
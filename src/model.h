@@ -7,12 +7,20 @@
 #include <vector>
 #include "fish.h"
 #include "map.h"
+#include "map_graph.h"
 #include "hydro.h"
 #include "model_config_map.h"
+#include "population.h"
+#include "reachability_cache.h"
+#include "tag_sampler.h"
+#include "thread_pool.h"
 
 #ifndef __FISH_FISH_CLS
 class Fish;
 #endif
+class FishMovement;
+class TaggedHistoryStream;
+namespace netCDF { class NcFile; }
 
 
 // This struct represents the results of a single biweekly sampling instance at a given sampling site
@@ -42,10 +50,19 @@ typedef struct MonitoringRecord {
     MonitoringRecord(size_t population, float populationDensity, float depth, float temp) : population(population), populationDensity(populationDensity), depth(depth), temp(temp) {}
 } MonitoringRecord;
 
+// A fish that changed location, died or exited during a parallel phase (from/to are nullptr when not counted)
+struct ResidencyChange {
+    size_t id;
+    MapNode *from;
+    MapNode *to;
+};
+
 class Model {
 public:
     // List of heap-allocated map locations
     std::vector<MapNode *> map;
+    // Frozen index-based adjacency of map, built once loading is done (used by fish movement)
+    MapGraph mapGraph;
 
 private:
     std::unique_ptr<HydroModel> defaultHydroModel;
@@ -79,6 +96,8 @@ public:
     long time;
     // The list containing all Fish instances, living, dead, and exited
     std::vector<Fish> individuals;
+    // Dense per-fish copies of the fields used by the per-timestep passes (same indexing as individuals)
+    Population population;
     // The list containing currently active fish
     std::vector<size_t> livingIndividuals;
     // The number of fish that have died so far
@@ -117,6 +136,7 @@ public:
         std::string airTempFilename,
         std::string flowSpeedFilename,
         std::string distribWseTempFilename,
+        std::string hydroCacheFilename,
         const ModelConfigMap& config
     );
 
@@ -144,13 +164,23 @@ public:
     // Calls Fish::move for every living fish and removes fish that die during this procedure from livingIndividuals
     void moveAll();
     // Computes local population statistics, including density, median and mean mass for each location
+    // (bins living fish by location and ranks them, in parallel on the thread pool)
     void countAll(bool updateTracking);
+    // Note (from a worker thread) whether a fish processed in moveAll/growAndDieAll changed residency
+    void recordResidencyChange(size_t id);
+    // Apply the residency changes recorded since the last count, refreshing only the nodes they touched,
+    // or (with refreshRanks) every node's mass/arrival ranks as well, since those depend on every fish
+    void applyResidencyChanges(bool refreshRanks);
+    // Compare residency and densities against a full recount; throws std::logic_error on a mismatch
+    void verifyResidency() const;
     // Calls Fish::grow for every living fish and removes fish that die during this procedure from livingIndividuals
     void growAndDieAll();
     // Generates and adds new fish according to the current timestep's entry in recDayPlan
     void recruit();
     // Generates and adds a single new fish
     void recruitSingle();
+    // Adds a single new fish from the given fork length bucket of the recruit size distribution
+    void addRecruit(size_t flIdx);
     // Resamples recDayPlan to determine per-timestep recruit counts for the next day
     void planRecruitment();
     // Computes sampling results and adds new entries to samplingHistory
@@ -165,14 +195,21 @@ public:
     void saveSummary(std::string savePath);
     // Write all sampling results to the provided filename
     void saveSampleData(std::string savePath);
-    // Set the proportion of recruits that should be tagged for full life history recording
+    // Set the proportion of recruits that should be tagged for full life history recording (see recruitTagRate)
     void setRecruitTagRate(float rate);
+    // Chooses which recruits are tagged (configured from the tagging parameters)
+    const TagSampler &getTagSampler() const { return tagSampler; }
     // Tag an individual so that its full life history is recorded
     void tagIndividual(size_t id);
     // Write the full life histories for tagged individuals to the provided filename
     void saveTaggedHistories(std::string savePath);
-    // Read individuals' life histories saved by saveTaggedHistories into the "individuals" list
-    // so that their histories can be replayed in the GUI
+    // Stream tagged individuals' life histories to the provided filename as they die or exit, instead of
+    // keeping them all for saveTaggedHistories (see TaggedHistoryStream)
+    void streamTaggedHistories(const std::string &savePath);
+    // Write the histories of the tagged individuals still alive and close the stream
+    void finishTaggedHistoryStream();
+    // Read individuals' life histories saved by saveTaggedHistories or streamTaggedHistories into the
+    // "individuals" list so that their histories can be replayed in the GUI
     void loadTaggedHistories(std::string loadPath);
     // Set the model's timestep and update fish to reflect the data
     // in the currently loaded life histories
@@ -185,6 +222,19 @@ public:
     float getFloat(ModelParamKey key) const;
     std::string getString(ModelParamKey key) const;
     const ModelConfigMap& getConfigMap() const;
+    // Resolved numeric parameters for per-fish code (kept in sync with the config map by setConfigValue)
+    const ModelParams &getParams() const { return params; }
+    // Override a config value, then re-resolve the parameters and movement strategy that depend on it
+    void setConfigValue(ModelParamKey key, const ConfigValue &value);
+    // The worker pool used for movement and growth; exposes per-thread load statistics
+    const ThreadPool &getThreadPool() const;
+    // (Re)build the per-thread movement engines for the configured AgentAwareness
+    void resolveMovementStrategy();
+    // The movement engine owned by the calling thread (fish-specific parameters are passed per call)
+    FishMovement &getMovementEngine();
+    // Reachable sets shared by high-awareness fish within a movement phase (see reachabilityBucketWidth)
+    ReachabilityCache &getReachabilityCache() { return reachabilityCache; }
+    const ReachabilityCache &getReachabilityCache() const { return reachabilityCache; }
 
     // add addhistory from fish???
     // void addHistoryBuffers();
@@ -193,9 +243,54 @@ public:
 
 private:
     ModelConfigMap configMap;
+    ModelParams params;
     unsigned long nextFishID;
     size_t maxThreads;
-    float recruitTagRate;
+    // Long-lived workers shared by moveAll and growAndDieAll (sized from maxThreads)
+    std::unique_ptr<ThreadPool> threadPool;
+    // One movement strategy instance per thread pool participant, indexed by ThreadPool::currentParticipant()
+    std::vector<std::unique_ptr<FishMovement>> movementEngines;
+    // Cleared at the start of every moveAll, since reachable sets depend on the current hydrology
+    ReachabilityCache reachabilityCache;
+    // Ids of living fish binned by location (counting sort in countAll), in ascending id order within each
+    // node's range, and followed by spare room for arrivals between recounts; MapNode::residentIds views these
+    std::vector<long> residentOrder;
+    // Start of each map node's block (range plus spare room) in residentOrder (size map.size() + 1)
+    std::vector<size_t> residentOffsets;
+    // Number of fish in each map node's range
+    std::vector<size_t> residentCounts;
+    // Per-slice, per-node fish counts in countAll, turned into each slice's write positions (slice-major)
+    std::vector<size_t> residentBins;
+    // Residency changes recorded by each pool participant during the current phase
+    std::vector<std::vector<ResidencyChange>> residencyChanges;
+    // Nodes touched by the residency changes being applied, and a per-node flag to collect each only once
+    std::vector<size_t> changedNodes;
+    std::vector<char> nodeChanged;
+    // Fork length buckets drawn for the current timestep's recruits
+    std::vector<size_t> recruitSizeBuckets;
+    // Open while tagged histories are being streamed
+    std::unique_ptr<TaggedHistoryStream> taggedHistoryStream;
+    // Tagged fish whose histories have not been streamed yet
+    std::vector<size_t> streamingFish;
+    // Picks the recruits to tag, within the tagged history memory budget
+    TagSampler tagSampler;
+    // Fish the tag sampler untagged in the current timestep
+    std::vector<size_t> untaggedFish;
+
+    // Index of location in map, or map.size() if it is not a node of this model's map
+    size_t mapSlotOf(const MapNode *location) const;
+    // The recruit size distribution for the current week
+    const std::vector<float> &currentRecruitSizeDist() const;
+    // Offer a new recruit to the tag sampler, tagging it (and untagging the fish it replaces) if chosen
+    void tagRecruit(size_t id);
+    // Untag sampled fish until the tagged histories fit in tagMemoryBudgetMB
+    void enforceTagBudget();
+    // Move the histories of tagged fish that are no longer alive to taggedHistoryStream
+    void streamFinishedHistories();
+    // loadTaggedHistories for files written by a TaggedHistoryStream
+    void loadStreamedTaggedHistories(const netCDF::NcFile &sourceFile);
+    // Point node n's residentIds at its range of residentOrder and recompute its density (and, with refreshRanks, its ranks)
+    void refreshNodeResidency(size_t n, bool refreshRanks);
 };
 #define __FISH_MODEL_CLS
 
@@ -1,4 +1,5 @@
 #include "model_config_map.h"
+#include "tag_sampler.h"
 
 #include <iostream>
 #include <ostream>
@@ -19,6 +20,15 @@ std::unordered_map<ModelParamKey, ConfigDefinition> ModelConfigMap::createDefaul
         {ModelParamKey::PmaxLowerLimit, {"pmaxLowerLimit", 0.2f}},
         {ModelParamKey::AgentAwareness, {"agentAwareness", "medium"}}, // options are "low", "medium", and "high"
         {ModelParamKey::MortalityInflectionPoint, {"mortalityInflectionPoint", 500.0f}},
+        {ModelParamKey::TemperatureFactors, {"temperatureFactors", "exact"}}, // options are "exact" and "table"
+        {ModelParamKey::ReachabilityBucketWidth, {"reachabilityBucketWidth", 0.0f}},
+        {ModelParamKey::CheckpointInterval, {"checkpointInterval", 0}},
+        {ModelParamKey::StreamTaggedHistories, {"streamTaggedHistories", 0}},
+        {ModelParamKey::RecruitTagRate, {"recruitTagRate", 0.0004f}},
+        {ModelParamKey::TagHabitats, {"tagHabitats", ""}}, // comma-separated habitat type names, empty for all
+        {ModelParamKey::TagReleaseWindows, {"tagReleaseWindows", ""}}, // comma-separated "start-end" timesteps, empty for all
+        {ModelParamKey::TagMemoryBudgetMB, {"tagMemoryBudgetMB", 0.0f}},
+        {ModelParamKey::CompactHistories, {"compactHistories", 0}},
     };
 }
 
@@ -88,4 +98,55 @@ void ModelConfigMap::validate() const {
         std::cerr << "Invalid value for AgentAwareness: " << agentAwareness << std::endl;
         throw std::runtime_error("Invalid value for AgentAwareness");
     }
-}
\ No newline at end of file
+    std::string temperatureFactors = getString(ModelParamKey::TemperatureFactors);
+    if (temperatureFactors != "exact" && temperatureFactors != "table") {
+        std::cerr << "Invalid value for TemperatureFactors: " << temperatureFactors << std::endl;
+        throw std::runtime_error("Invalid value for TemperatureFactors");
+    }
+    float reachabilityBucketWidth = getFloat(ModelParamKey::ReachabilityBucketWidth);
+    if (!(reachabilityBucketWidth >= 0.0f)) {
+        std::cerr << "Invalid value for ReachabilityBucketWidth: " << reachabilityBucketWidth << std::endl;
+        throw std::runtime_error("Invalid value for ReachabilityBucketWidth");
+    }
+    int checkpointInterval = getInt(ModelParamKey::CheckpointInterval);
+    if (checkpointInterval < 0) {
+        std::cerr << "Invalid value for CheckpointInterval: " << checkpointInterval << std::endl;
+        throw std::runtime_error("Invalid value for CheckpointInterval");
+    }
+    int streamTaggedHistories = getInt(ModelParamKey::StreamTaggedHistories);
+    if (streamTaggedHistories != 0 && streamTaggedHistories != 1) {
+        std::cerr << "Invalid value for StreamTaggedHistories: " << streamTaggedHistories << std::endl;
+        throw std::runtime_error("Invalid value for StreamTaggedHistories");
+    }
+    float recruitTagRate = getFloat(ModelParamKey::RecruitTagRate);
+    if (!(recruitTagRate >= 0.0f && recruitTagRate <= 1.0f)) {
+        std::cerr << "Invalid value for RecruitTagRate: " << recruitTagRate << std::endl;
+        throw std::runtime_error("Invalid value for RecruitTagRate");
+    }
+    float tagMemoryBudget = getFloat(ModelParamKey::TagMemoryBudgetMB);
+    if (!(tagMemoryBudget >= 0.0f)) {
+        std::cerr << "Invalid value for TagMemoryBudgetMB: " << tagMemoryBudget << std::endl;
+        throw std::runtime_error("Invalid value for TagMemoryBudgetMB");
+    }
+    int compactHistories = getInt(ModelParamKey::CompactHistories);
+    if (compactHistories != 0 && compactHistories != 1) {
+        std::cerr << "Invalid value for CompactHistories: " << compactHistories << std::endl;
+        throw std::runtime_error("Invalid value for CompactHistories");
+    }
+    // The lists throw if malformed
+    TagSelection::parseHabitats(getString(ModelParamKey::TagHabitats));
+    TagSelection::parseWindows(getString(ModelParamKey::TagReleaseWindows));
+}
+ModelParams::ModelParams(const ModelConfigMap& config)
+    : habitatMortalityMultiplier(config.getFloat(ModelParamKey::HabitatMortalityMultiplier)),
+      mortMin(config.getFloat(ModelParamKey::MortMin)),
+      mortMax(config.getFloat(ModelParamKey::MortMax)),
+      growthSlope(config.getFloat(ModelParamKey::GrowthSlope)),
+      growthSlopeNearshore(config.getFloat(ModelParamKey::GrowthSlopeNearshore)),
+      pmaxUpperLimit(config.getFloat(ModelParamKey::PmaxUpperLimit)),
+      pmaxUpperLimitNearshore(config.getFloat(ModelParamKey::PmaxUpperLimitNearshore)),
+      pmaxLowerLimit(config.getFloat(ModelParamKey::PmaxLowerLimit)),
+      mortalityInflectionPoint(config.getFloat(ModelParamKey::MortalityInflectionPoint)),
+      temperatureFactorTable(config.getString(ModelParamKey::TemperatureFactors) == "table"),
+      reachabilityBucketWidth(config.getFloat(ModelParamKey::ReachabilityBucketWidth)),
+      compactHistories(config.getInt(ModelParamKey::CompactHistories) != 0) {}
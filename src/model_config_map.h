@@ -25,7 +25,16 @@ enum class ModelParamKey {
     PmaxUpperLimitNearshore,
     PmaxLowerLimit,
     AgentAwareness,
-    MortalityInflectionPoint
+    MortalityInflectionPoint,
+    TemperatureFactors,
+    ReachabilityBucketWidth,
+    CheckpointInterval,
+    StreamTaggedHistories,
+    RecruitTagRate,
+    TagHabitats,
+    TagReleaseWindows,
+    TagMemoryBudgetMB,
+    CompactHistories
 };
 
 class ModelConfigMap {
@@ -46,4 +55,26 @@ public:
     void loadFromJson(const rapidjson::Document& d);
     std::string getFileKey(ModelParamKey key) const;
     void validate() const;
+};
+
+// The numeric parameters read by per-fish code, resolved once from a ModelConfigMap so that
+// hot paths read plain fields instead of doing a hash lookup and variant access per value
+struct ModelParams {
+    float habitatMortalityMultiplier;
+    float mortMin;
+    float mortMax;
+    float growthSlope;
+    float growthSlopeNearshore;
+    float pmaxUpperLimit;
+    float pmaxUpperLimitNearshore;
+    float pmaxLowerLimit;
+    float mortalityInflectionPoint;
+    // Interpolate the growth equation's temperature factors from a table instead of evaluating them
+    bool temperatureFactorTable;
+    // Width (m) of the swim range buckets that share high-awareness reachable sets (0 disables sharing)
+    float reachabilityBucketWidth;
+    // Record tagged histories in quantized form (see CompactHistory)
+    bool compactHistories;
+
+    explicit ModelParams(const ModelConfigMap& config);
 };
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include "nc_output.h"
+
+NcOutputWriter::NcOutputWriter(const std::string &path)
+    : target(path, netCDF::NcFile::FileMode::replace) {}
+
+netCDF::NcDim NcOutputWriter::addDim(const std::string &name, size_t size) {
+    return this->target.addDim(name, size);
+}
+
+// (values is null for empty variables, which are only defined)
+void NcOutputWriter::put(const std::string &name, const std::vector<netCDF::NcDim> &dims, const int *values) {
+    netCDF::NcVar var = this->target.addVar(name, netCDF::ncInt, dims);
+    if (values != nullptr) {
+        var.putVar(values);
+    }
+}
+
+void NcOutputWriter::put(const std::string &name, const std::vector<netCDF::NcDim> &dims, const float *values) {
+    netCDF::NcVar var = this->target.addVar(name, netCDF::ncFloat, dims);
+    if (values != nullptr) {
+        var.putVar(values);
+    }
+}
+
+std::vector<int> &NcOutputWriter::scratch(int) {
+    thread_local std::vector<int> buffer;
+    return buffer;
+}
+
+std::vector<float> &NcOutputWriter::scratch(float) {
+    thread_local std::vector<float> buffer;
+    return buffer;
+}
@@ -0,0 +1,60 @@
+#ifndef NC_OUTPUT_H
+#define NC_OUTPUT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <netcdf>
+
+/*
+ * Writes model output variables to a new NetCDF file (replacing any file at the path).
+ *
+ * Variables that are not already stored contiguously are gathered into a scratch buffer that
+ * belongs to the calling thread and is reused for every variable of every file written on it.
+ * Each variable is written as soon as it has been gathered, so a save needs at most one buffer
+ * per element type, no larger than the largest variable written so far; repeated saves
+ * (e.g. periodic checkpoints) do not grow the process's memory.
+ * The file is closed when the writer goes out of scope.
+ */
+class NcOutputWriter {
+public:
+    explicit NcOutputWriter(const std::string &path);
+
+    NcOutputWriter(const NcOutputWriter &) = delete;
+    NcOutputWriter &operator=(const NcOutputWriter &) = delete;
+
+    netCDF::NcFile &file() { return this->target; }
+    netCDF::NcDim addDim(const std::string &name, size_t size);
+
+    // Write a variable straight from contiguous values (as many as the dimensions hold)
+    void put(const std::string &name, const std::vector<netCDF::NcDim> &dims, const int *values);
+    void put(const std::string &name, const std::vector<netCDF::NcDim> &dims, const float *values);
+
+    // Write a variable of count values: fill(out) writes them to out[0, count)
+    template<typename T, typename Fill>
+    void putFilled(const std::string &name, const std::vector<netCDF::NcDim> &dims, size_t count, Fill fill) {
+        std::vector<T> &buffer = scratch(T());
+        buffer.resize(count);
+        fill(buffer.data());
+        this->put(name, dims, buffer.data());
+    }
+
+    // Write a variable of count values, value i being valueOf(i)
+    template<typename T, typename ValueOf>
+    void putEach(const std::string &name, const std::vector<netCDF::NcDim> &dims, size_t count, ValueOf valueOf) {
+        this->putFilled<T>(name, dims, count, [count, &valueOf](T *out) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = (T) valueOf(i);
+            }
+        });
+    }
+
+private:
+    netCDF::NcFile target;
+
+    // The calling thread's scratch buffers
+    static std::vector<int> &scratch(int);
+    static std::vector<float> &scratch(float);
+};
+
+#endif
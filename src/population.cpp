@@ -0,0 +1,71 @@
+#include "population.h"
+
+#include <stdexcept>
+#include <string>
+
+#include "fish.h"
+
+size_t Population::size() const {
+    return this->location.size();
+}
+
+void Population::clear() {
+    this->location.clear();
+    this->mass.clear();
+    this->forkLength.clear();
+    this->travel.clear();
+    this->spawnTime.clear();
+    this->status.clear();
+    this->massRank.clear();
+    this->arrivalTimeRank.clear();
+    this->residence.clear();
+    this->residentSlot.clear();
+}
+
+void Population::add(const Fish &fish) {
+    this->location.push_back(fish.location);
+    this->mass.push_back(fish.mass);
+    this->forkLength.push_back(fish.forkLength);
+    this->travel.push_back(fish.travel);
+    this->spawnTime.push_back(fish.spawnTime);
+    this->status.push_back(fish.status);
+    this->massRank.push_back(0);
+    this->arrivalTimeRank.push_back(0);
+    this->residence.push_back(nullptr);
+    this->residentSlot.push_back(0);
+}
+
+void Population::store(const Fish &fish) {
+    const size_t i = fish.id;
+    if (i >= this->size()) {
+        throw std::logic_error("Fish " + std::to_string(i) + " has no Population slot (it was never added)");
+    }
+    this->location[i] = fish.location;
+    this->mass[i] = fish.mass;
+    this->forkLength[i] = fish.forkLength;
+    this->travel[i] = fish.travel;
+    this->status[i] = fish.status;
+}
+
+void Population::rebuild(const std::vector<Fish> &individuals) {
+    this->clear();
+    for (const Fish &fish: individuals) {
+        this->add(fish);
+    }
+}
+
+void Population::verifyMirrors(const std::vector<Fish> &individuals) const {
+    if (individuals.size() != this->size()) {
+        throw std::logic_error("Population has " + std::to_string(this->size()) + " slots for "
+                               + std::to_string(individuals.size()) + " fish");
+    }
+    for (const Fish &fish: individuals) {
+        const size_t i = fish.id;
+        // Compared bitwise-equal (a stored copy, not a recomputation)
+        if (this->location[i] != fish.location || this->mass[i] != fish.mass
+            || this->forkLength[i] != fish.forkLength || this->travel[i] != fish.travel
+            || this->spawnTime[i] != fish.spawnTime || this->status[i] != fish.status) {
+            throw std::logic_error("Population slot " + std::to_string(i) + " does not match its fish");
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef POPULATION_H
+#define POPULATION_H
+
+#include <cstddef>
+#include <vector>
+
+class Fish;
+class MapNode;
+enum class FishStatus;
+
+/*
+ * Structure-of-arrays mirror of the per-fish fields that every timestep pass touches,
+ * indexed by fish id (the same index as Model::individuals).
+ *
+ * This is a copy, not the owner: Fish keeps location, mass, fork length, travel and status,
+ * and Fish::move and Fish::growAndDie still read and write them there. After each of those
+ * calls the model publishes the result with store(), so every update writes the fields twice.
+ * In exchange, Model::countAll, the living-list repacking in moveAll/growAndDieAll, and
+ * sampling read only from these arrays and stream through a few dense arrays instead of
+ * striding over whole Fish objects. Anything else that changes those Fish fields must call
+ * store() (or rebuild()); debug builds check the mirror against the fish every timestep.
+ */
+class Population {
+public:
+    std::vector<MapNode *> location;
+    std::vector<float> mass;
+    std::vector<float> forkLength;
+    // meters travelled during the last movement update
+    std::vector<float> travel;
+    std::vector<long> spawnTime;
+    std::vector<FishStatus> status;
+    // the mass rank of each fish among fish at its location (set by Model::countAll)
+    std::vector<int> massRank;
+    // the arrival time rank of each fish among fish at its location (set by Model::countAll)
+    std::vector<int> arrivalTimeRank;
+    // the location at which the model's residency tracking currently counts each fish (nullptr if not counted)
+    std::vector<MapNode *> residence;
+    // the position of each counted fish's id in Model::residentOrder
+    std::vector<size_t> residentSlot;
+
+    size_t size() const;
+    void clear();
+    // Add a slot for a newly created fish (fish.id must equal size())
+    void add(const Fish &fish);
+    // Copy fish's hot fields into its slot; throws std::logic_error for a fish that was never added
+    void store(const Fish &fish);
+    // Rebuild every slot from the full fish list (after bulk loads or history replays)
+    void rebuild(const std::vector<Fish> &individuals);
+    // Throw std::logic_error if any slot differs from its fish (a missed store())
+    void verifyMirrors(const std::vector<Fish> &individuals) const;
+};
+
+#endif
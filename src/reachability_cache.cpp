@@ -0,0 +1,94 @@
+#include "reachability_cache.h"
+
+#include <cmath>
+#include "map.h"
+
+void ReachabilityCache::reset(float bucketWidth) {
+    this->clear();
+    this->resetStats();
+    this->bucketWidth = bucketWidth;
+}
+
+long ReachabilityCache::bucketOf(float swimRange) const {
+    return (long) std::floor(swimRange / this->bucketWidth);
+}
+
+float ReachabilityCache::representativeRange(long bucket) const {
+    return ((float) bucket + 1.0f) * this->bucketWidth;
+}
+
+uint64_t ReachabilityCache::keyOf(const MapNode *start, long bucket) {
+    // Only nodes of the model's MapGraph are cached, so the graph index identifies the start node
+    return ((uint64_t) (uint32_t) start->graphIndex << 32) | (uint32_t) bucket;
+}
+
+ReachabilityCache::Shard &ReachabilityCache::shardFor(uint64_t key) {
+    // Fibonacci hashing, so neighboring nodes and buckets land in different shards
+    return this->shards[(key * 0x9E3779B97F4A7C15ULL) >> 58];
+}
+
+const std::vector<ReachableNode> *ReachabilityCache::find(const MapNode *start, long bucket) {
+    const uint64_t key = keyOf(start, bucket);
+    Shard &shard = this->shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        ++shard.misses;
+        return nullptr;
+    }
+    ++shard.hits;
+    return &it->second;
+}
+
+const std::vector<ReachableNode> *ReachabilityCache::insert(const MapNode *start, long bucket,
+                                                           std::vector<ReachableNode> &&reachable) {
+    const uint64_t key = keyOf(start, bucket);
+    Shard &shard = this->shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // References to unordered_map elements survive rehashing, so the set can be handed out after unlocking
+    return &shard.entries.emplace(key, std::move(reachable)).first->second;
+}
+
+void ReachabilityCache::clear() {
+    for (Shard &shard: this->shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+    }
+}
+
+size_t ReachabilityCache::getHits() const {
+    size_t hits = 0;
+    for (const Shard &shard: this->shards) {
+        hits += shard.hits;
+    }
+    return hits;
+}
+
+size_t ReachabilityCache::getMisses() const {
+    size_t misses = 0;
+    for (const Shard &shard: this->shards) {
+        misses += shard.misses;
+    }
+    return misses;
+}
+
+double ReachabilityCache::hitRate() const {
+    const size_t hits = this->getHits();
+    const size_t lookups = hits + this->getMisses();
+    return lookups == 0 ? 0.0 : (double) hits / (double) lookups;
+}
+
+void ReachabilityCache::resetStats() {
+    for (Shard &shard: this->shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.hits = 0;
+        shard.misses = 0;
+    }
+}
+
+void ReachabilityCache::printStats(std::ostream &out) const {
+    const size_t hits = this->getHits();
+    const size_t misses = this->getMisses();
+    out << "Reachability cache: " << hits + misses << " lookups; " << hits << " hits; " << misses << " misses; "
+        << this->hitRate() * 100.0 << "% hit rate" << std::endl;
+}
@@ -0,0 +1,80 @@
+#ifndef REACHABILITY_CACHE_H
+#define REACHABILITY_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+class MapNode;
+
+// A node reachable within one timestep's swim range, with the swim cost of the cheapest way there
+struct ReachableNode {
+    MapNode *node;
+    float cost;
+    // Reached directly from the start over a distributary hop, whose cost is capped at the swim range
+    // (see FishMovement::addNeighborAtSpeed); such a node is in reach of any swim range
+    bool cappedFirstHop;
+};
+
+/*
+ * Per-timestep store of the reachable node sets computed by high-awareness movement.
+ *
+ * Fish that start the hour in the same node with nearly the same fork length walk the same
+ * graph with nearly the same swim range. Swim ranges are quantized into buckets of a configurable
+ * width (reachabilityBucketWidth); the set is walked with the bucket's upper bound, so it holds
+ * everything any fish in the bucket can reach, and the first fish's walk can be shared by the rest.
+ * Only nodes and costs are stored. Each fish caps the capped first hops at its own swim range, drops
+ * the other candidates that cost more than that range, and applies its own fitness to the rest.
+ *
+ * Entries are only valid for the hydrology of the timestep they were computed in, so the model
+ * clears the cache before every movement phase. Lookups and insertions may come from any
+ * pool thread; the key space is split across independently locked shards.
+ */
+class ReachabilityCache {
+public:
+    // A bucket width of 0 disables the cache
+    void reset(float bucketWidth);
+    bool enabled() const { return this->bucketWidth > 0.0f; }
+    float getBucketWidth() const { return this->bucketWidth; }
+
+    // The bucket that swimRange falls in, and the swim range its shared sets are walked with (its upper bound)
+    long bucketOf(float swimRange) const;
+    float representativeRange(long bucket) const;
+
+    // The stored set for (start, bucket), or nullptr (counting a hit or a miss)
+    const std::vector<ReachableNode> *find(const MapNode *start, long bucket);
+    // Store the set for (start, bucket) unless another thread got there first; returns the stored set.
+    // The returned set stays valid until the next clear() or reset().
+    const std::vector<ReachableNode> *insert(const MapNode *start, long bucket, std::vector<ReachableNode> &&reachable);
+    // Drop all entries (statistics are kept)
+    void clear();
+
+    size_t getHits() const;
+    size_t getMisses() const;
+    // Fraction of lookups served from the cache (0 if there were none)
+    double hitRate() const;
+    void resetStats();
+    // Print the lookup, hit and miss counts and the hit rate
+    void printStats(std::ostream &out) const;
+
+private:
+    static constexpr size_t SHARD_COUNT = 64;
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, std::vector<ReachableNode> > entries;
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    float bucketWidth = 0.0f;
+    Shard shards[SHARD_COUNT];
+
+    static uint64_t keyOf(const MapNode *start, long bucket);
+    Shard &shardFor(uint64_t key);
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include "sampling.h"
+
+size_t sampleWeighted(const float *weights, size_t count) {
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        total += weights[i];
+    }
+    return sampleWeighted(count, [weights](size_t i) { return weights[i]; }, total);
+}
+
+AliasTable::AliasTable(const float *weights, size_t count) {
+    this->build(weights, count);
+}
+
+void AliasTable::build(const float *weights, size_t count) {
+    this->probability.assign(count, 1.0f);
+    this->alias.resize(count);
+    this->scaled.resize(count);
+    this->small.clear();
+    this->large.clear();
+    if (count == 0) {
+        return;
+    }
+
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        total += weights[i] > 0.0f ? weights[i] : 0.0f;
+    }
+    if (!(total > 0.0)) {
+        // Nothing to choose between: every column aliases to the last index
+        for (size_t i = 0; i < count; ++i) {
+            this->probability[i] = 0.0f;
+            this->alias[i] = (uint32_t) (count - 1);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        this->alias[i] = (uint32_t) i;
+        this->scaled[i] = (weights[i] > 0.0f ? weights[i] : 0.0f) * ((double) count / total);
+        (this->scaled[i] < 1.0 ? this->small : this->large).push_back((uint32_t) i);
+    }
+    // Fill each under-full column from an over-full one, which may then become under-full itself
+    while (!this->small.empty() && !this->large.empty()) {
+        const uint32_t s = this->small.back();
+        this->small.pop_back();
+        const uint32_t l = this->large.back();
+        this->probability[s] = (float) this->scaled[s];
+        this->alias[s] = l;
+        this->scaled[l] -= 1.0 - this->scaled[s];
+        if (this->scaled[l] < 1.0) {
+            this->large.pop_back();
+            this->small.push_back(l);
+        }
+    }
+    // Whatever is left is full up to rounding (probability stays 1)
+}
+
+size_t AliasTable::sample() const {
+    const size_t column = (size_t) GlobalRand::int_rand(0, (int) this->probability.size() - 1);
+    return unit_rand() < this->probability[column] ? column : this->alias[column];
+}
+
+void AliasTable::sample(size_t count, size_t *out) const {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = this->sample();
+    }
+}
+
+void sampleWeightedBatch(const float *weights, size_t weightCount, size_t count, size_t *out) {
+    // Building the table costs about as much as a few scans
+    constexpr size_t MIN_DRAWS_FOR_ALIAS = 4;
+    if (count < MIN_DRAWS_FOR_ALIAS) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = sampleWeighted(weights, weightCount);
+        }
+        return;
+    }
+    AliasTable(weights, weightCount).sample(count, out);
+}
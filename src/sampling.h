@@ -0,0 +1,89 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "util.h"
+
+/*
+ * Weighted sampling without normalizing the weights first.
+ *
+ * sampleWeighted is for a single draw from weights that change every time (e.g. one fish's
+ * movement candidates): it scans the weights once against a draw scaled by their total.
+ * AliasTable is for many draws from the same weights (e.g. recruit sizes): building it is
+ * O(n), after which every draw is O(1) regardless of the number of weights.
+ * Both draw from unit_rand/int_rand, so they follow the active RandomStreamScope.
+ */
+
+// Draw an index in [0, count) with probability weightOf(i) / totalWeight, where totalWeight is the sum of
+// weightOf over [0, count) and count > 0. Uses a single unit_rand draw. If rounding leaves the running sum
+// short of the draw, the last index with a positive weight (or count - 1 if there is none) is returned.
+// A total that is not positive (e.g. fitness that is negative everywhere) gets exactly what sample() does
+// with the weights divided by the total, so the choice does not depend on the sign of the weights.
+template <typename WeightOf>
+size_t sampleWeighted(size_t count, WeightOf weightOf, double totalWeight) {
+    if (!(totalWeight > 0.0)) {
+        const float r = unit_rand();
+        float acc = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            acc += (float) (weightOf(i) / totalWeight);
+            if (acc > r) {
+                return i;
+            }
+        }
+        return count - 1;
+    }
+    const double r = (double) unit_rand() * totalWeight;
+    double acc = 0.0;
+    size_t lastPositive = count - 1;
+    for (size_t i = 0; i < count; ++i) {
+        const double weight = weightOf(i);
+        acc += weight;
+        if (acc > r) {
+            return i;
+        }
+        if (weight > 0.0) {
+            lastPositive = i;
+        }
+    }
+    return lastPositive;
+}
+
+// As above, for a contiguous array of weights (the total is computed here)
+size_t sampleWeighted(const float *weights, size_t count);
+
+/*
+ * Walker's alias method (with Vose's linear-time construction).
+ * Each of the n columns holds the probability of keeping its own index and the index
+ * it otherwise aliases to; a draw picks a column uniformly and then flips that coin.
+ */
+class AliasTable {
+public:
+    AliasTable() = default;
+    AliasTable(const float *weights, size_t count);
+
+    // (Re)build for the given unnormalized weights, reusing this table's storage.
+    // If no weight is positive, every draw returns count - 1 (as sample() does).
+    void build(const float *weights, size_t count);
+    size_t size() const { return this->probability.size(); }
+    bool empty() const { return this->probability.empty(); }
+
+    // Draw one index (the table must not be empty)
+    size_t sample() const;
+    // Draw count indices into out
+    void sample(size_t count, size_t *out) const;
+
+private:
+    std::vector<float> probability;
+    std::vector<uint32_t> alias;
+    // Construction scratch: weights scaled to a mean of 1, and the columns below and above 1
+    std::vector<double> scaled;
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+};
+
+// Draw count indices from the same weights into out (builds an alias table when that is cheaper than scanning)
+void sampleWeightedBatch(const float *weights, size_t weightCount, size_t count, size_t *out);
+
+#endif
@@ -0,0 +1,68 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+SpatialIndex::SpatialIndex(const std::vector<MapNode *> &nodes, const std::function<bool(HabitatType)> &include) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        MapNode *node = nodes[i];
+        if (!include || include(node->type)) {
+            this->entries.push_back({node->x, node->y, (uint32_t) i, node});
+        }
+    }
+    this->build(0, this->entries.size(), 0);
+}
+
+void SpatialIndex::build(size_t begin, size_t end, unsigned depth) {
+    if (end - begin <= 1) {
+        return;
+    }
+    const size_t mid = begin + (end - begin) / 2;
+    const bool byX = depth % 2 == 0;
+    std::nth_element(this->entries.begin() + begin, this->entries.begin() + mid, this->entries.begin() + end,
+                     [byX](const Entry &a, const Entry &b) {
+                         const float ka = byX ? a.x : a.y;
+                         const float kb = byX ? b.x : b.y;
+                         return ka < kb || (ka == kb && a.order < b.order);
+                     });
+    this->build(begin, mid, depth + 1);
+    this->build(mid + 1, end, depth + 1);
+}
+
+MapNode *SpatialIndex::nearest(float x, float y) const {
+    float unused;
+    return this->nearest(x, y, unused);
+}
+
+MapNode *SpatialIndex::nearest(float x, float y, float &distanceOut) const {
+    Best best{nullptr, std::numeric_limits<float>::max()};
+    this->search(0, this->entries.size(), 0, x, y, best);
+    distanceOut = best.distance;
+    return best.entry != nullptr ? best.entry->node : nullptr;
+}
+
+void SpatialIndex::search(size_t begin, size_t end, unsigned depth, float x, float y, Best &best) const {
+    if (begin >= end) {
+        return;
+    }
+    const size_t mid = begin + (end - begin) / 2;
+    const Entry &entry = this->entries[mid];
+    // Same arithmetic as getDistance, so results match a linear scan exactly
+    const float dx = entry.x - x;
+    const float dy = entry.y - y;
+    const float distance = std::sqrt(dx * dx + dy * dy);
+    if (best.entry == nullptr || distance < best.distance
+        || (distance == best.distance && entry.order < best.entry->order)) {
+        best = {&entry, distance};
+    }
+
+    const float offset = depth % 2 == 0 ? x - entry.x : y - entry.y;
+    const bool nearIsLow = offset < 0.0f;
+    this->search(nearIsLow ? begin : mid + 1, nearIsLow ? mid : end, depth + 1, x, y, best);
+    // The far side can only hold a node at least |offset| away; keep a little slack for rounding
+    // in the distance, so that ties there are still found
+    if (std::fabs(offset) <= best.distance * (1.0f + 1e-5f) + std::numeric_limits<float>::min()) {
+        this->search(nearIsLow ? mid + 1 : begin, nearIsLow ? end : mid, depth + 1, x, y, best);
+    }
+}
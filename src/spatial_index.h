@@ -0,0 +1,52 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "map.h"
+
+/*
+ * A static 2d k-d tree over the x/y positions of a set of map nodes, for nearest-node queries
+ * (hydro node assignment while loading the map, hit-testing in the GUI).
+ *
+ * The tree is stored implicitly in one array: the median of each range is its root, split on x at
+ * even depths and on y at odd depths. Queries return exactly what a linear scan would: distances are
+ * computed the same way as getDistance, and ties go to the node that comes first in the indexed list.
+ * The nodes must not move while the index is in use.
+ */
+class SpatialIndex {
+public:
+    // Index the nodes whose habitat type passes include (all of them if include is empty)
+    explicit SpatialIndex(const std::vector<MapNode *> &nodes,
+                          const std::function<bool(HabitatType)> &include = nullptr);
+
+    size_t size() const { return this->entries.size(); }
+    bool empty() const { return this->entries.empty(); }
+
+    // The indexed node nearest to (x, y), or nullptr if the index is empty
+    MapNode *nearest(float x, float y) const;
+    // As above, also returning the distance to it
+    MapNode *nearest(float x, float y, float &distanceOut) const;
+
+private:
+    struct Entry {
+        float x;
+        float y;
+        // Position in the list the index was built from (for tie-breaking)
+        uint32_t order;
+        MapNode *node;
+    };
+
+    struct Best {
+        const Entry *entry;
+        float distance;
+    };
+
+    std::vector<Entry> entries;
+
+    void build(size_t begin, size_t end, unsigned depth);
+    void search(size_t begin, size_t end, unsigned depth, float x, float y, Best &best) const;
+};
+
+#endif
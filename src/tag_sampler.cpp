@@ -0,0 +1,186 @@
+#include "tag_sampler.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include "fish.h"
+#include "load.h"
+#include "model_config_map.h"
+#include "util.h"
+
+namespace {
+constexpr HabitatType ALL_HABITAT_TYPES[] = {
+    HabitatType::BlindChannel, HabitatType::Impoundment, HabitatType::LowTideTerrace, HabitatType::Distributary,
+    HabitatType::DistributaryEdge, HabitatType::Harbor, HabitatType::Nearshore
+};
+
+std::string trimmedLower(const std::string &s) {
+    const size_t begin = s.find_first_not_of(" \t");
+    const size_t end = s.find_last_not_of(" \t");
+    std::string out = begin == std::string::npos ? "" : s.substr(begin, end - begin + 1);
+    std::transform(out.begin(), out.end(), out.begin(), [](unsigned char c) { return std::tolower(c); });
+    return out;
+}
+
+std::vector<std::string> splitList(const std::string &list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        items.push_back(trimmedLower(item));
+    }
+    return items;
+}
+
+// Tag rates are applied in units of 1e-9
+constexpr uint64_t RATE_SCALE = 1000000000;
+}
+
+TagSelection TagSelection::fromConfig(const ModelConfigMap &config) {
+    TagSelection selection;
+    selection.rate = config.getFloat(ModelParamKey::RecruitTagRate);
+    selection.habitats = parseHabitats(config.getString(ModelParamKey::TagHabitats));
+    selection.windows = parseWindows(config.getString(ModelParamKey::TagReleaseWindows));
+    selection.memoryBudgetBytes = (size_t) (config.getFloat(ModelParamKey::TagMemoryBudgetMB) * 1024.0 * 1024.0);
+    return selection;
+}
+
+std::vector<HabitatType> TagSelection::parseHabitats(const std::string &list) {
+    std::vector<HabitatType> habitats;
+    for (const std::string &name: splitList(list)) {
+        if (name.empty()) {
+            continue;
+        }
+        const HabitatType *found = std::find_if(std::begin(ALL_HABITAT_TYPES), std::end(ALL_HABITAT_TYPES),
+            [&name](HabitatType t) { return trimmedLower(getHabitatTypeName(t)) == name; });
+        if (found == std::end(ALL_HABITAT_TYPES)) {
+            std::cerr << "Invalid habitat type in TagHabitats: " << name << std::endl;
+            throw std::runtime_error("Invalid value for TagHabitats");
+        }
+        habitats.push_back(*found);
+    }
+    return habitats;
+}
+
+std::vector<TagWindow> TagSelection::parseWindows(const std::string &list) {
+    std::vector<TagWindow> windows;
+    for (const std::string &range: splitList(list)) {
+        if (range.empty()) {
+            continue;
+        }
+        std::stringstream stream(range);
+        TagWindow window{};
+        char dash = 0;
+        if (!(stream >> window.begin >> dash >> window.end) || dash != '-' || !(stream >> std::ws).eof()
+            || window.begin < 0 || window.end <= window.begin) {
+            std::cerr << "Invalid release window in TagReleaseWindows: " << range << std::endl;
+            throw std::runtime_error("Invalid value for TagReleaseWindows");
+        }
+        windows.push_back(window);
+    }
+    return windows;
+}
+
+void TagSampler::configure(const TagSelection &newSelection) {
+    this->selection = newSelection;
+    this->rateFixed = (uint64_t) std::llround((double) newSelection.rate * RATE_SCALE);
+}
+
+void TagSampler::clear() {
+    this->eligible = 0;
+    this->candidates = 0;
+    this->reservoir = false;
+    this->capacity = 0;
+    this->members.clear();
+}
+
+void TagSampler::resume(uint64_t eligibleSoFar) {
+    this->clear();
+    this->eligible = eligibleSoFar;
+    // Recruits 0, and every c whose c * rate passes an integer (see offer)
+    if (eligibleSoFar > 0 && this->rateFixed > 0) {
+        this->candidates = (size_t) ((eligibleSoFar - 1) * this->rateFixed / RATE_SCALE + 1);
+    }
+}
+
+uint64_t TagSampler::eligibleAmong(const std::vector<Fish> &individuals) const {
+    const std::vector<TagWindow> &windows = this->selection.windows;
+    return (uint64_t) std::count_if(individuals.begin(), individuals.end(), [&windows](const Fish &f) {
+        return windows.empty() || std::any_of(windows.begin(), windows.end(), [&f](const TagWindow &w) {
+            return f.spawnTime >= w.begin && f.spawnTime < w.end;
+        });
+    });
+}
+
+bool TagSampler::isEligible(HabitatType entryHabitat, long time) const {
+    const std::vector<HabitatType> &habitats = this->selection.habitats;
+    if (!habitats.empty() && std::find(habitats.begin(), habitats.end(), entryHabitat) == habitats.end()) {
+        return false;
+    }
+    const std::vector<TagWindow> &windows = this->selection.windows;
+    return windows.empty() || std::any_of(windows.begin(), windows.end(), [time](const TagWindow &w) {
+        return time >= w.begin && time < w.end;
+    });
+}
+
+bool TagSampler::offer(size_t id, HabitatType entryHabitat, long time, size_t &evictOut) {
+    evictOut = NO_FISH;
+    if (!this->isEligible(entryHabitat, time)) {
+        return false;
+    }
+    // Systematic sampling: tag when the running count of eligible recruits times the rate passes an integer
+    // (in fixed point, so that e.g. a rate of 0.0004 tags exactly every 2500th recruit)
+    const uint64_t c = this->eligible++;
+    const bool picked = this->rateFixed > 0
+                        && (c == 0 || c * this->rateFixed / RATE_SCALE > (c - 1) * this->rateFixed / RATE_SCALE);
+    if (!picked) {
+        return false;
+    }
+    ++this->candidates;
+    if (this->reservoir && this->members.size() >= this->capacity) {
+        const size_t slot = (size_t) GlobalRand::int_rand(0, (int) std::min(this->candidates - 1, (size_t) INT32_MAX));
+        if (slot >= this->capacity) {
+            return false;
+        }
+        evictOut = this->members[slot];
+        this->members[slot] = id;
+        return true;
+    }
+    this->members.push_back(id);
+    return true;
+}
+
+void TagSampler::enforceBudget(const std::vector<Fish> &individuals, std::vector<size_t> &evictedOut) {
+    if (this->selection.memoryBudgetBytes == 0) {
+        return;
+    }
+    size_t kept = 0;
+    size_t bytes = 0;
+    for (size_t id: this->members) {
+        if (individuals[id].history != nullptr) {
+            this->members[kept++] = id;
+            bytes += historyBytes(individuals[id]);
+        }
+    }
+    this->members.resize(kept);
+    if (bytes <= this->selection.memoryBudgetBytes) {
+        return;
+    }
+    this->reservoir = true;
+    while (bytes > this->selection.memoryBudgetBytes && !this->members.empty()) {
+        const size_t slot = (size_t) GlobalRand::int_rand(0, (int) this->members.size() - 1);
+        const size_t id = this->members[slot];
+        bytes -= historyBytes(individuals[id]);
+        evictedOut.push_back(id);
+        this->members[slot] = this->members.back();
+        this->members.pop_back();
+    }
+    this->capacity = this->members.size();
+}
+
+size_t TagSampler::historyBytes(const Fish &fish) {
+    return fish.history != nullptr ? fish.history->bytes() : 0;
+}
@@ -0,0 +1,97 @@
+#ifndef TAG_SAMPLER_H
+#define TAG_SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "map.h"
+
+class Fish;
+class ModelConfigMap;
+
+// A half-open range [begin, end) of model timesteps
+struct TagWindow {
+    long begin;
+    long end;
+};
+
+// Which recruits are tagged (see the recruitTagRate, tagHabitats, tagReleaseWindows and
+// tagMemoryBudgetMB config parameters)
+struct TagSelection {
+    // Fraction of the eligible recruits that are tagged
+    float rate = 0.0f;
+    // Habitat types of the entry nodes whose recruits are eligible (any, if empty)
+    std::vector<HabitatType> habitats;
+    // Timesteps at which recruits are eligible (any, if empty)
+    std::vector<TagWindow> windows;
+    // Upper bound on the memory held by tagged histories (0 for no bound)
+    size_t memoryBudgetBytes = 0;
+
+    // Resolve the tagging parameters of config; throws std::runtime_error if a list is malformed
+    static TagSelection fromConfig(const ModelConfigMap &config);
+    // "Distributary,Blind channel" -> habitat types (names as getHabitatTypeName, case-insensitive)
+    static std::vector<HabitatType> parseHabitats(const std::string &list);
+    // "0-720,1440-2160" -> windows of timesteps
+    static std::vector<TagWindow> parseWindows(const std::string &list);
+};
+
+/*
+ * Picks the recruits whose life histories are recorded.
+ *
+ * Recruits that enter in one of the selected habitats during one of the release windows are
+ * eligible, and a fixed fraction of them is tagged by systematic sampling (every 1/rate-th eligible
+ * recruit, starting with the first), which draws no random numbers.
+ *
+ * With a memory budget, the histories of the fish tagged here are measured once per timestep. When
+ * they exceed the budget, randomly chosen tagged fish are untagged until they fit, and from then on
+ * the sampler keeps a reservoir sample: each further candidate replaces a random member with
+ * probability capacity / candidates so far, so the tagged fish remain a uniform sample of all the
+ * candidates while their number stays at what the budget allowed.
+ */
+class TagSampler {
+public:
+    static constexpr size_t NO_FISH = SIZE_MAX;
+
+    // Apply new parameters (keeping the fish tagged so far)
+    void configure(const TagSelection &selection);
+    // Forget all tagged fish and counts (when the model is reset)
+    void clear();
+    // Forget all tagged fish, and carry on counting as if eligibleSoFar recruits had been offered (when a saved
+    // state is loaded), so that the same recruits are tagged as in an uninterrupted run
+    void resume(uint64_t eligibleSoFar);
+    // The number of loaded fish whose recruit times fall in a release window (the entry habitats of
+    // loaded fish are not known, so tagHabitats is not applied)
+    uint64_t eligibleAmong(const std::vector<Fish> &individuals) const;
+
+    // Decide whether to tag recruit id, which entered at a node of habitat type entryHabitat at timestep time.
+    // If a tagged fish has to make room for it, evictOut is set to that fish (otherwise to NO_FISH).
+    bool offer(size_t id, HabitatType entryHabitat, long time, size_t &evictOut);
+    // Untag fish tagged here until their histories fit the memory budget, adding them to evictedOut;
+    // forgets fish whose histories were released elsewhere (e.g. streamed)
+    void enforceBudget(const std::vector<Fish> &individuals, std::vector<size_t> &evictedOut);
+
+    // Eligible recruits offered so far (saved with the model state)
+    uint64_t eligibleCount() const { return this->eligible; }
+    bool reservoirActive() const { return this->reservoir; }
+    size_t memberCount() const { return this->members.size(); }
+    // Bytes held by a tagged fish's history
+    static size_t historyBytes(const Fish &fish);
+
+private:
+    TagSelection selection;
+    // selection.rate in units of 1e-9
+    uint64_t rateFixed = 0;
+    // Eligible recruits seen so far
+    uint64_t eligible = 0;
+    // Recruits picked by systematic sampling so far (the reservoir's candidates)
+    size_t candidates = 0;
+    bool reservoir = false;
+    size_t capacity = 0;
+    // Fish tagged by this sampler that still hold their history
+    std::vector<size_t> members;
+
+    bool isEligible(HabitatType entryHabitat, long time) const;
+};
+
+#endif
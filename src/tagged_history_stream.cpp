@@ -0,0 +1,133 @@
+#include "tagged_history_stream.h"
+
+#include <iostream>
+
+namespace {
+// Buffered fish-hours that trigger a write
+constexpr size_t FLUSH_OBSERVATIONS = 1 << 18;
+// Chunk lengths along the unlimited dimensions (the library's defaults are tiny for appended data)
+constexpr size_t TRAJECTORY_CHUNK = 4096;
+constexpr size_t OBSERVATION_CHUNK = 1 << 16;
+
+const char *const TRAJECTORY_INT_VARS[] = {"fishId", "rowSize", "recruitTime", "taggedTime", "exitTime", "finalStatus"};
+const char *const TRAJECTORY_FLOAT_VARS[] = {"entryForkLength", "entryMass", "finalForkLength", "finalMass"};
+const char *const OBSERVATION_INT_VARS[] = {"time", "locationHistory"};
+const char *const OBSERVATION_FLOAT_VARS[] = {"growthHistory", "pmaxHistory", "mortalityHistory", "tempHistory",
+                                              "depthHistory", "flowSpeedHistory", "flowVelocityUHistory",
+                                              "flowVelocityVHistory"};
+
+template<typename T>
+void appendValues(const netCDF::NcFile &file, const char *name, size_t start, const std::vector<T> &values) {
+    if (!values.empty()) {
+        file.getVar(name).putVar(std::vector<size_t>{start}, std::vector<size_t>{values.size()}, values.data());
+    }
+}
+}
+
+TaggedHistoryStream::TaggedHistoryStream(const std::string &path)
+    : file(path, netCDF::NcFile::replace, netCDF::NcFile::nc4),
+      trajectories(0), observations(0), writtenTrajectories(0), writtenObservations(0) {
+    this->file.putAtt("Conventions", "CF-1.8");
+    this->file.putAtt("featureType", "trajectory");
+    const netCDF::NcDim n = this->file.addDim("n");
+    const netCDF::NcDim obs = this->file.addDim("obs");
+    auto addVar = [this](const char *name, const netCDF::NcType &type, const netCDF::NcDim &dim, size_t chunk) {
+        netCDF::NcVar var = this->file.addVar(name, type, dim);
+        std::vector<size_t> chunks{chunk};
+        var.setChunking(netCDF::NcVar::nc_CHUNKED, chunks);
+    };
+    for (const char *name: TRAJECTORY_INT_VARS) addVar(name, netCDF::ncInt, n, TRAJECTORY_CHUNK);
+    for (const char *name: TRAJECTORY_FLOAT_VARS) addVar(name, netCDF::ncFloat, n, TRAJECTORY_CHUNK);
+    for (const char *name: OBSERVATION_INT_VARS) addVar(name, netCDF::ncInt, obs, OBSERVATION_CHUNK);
+    for (const char *name: OBSERVATION_FLOAT_VARS) addVar(name, netCDF::ncFloat, obs, OBSERVATION_CHUNK);
+    this->file.getVar("fishId").putAtt("cf_role", "trajectory_id");
+    this->file.getVar("rowSize").putAtt("sample_dimension", "obs");
+    this->file.getVar("time").putAtt("long_name", "model timestep");
+    this->file.getVar("locationHistory").putAtt("long_name", "map node id");
+}
+
+TaggedHistoryStream::~TaggedHistoryStream() {
+    try {
+        this->flush();
+    } catch (const std::exception &e) {
+        std::cerr << "Could not write the remaining tagged histories: " << e.what() << std::endl;
+    }
+}
+
+void TaggedHistoryStream::append(Fish &fish) {
+    const FishHistory &h = *fish.history;
+    const size_t hours = h.length();
+    this->fishId.push_back((int) fish.id);
+    this->rowSize.push_back((int) hours);
+    this->recruitTime.push_back((int) fish.spawnTime);
+    this->taggedTime.push_back((int) fish.taggedTime);
+    this->exitTime.push_back((int) fish.exitTime);
+    this->entryForkLength.push_back(fish.entryForkLength);
+    this->entryMass.push_back(fish.entryMass);
+    this->finalForkLength.push_back(fish.forkLength);
+    this->finalMass.push_back(fish.mass);
+    this->finalStatus.push_back((int) fish.status);
+
+    for (size_t i = 0; i < hours; ++i) {
+        this->time.push_back((int) (fish.taggedTime + (long) i));
+    }
+    // (compact histories are decoded here)
+    this->location.resize(this->location.size() + hours);
+    h.copyLocations(0, hours, this->location.data() + this->location.size() - hours);
+    auto appendChannel = [&h, hours](HistoryChannel channel, std::vector<float> &values) {
+        values.resize(values.size() + hours);
+        h.copy(channel, 0, hours, values.data() + values.size() - hours);
+    };
+    appendChannel(HistoryChannel::Growth, this->growth);
+    appendChannel(HistoryChannel::Pmax, this->pmax);
+    appendChannel(HistoryChannel::Mortality, this->mortality);
+    appendChannel(HistoryChannel::Temp, this->temp);
+    appendChannel(HistoryChannel::Depth, this->depth);
+    appendChannel(HistoryChannel::FlowSpeed, this->flowSpeed);
+    appendChannel(HistoryChannel::FlowVelocityU, this->flowVelocityU);
+    appendChannel(HistoryChannel::FlowVelocityV, this->flowVelocityV);
+    fish.history.reset();
+    ++this->trajectories;
+    this->observations += hours;
+
+    if (this->time.size() >= FLUSH_OBSERVATIONS) {
+        this->flush();
+    }
+}
+
+void TaggedHistoryStream::flush() {
+    appendValues(this->file, "fishId", this->writtenTrajectories, this->fishId);
+    appendValues(this->file, "rowSize", this->writtenTrajectories, this->rowSize);
+    appendValues(this->file, "recruitTime", this->writtenTrajectories, this->recruitTime);
+    appendValues(this->file, "taggedTime", this->writtenTrajectories, this->taggedTime);
+    appendValues(this->file, "exitTime", this->writtenTrajectories, this->exitTime);
+    appendValues(this->file, "finalStatus", this->writtenTrajectories, this->finalStatus);
+    appendValues(this->file, "entryForkLength", this->writtenTrajectories, this->entryForkLength);
+    appendValues(this->file, "entryMass", this->writtenTrajectories, this->entryMass);
+    appendValues(this->file, "finalForkLength", this->writtenTrajectories, this->finalForkLength);
+    appendValues(this->file, "finalMass", this->writtenTrajectories, this->finalMass);
+    appendValues(this->file, "time", this->writtenObservations, this->time);
+    appendValues(this->file, "locationHistory", this->writtenObservations, this->location);
+    appendValues(this->file, "growthHistory", this->writtenObservations, this->growth);
+    appendValues(this->file, "pmaxHistory", this->writtenObservations, this->pmax);
+    appendValues(this->file, "mortalityHistory", this->writtenObservations, this->mortality);
+    appendValues(this->file, "tempHistory", this->writtenObservations, this->temp);
+    appendValues(this->file, "depthHistory", this->writtenObservations, this->depth);
+    appendValues(this->file, "flowSpeedHistory", this->writtenObservations, this->flowSpeed);
+    appendValues(this->file, "flowVelocityUHistory", this->writtenObservations, this->flowVelocityU);
+    appendValues(this->file, "flowVelocityVHistory", this->writtenObservations, this->flowVelocityV);
+    this->writtenTrajectories = this->trajectories;
+    this->writtenObservations = this->observations;
+
+    // Keep the buffers' capacity for the next batch
+    for (std::vector<int> *values: {&this->fishId, &this->rowSize, &this->recruitTime, &this->taggedTime,
+                                    &this->exitTime, &this->finalStatus, &this->time, &this->location}) {
+        values->clear();
+    }
+    for (std::vector<float> *values: {&this->entryForkLength, &this->entryMass, &this->finalForkLength,
+                                      &this->finalMass, &this->growth, &this->pmax, &this->mortality, &this->temp,
+                                      &this->depth, &this->flowSpeed, &this->flowVelocityU, &this->flowVelocityV}) {
+        values->clear();
+    }
+    this->file.sync();
+}
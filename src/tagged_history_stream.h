@@ -0,0 +1,73 @@
+#ifndef TAGGED_HISTORY_STREAM_H
+#define TAGGED_HISTORY_STREAM_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <netcdf>
+#include "fish.h"
+
+/*
+ * Writes tagged fish histories to a NetCDF-4 file while the model runs, instead of keeping every
+ * history in memory until the end (Model::saveTaggedHistories).
+ *
+ * The file holds CF discrete sampling geometry trajectories in contiguous ragged array form:
+ * per-fish variables along an unlimited "n" dimension (rowSize giving each fish's number of
+ * observations), and per-hour variables along an unlimited "obs" dimension, where each fish's hours
+ * are stored together, in the order of "n". So only whole histories can be written: the model
+ * appends a fish once it has died or exited (or when the run finishes), and its history is released.
+ * Appended histories are buffered and written in batches; flush() writes the batch and syncs the file.
+ * File size is proportional to the number of fish-hours recorded.
+ */
+class TaggedHistoryStream {
+public:
+    // Create (or replace) the file at path
+    explicit TaggedHistoryStream(const std::string &path);
+    // Writes whatever is still buffered
+    ~TaggedHistoryStream();
+
+    TaggedHistoryStream(const TaggedHistoryStream &) = delete;
+    TaggedHistoryStream &operator=(const TaggedHistoryStream &) = delete;
+
+    // Buffer fish's history and final state for writing, and release the history
+    void append(Fish &fish);
+    // Write the buffered histories and sync the file
+    void flush();
+
+    // Numbers of fish and fish-hours appended so far
+    size_t trajectoryCount() const { return this->trajectories; }
+    size_t observationCount() const { return this->observations; }
+
+private:
+    netCDF::NcFile file;
+    size_t trajectories;
+    size_t observations;
+    // Numbers of fish and fish-hours already in the file
+    size_t writtenTrajectories;
+    size_t writtenObservations;
+
+    // Buffered per-fish values
+    std::vector<int> fishId;
+    std::vector<int> rowSize;
+    std::vector<int> recruitTime;
+    std::vector<int> taggedTime;
+    std::vector<int> exitTime;
+    std::vector<float> entryForkLength;
+    std::vector<float> entryMass;
+    std::vector<float> finalForkLength;
+    std::vector<float> finalMass;
+    std::vector<int> finalStatus;
+    // Buffered per-hour values
+    std::vector<int> time;
+    std::vector<int> location;
+    std::vector<float> growth;
+    std::vector<float> pmax;
+    std::vector<float> mortality;
+    std::vector<float> temp;
+    std::vector<float> depth;
+    std::vector<float> flowSpeed;
+    std::vector<float> flowVelocityU;
+    std::vector<float> flowVelocityV;
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+
+// Set once by each worker thread; threads that aren't pool workers act as participant 0
+static thread_local size_t participantIndex = 0;
+
+ThreadPool::ThreadPool(size_t numThreads)
+    : currentTask(nullptr),
+      currentTaskCount(0),
+      generation(0UL),
+      workersPending(0),
+      firstError(nullptr),
+      stopping(false) {
+    numThreads = std::max((size_t) 1, numThreads);
+    this->ranges.reset(new WorkRange[numThreads]);
+    this->stats.resize(numThreads);
+    // The calling thread always participates, so only numThreads - 1 workers are needed
+    for (size_t i = 1; i < numThreads; ++i) {
+        this->workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->roundStart.notify_all();
+    for (std::thread &worker : this->workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return this->workers.size() + 1;
+}
+
+size_t ThreadPool::currentParticipant() {
+    return participantIndex;
+}
+
+void ThreadPool::run(size_t numTasks, const std::function<void(size_t)> &task) {
+    // Not worth waking anyone up for; run inline
+    if (numTasks <= 1 || this->workers.empty()) {
+        for (size_t i = 0; i < numTasks; ++i) {
+            task(i);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->currentTask = &task;
+        this->currentTaskCount = numTasks;
+        this->workersPending = this->workers.size();
+        this->firstError = nullptr;
+        ++this->generation;
+    }
+    this->roundStart.notify_all();
+
+    this->runShare(0, numTasks, task);
+
+    // Barrier: wait for every background worker to finish its share
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->roundDone.wait(lock, [this] { return this->workersPending == 0; });
+    this->currentTask = nullptr;
+    if (this->firstError) {
+        std::exception_ptr error = this->firstError;
+        this->firstError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::runShare(size_t workerIndex, size_t numTasks, const std::function<void(size_t)> &task) {
+    const size_t stride = this->size();
+    for (size_t i = workerIndex; i < numTasks; i += stride) {
+        try {
+            task(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->firstError) {
+                this->firstError = std::current_exception();
+            }
+        }
+    }
+}
+
+void ThreadPool::workerLoop(size_t workerIndex) {
+    participantIndex = workerIndex;
+    unsigned long seenGeneration = 0UL;
+    while (true) {
+        const std::function<void(size_t)> *task;
+        size_t numTasks;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->roundStart.wait(lock, [this, seenGeneration] {
+                return this->stopping || this->generation != seenGeneration;
+            });
+            if (this->stopping) {
+                return;
+            }
+            seenGeneration = this->generation;
+            task = this->currentTask;
+            numTasks = this->currentTaskCount;
+        }
+
+        this->runShare(workerIndex, numTasks, *task);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (--this->workersPending == 0) {
+            this->roundDone.notify_one();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)> &body) {
+    if (count == 0) {
+        return;
+    }
+    chunkSize = std::max((size_t) 1, chunkSize);
+    const size_t numChunks = (count + chunkSize - 1) / chunkSize;
+    const size_t participants = std::min(this->size(), numChunks);
+
+    // Hand each participant an equal, chunk-aligned contiguous slice to start on
+    for (size_t w = 0; w < participants; ++w) {
+        size_t firstChunk = (w * numChunks) / participants;
+        size_t lastChunk = ((w + 1) * numChunks) / participants;
+        this->ranges[w].next.store(firstChunk * chunkSize, std::memory_order_relaxed);
+        this->ranges[w].end = std::min(count, lastChunk * chunkSize);
+    }
+
+    this->run(participants, [&](size_t self) {
+        ThreadPoolWorkerStats &myStats = this->stats[self];
+        // Own slice first, then walk the other participants' slices looking for leftovers
+        for (size_t offset = 0; offset < participants; ++offset) {
+            size_t victim = (self + offset) % participants;
+            WorkRange &range = this->ranges[victim];
+            while (true) {
+                size_t begin = range.next.fetch_add(chunkSize, std::memory_order_relaxed);
+                if (begin >= range.end) {
+                    break;
+                }
+                size_t end = std::min(begin + chunkSize, range.end);
+                auto chunkStart = std::chrono::steady_clock::now();
+                body(begin, end);
+                auto chunkEnd = std::chrono::steady_clock::now();
+                myStats.busySeconds += std::chrono::duration<double>(chunkEnd - chunkStart).count();
+                myStats.itemsProcessed += end - begin;
+                if (victim != self) {
+                    ++myStats.chunksStolen;
+                }
+            }
+        }
+    });
+}
+
+const std::vector<ThreadPoolWorkerStats> &ThreadPool::getStats() const {
+    return this->stats;
+}
+
+void ThreadPool::resetStats() {
+    std::fill(this->stats.begin(), this->stats.end(), ThreadPoolWorkerStats());
+}
+
+void ThreadPool::printStats(std::ostream &out) const {
+    for (size_t i = 0; i < this->stats.size(); ++i) {
+        const ThreadPoolWorkerStats &s = this->stats[i];
+        out << "Thread " << i << ": " << s.busySeconds << "s busy; " << s.itemsProcessed << " items; "
+            << s.chunksStolen << " chunks stolen" << std::endl;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Accumulated per-thread activity across all parallelFor calls (one entry per pool participant)
+struct ThreadPoolWorkerStats {
+    // Wall time spent inside work chunks (s)
+    double busySeconds = 0.0;
+    // Number of items (fish) processed
+    size_t itemsProcessed = 0;
+    // Number of chunks taken from another participant's range
+    size_t chunksStolen = 0;
+};
+
+/*
+ * A fixed-size pool of long-lived worker threads.
+ * The pool is created once (see Model) and reused for every parallel phase,
+ * so no threads are spawned or joined per timestep.
+ * Work is handed off in "rounds": run() publishes a task, wakes the workers,
+ * participates as worker 0 itself, and returns once every worker has checked back in.
+ */
+class ThreadPool {
+public:
+    // Creates a pool with numThreads participants (numThreads - 1 background workers plus the caller)
+    explicit ThreadPool(size_t numThreads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // The number of threads (including the calling thread) that participate in run()
+    size_t size() const;
+    // The participant index of the calling thread: its worker index inside a pool's worker thread, 0 anywhere else
+    static size_t currentParticipant();
+
+    /*
+     * Calls task(i) for every i in [0, numTasks), spread across the pool's threads,
+     * and blocks until all calls have returned.
+     * If any call throws, the first exception is rethrown here after the round completes.
+     */
+    void run(size_t numTasks, const std::function<void(size_t)> &task);
+
+    /*
+     * Calls body(begin, end) over [0, count) in chunks of at most chunkSize items.
+     * Each participant starts on its own contiguous slice and, once that runs dry,
+     * steals chunks from the front of the other participants' slices, so a few
+     * expensive items can no longer hold up the whole round.
+     * Chunks for a given participant are always processed in increasing order.
+     */
+    void parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)> &body);
+
+    const std::vector<ThreadPoolWorkerStats> &getStats() const;
+    void resetStats();
+    // Print one line per participant with its busy time, item count and steal count
+    void printStats(std::ostream &out) const;
+
+private:
+    void workerLoop(size_t workerIndex);
+    // Runs this thread's share (every size()-th index starting at workerIndex) of the current round
+    void runShare(size_t workerIndex, size_t numTasks, const std::function<void(size_t)> &task);
+
+    // The not-yet-claimed part of one participant's slice in parallelFor.
+    // Claimed from the front with fetch_add, by the owner and thieves alike.
+    struct alignas(64) WorkRange {
+        std::atomic<size_t> next;
+        size_t end;
+    };
+
+    std::vector<std::thread> workers;
+    // One range per participant (allocated once, reused by every parallelFor)
+    std::unique_ptr<WorkRange[]> ranges;
+    // One entry per participant; each is only written by its own participant during a round
+    std::vector<ThreadPoolWorkerStats> stats;
+    std::mutex mutex;
+    // Signalled when a new round is published (or the pool is shutting down)
+    std::condition_variable roundStart;
+    // Signalled when the last background worker finishes its share of a round
+    std::condition_variable roundDone;
+    // State of the current round, guarded by mutex
+    const std::function<void(size_t)> *currentTask;
+    size_t currentTaskCount;
+    unsigned long generation;
+    size_t workersPending;
+    std::exception_ptr firstError;
+    bool stopping;
+};
+
+#endif
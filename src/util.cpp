@@ -7,17 +7,87 @@ std::default_random_engine GlobalRand::generator(initial_rd());
 std::uniform_real_distribution<float> GlobalRand::unit_dist;
 std::normal_distribution<float> GlobalRand::normal_dist;
 std::uniform_int_distribution<int> GlobalRand::int_dist;
+uint32_t GlobalRand::stream_seed = initial_rd();
+
+Philox4x32::Block Philox4x32::generate(Block counter, std::array<uint32_t, 2> key) {
+    constexpr uint32_t M0 = 0xD2511F53U;
+    constexpr uint32_t M1 = 0xCD9E8D57U;
+    constexpr uint32_t W0 = 0x9E3779B9U;
+    constexpr uint32_t W1 = 0xBB67AE85U;
+    for (int round = 0; round < 10; ++round) {
+        uint64_t p0 = (uint64_t) M0 * counter[0];
+        uint64_t p1 = (uint64_t) M1 * counter[2];
+        counter = {
+            (uint32_t) (p1 >> 32) ^ counter[1] ^ key[0],
+            (uint32_t) p1,
+            (uint32_t) (p0 >> 32) ^ counter[3] ^ key[1],
+            (uint32_t) p0
+        };
+        key[0] += W0;
+        key[1] += W1;
+    }
+    return counter;
+}
+
+// The stream active on this thread, or nullptr to use the global engine
+static thread_local RandomStreamScope::State *activeStream = nullptr;
+
+RandomStreamScope::RandomStreamScope(RandomStreamPhase phase, unsigned long fishId, long timestep)
+    : state{
+          {GlobalRand::streamSeed(), static_cast<uint32_t>(phase)},
+          {0U, (uint32_t) timestep, (uint32_t) fishId, (uint32_t) ((uint64_t) fishId >> 32)},
+          0UL,
+          {0U, 0U, 0U, 0U},
+          UINT64_MAX
+      },
+      previous(activeStream) {
+    activeStream = &this->state;
+}
+
+RandomStreamScope::~RandomStreamScope() {
+    activeStream = this->previous;
+}
+
+// Next 32 random bits from the active counter-based stream
+static uint32_t nextStreamBits(RandomStreamScope::State &stream) {
+    uint64_t blockIndex = stream.drawIndex / 4;
+    if (blockIndex != stream.blockIndex) {
+        Philox4x32::Block counter = stream.counter;
+        counter[0] = (uint32_t) blockIndex;
+        stream.block = Philox4x32::generate(counter, stream.key);
+        stream.blockIndex = blockIndex;
+    }
+    return stream.block[stream.drawIndex++ % 4];
+}
+
+// Uniform float in [0, 1) from the top 24 bits of a draw
+static float streamUnitRand(RandomStreamScope::State &stream) {
+    return (float) (nextStreamBits(stream) >> 8) * (1.0f / 16777216.0f);
+}
 
 
 float GlobalRand::unit_rand() {
+    if (activeStream != nullptr) {
+        return streamUnitRand(*activeStream);
+    }
     return GlobalRand::unit_dist(GlobalRand::generator);
 }
 
 float GlobalRand::unit_normal_rand() {
+    if (activeStream != nullptr) {
+        // Box-Muller; u1 is shifted into (0, 1] so the log is finite
+        float u1 = streamUnitRand(*activeStream) + (1.0f / 16777216.0f);
+        float u2 = streamUnitRand(*activeStream);
+        return std::sqrt(-2.0f * std::log(u1)) * std::cos(2.0f * (float) M_PI * u2);
+    }
     return GlobalRand::normal_dist(GlobalRand::generator);
 }
 
 int GlobalRand::int_rand(int min, int max) {
+    if (activeStream != nullptr) {
+        uint64_t range = (uint64_t) ((int64_t) max - (int64_t) min) + 1;
+        return (int) ((int64_t) min + (int64_t) (((uint64_t) nextStreamBits(*activeStream) * range) >> 32));
+    }
     GlobalRand::int_dist = std::uniform_int_distribution<int>(min, max);
     return GlobalRand::int_dist(GlobalRand::generator);
 }
@@ -28,10 +98,17 @@ void GlobalRand::reseed(const unsigned int seed) {
         return;
     }
     GlobalRand::generator = std::default_random_engine(seed);
+    GlobalRand::stream_seed = seed;
 }
 
 void GlobalRand::reseed_random() {
-    GlobalRand::generator = std::default_random_engine(std::random_device{}());
+    std::random_device rd;
+    GlobalRand::generator = std::default_random_engine(rd());
+    GlobalRand::stream_seed = rd();
+}
+
+uint32_t GlobalRand::streamSeed() {
+    return GlobalRand::stream_seed;
 }
 
 float unit_rand() {
@@ -1,8 +1,54 @@
 #ifndef __FISH_UTIL_H
 #define __FISH_UTIL_H
 
+#include <array>
+#include <cstdint>
 #include <random>
 
+/*
+ * Philox4x32-10 counter-based generator (Salmon et al. 2011, "Parallel random numbers: as easy as 1, 2, 3").
+ * Output is a pure function of (key, counter), so any draw can be reproduced without
+ * sharing or advancing generator state between threads.
+ */
+struct Philox4x32 {
+    using Block = std::array<uint32_t, 4>;
+    static Block generate(Block counter, std::array<uint32_t, 2> key);
+};
+
+// Identifies which per-fish update a random stream belongs to (part of the stream key)
+enum class RandomStreamPhase : uint32_t { Move = 1, GrowAndDie = 2 };
+
+/*
+ * While an instance is alive, unit_rand/unit_normal_rand/int_rand/sample/poisson on the
+ * current thread draw from the counter-based stream keyed by
+ * (rng seed, phase, fish id, timestep, draw index), instead of the shared global engine.
+ * Per-fish results are then identical no matter which thread (or how many threads) ran the fish.
+ * Scopes nest; the previous stream is restored on destruction.
+ */
+class RandomStreamScope {
+public:
+    RandomStreamScope(RandomStreamPhase phase, unsigned long fishId, long timestep);
+    ~RandomStreamScope();
+
+    RandomStreamScope(const RandomStreamScope &) = delete;
+    RandomStreamScope &operator=(const RandomStreamScope &) = delete;
+
+    struct State {
+        std::array<uint32_t, 2> key;
+        // counter[0] is the block index within the stream; the rest identify the stream
+        Philox4x32::Block counter;
+        // Index of the next 32-bit draw in this stream
+        uint64_t drawIndex;
+        // The most recently generated block, and its index
+        Philox4x32::Block block;
+        uint64_t blockIndex;
+    };
+
+private:
+    State state;
+    State *previous;
+};
+
 class GlobalRand {
 public:
     static float unit_rand();
@@ -12,8 +58,11 @@ public:
     static constexpr unsigned int USE_RANDOM_SEED = 0;
     static void reseed(unsigned int seed);
     static void reseed_random();
+    // Key for counter-based streams (see RandomStreamScope); set by reseed
+    static uint32_t streamSeed();
 
 private:
+    static uint32_t stream_seed;
     static std::default_random_engine generator;
     static std::uniform_real_distribution<float> unit_dist;
     static std::normal_distribution<float> normal_dist;
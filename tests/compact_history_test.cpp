@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "compact_history.h"
+#include "fish.h"
+#include "test_utilities.h"
+
+using Catch::Matchers::WithinAbs;
+using Catch::Matchers::WithinRel;
+
+TEST_CASE("Half precision conversion rounds to nearest even", "[compact_history]") {
+    // Exactly representable values survive
+    for (float value: {0.0f, 1.0f, -2.5f, 0.000061035156f, 65504.0f, 5.9604645e-8f}) {
+        REQUIRE(halfToFloat(floatToHalf(value)) == value);
+    }
+    REQUIRE(floatToHalf(1.0f) == 0x3c00);
+    REQUIRE(floatToHalf(-2.0f) == 0xc000);
+    // Ties go to the even significand
+    REQUIRE(floatToHalf(1.0f + 1.0f / 2048.0f) == 0x3c00);
+    REQUIRE(floatToHalf(1.0f + 3.0f / 2048.0f) == 0x3c02);
+    // Overflow saturates; tiny values flush to signed zero
+    REQUIRE(std::isinf(halfToFloat(floatToHalf(70000.0f))));
+    REQUIRE(floatToHalf(-1e-9f) == 0x8000);
+    REQUIRE(std::isnan(halfToFloat(floatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+
+    // The documented error bounds hold across the ranges of the history channels
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> exponent(-12.0f, 4.0f);
+    for (int i = 0; i < 100000; ++i) {
+        const float value = std::pow(10.0f, exponent(rng)) * (i % 2 == 0 ? 1.0f : -1.0f);
+        const float decoded = halfToFloat(floatToHalf(value));
+        if (std::fabs(value) >= 6.103515625e-5f) {
+            REQUIRE_THAT(decoded, WithinRel(value, 1.0f / 2048.0f));
+        } else {
+            REQUIRE_THAT(decoded, WithinAbs(value, 3e-8));
+        }
+    }
+}
+
+TEST_CASE("Compact histories decode to the recorded values within their precision", "[compact_history]") {
+    constexpr size_t HOURS = 1000;
+    auto node = createMapNode(0.0f, 0.0f);
+    Fish full(0, 0L, 45.0f, node.get());
+    Fish compact(1, 0L, 45.0f, node.get());
+    full.addHistoryBuffers();
+    compact.addHistoryBuffers(true);
+    std::mt19937 rng(11);
+    int location = 40000;
+    for (size_t t = 0; t < HOURS; ++t) {
+        // Mostly short moves, with an occasional jump across the map
+        location += t % 97 == 0 ? (int) (rng() % 200000) - 100000 : (int) (rng() % 11) - 5;
+        location = std::max(location, 0);
+        const float growth = ((float) (rng() % 2000) - 500.0f) * 1e-6f;
+        const float temp = 4.0f + (float) (rng() % 2000) * 0.0123f;
+        const FlowVelocity velocity((float) (rng() % 100) * 0.013f - 0.6f, (float) (rng() % 100) * -0.007f);
+        for (Fish *f: {&full, &compact}) {
+            f->history->append(location, growth, 0.2f + (float) (t % 60) * 0.01f, 0.0005f + (float) t * 1e-6f, temp,
+                               (float) (t % 300) * 0.05f, 0.3f, velocity);
+        }
+    }
+    const FishHistory &expected = *full.history;
+    const FishHistory &actual = *compact.history;
+    REQUIRE(actual.length() == HOURS);
+    REQUIRE(actual.bytes() * 2 < expected.bytes());
+
+    // Node ids are exact, decoded in ranges or one at a time
+    std::vector<int> locations(HOURS);
+    actual.copyLocations(0, HOURS, locations.data());
+    REQUIRE(locations == expected.location);
+    for (size_t i: {0, 63, 64, 65, 500, 999}) {
+        REQUIRE(actual.at(i).location == expected.location[i]);
+    }
+    std::vector<int> middle(100);
+    actual.copyLocations(130, 100, middle.data());
+    REQUIRE(std::equal(middle.begin(), middle.end(), expected.location.begin() + 130));
+
+    for (size_t i = 0; i < HOURS; ++i) {
+        const HistorySample a = actual.at(i);
+        const HistorySample e = expected.at(i);
+        REQUIRE_THAT(a.temp, WithinAbs(e.temp, 0.005 + 1e-5));
+        REQUIRE_THAT(a.growth, WithinAbs(e.growth, std::max(std::fabs(e.growth) / 2048.0, 3e-8)));
+        REQUIRE_THAT(a.pmax, WithinRel(e.pmax, 1.0f / 2048.0f));
+        REQUIRE_THAT(a.mortality, WithinRel(e.mortality, 1.0f / 2048.0f));
+        REQUIRE_THAT(a.depth, WithinAbs(e.depth, e.depth / 2048.0 + 1e-9));
+        REQUIRE_THAT(a.flowVelocity.u, WithinAbs(e.flowVelocity.u, std::fabs(e.flowVelocity.u) / 2048.0 + 3e-8));
+        REQUIRE_THAT(a.flowVelocity.v, WithinAbs(e.flowVelocity.v, std::fabs(e.flowVelocity.v) / 2048.0 + 3e-8));
+        // The deprecated flow speed is dropped
+        REQUIRE(a.flowSpeed == 0.0f);
+    }
+    std::vector<float> temps(HOURS);
+    actual.copy(HistoryChannel::Temp, 0, HOURS, temps.data());
+    REQUIRE(temps[123] == actual.at(123).temp);
+
+    // Replay back-calculates size from the decoded growth
+    full.mass = 5.0f;
+    compact.mass = 5.0f;
+    full.calculateMassHistory();
+    compact.calculateMassHistory();
+    REQUIRE(actual.mass.empty());
+    REQUIRE_THAT(compact.mass, WithinRel(full.mass, 0.002f));
+    REQUIRE_THAT(actual.at(HOURS - 1).mass, WithinRel(5.0f, 1.0f / 2048.0f));
+    REQUIRE_THAT(actual.at(500).mass, WithinRel(expected.at(500).mass, 0.002f));
+    // (fork lengths are drawn from mass with noise, so only check they were kept)
+    REQUIRE(actual.at(500).forkLength > 20.0f);
+}
@@ -0,0 +1,142 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "bioenergetics.h"
+#include "fish.h"
+#include "model.h"
+#include "test_utilities.h"
+
+// Relative tolerance for the single-precision batch kernel against the scalar (partly double) functions
+constexpr float BATCH_TOLERANCE = 1e-4f;
+
+TEST_CASE("evaluateBioenergeticsBatch matches getGrowth, getMortality and getFitness", "[fish][bioenergetics]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    Model model(hydroModel.get());
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> tempDist(0.5f, 30.0f);
+    std::uniform_real_distribution<float> costDist(0.0f, 3000.0f);
+    std::uniform_real_distribution<float> logDensityDist(-7.0f, -1.0f);
+
+    const HabitatType habitats[] = {HabitatType::Distributary, HabitatType::Nearshore, HabitatType::BlindChannel,
+                                    HabitatType::Impoundment};
+    for (float forkLength: {35.0f, 50.0f, 80.0f}) {
+        std::vector<std::unique_ptr<MapNode> > nodes;
+        std::vector<float> temp, pmax, cost, popDensity, habitatConst;
+        std::vector<float> expectedGrowth, expectedMortality, expectedFitness;
+        Fish fish(0UL, 0L, forkLength, nullptr);
+
+        for (int i = 0; i < 200; ++i) {
+            nodes.push_back(createMapNode(0.0f, 0.0f, habitats[i % 4]));
+            MapNode &node = *nodes.back();
+            // Include empty locations, whose log(density) is -inf
+            node.popDensity = i % 17 == 0 ? 0.0f : std::pow(10.0f, logDensityDist(rng));
+            hydroModel->tempValue = tempDist(rng);
+            const float c = costDist(rng);
+
+            temp.push_back(std::fmin(25.0f, hydroModel->tempValue));
+            pmax.push_back(fish.getPmax(model, node));
+            cost.push_back(c);
+            popDensity.push_back(node.popDensity);
+            habitatConst.push_back(habitatTypeMortalityConst(node.type, model.getParams().habitatMortalityMultiplier));
+            expectedGrowth.push_back(fish.getGrowth(model, node, c, pmax.back()));
+            expectedMortality.push_back(fish.getMortality(model, node));
+            expectedFitness.push_back(fish.getFitness(model, node, c));
+        }
+
+        const size_t n = temp.size();
+        std::vector<float> growth(n), mortality(n), fitness(n);
+        evaluateBioenergeticsBatch(model.getParams(), fish.mass, fish.forkLength, n, temp.data(), pmax.data(),
+                                   cost.data(), popDensity.data(), habitatConst.data(), growth.data(),
+                                   mortality.data(), fitness.data());
+
+        // Growth is a difference of terms that scale with consumption, so bound its error by that scale
+        const float growthScale = 0.303f * std::pow(fish.mass, -0.275f) * fish.mass;
+        for (size_t i = 0; i < n; ++i) {
+            INFO("forkLength " << forkLength << ", candidate " << i);
+            REQUIRE(std::fabs(growth[i] - expectedGrowth[i]) <= BATCH_TOLERANCE * growthScale);
+            REQUIRE(mortality[i] == Catch::Approx(expectedMortality[i]).epsilon(BATCH_TOLERANCE));
+            REQUIRE(std::fabs(fitness[i] - expectedFitness[i])
+                    <= BATCH_TOLERANCE * growthScale / expectedMortality[i]);
+        }
+    }
+}
+
+TEST_CASE("Fish::getFitnessBatch fills candidate fitness like getFitness", "[fish][bioenergetics]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    hydroModel->tempValue = 14.0f;
+    Model model(hydroModel.get());
+    auto a = createMapNode(0.0f, 0.0f, HabitatType::Distributary);
+    auto b = createMapNode(1.0f, 0.0f, HabitatType::Nearshore);
+    a->popDensity = 0.001f;
+    b->popDensity = 0.0001f;
+    Fish fish(0UL, 0L, 45.0f, a.get());
+
+    std::vector<std::tuple<MapNode *, float, float> > candidates = {
+        {a.get(), 0.0f, -1.0f}, {b.get(), 800.0f, -1.0f}, {a.get(), 2400.0f, -1.0f}
+    };
+    fish.getFitnessBatch(model, candidates.data(), candidates.size());
+    for (auto &[node, cost, fitness]: candidates) {
+        REQUIRE(fitness == Catch::Approx(fish.getFitness(model, *node, cost)).epsilon(BATCH_TOLERANCE));
+    }
+}
+
+TEST_CASE("tabulatedTemperatureFactors interpolates the exact factors", "[fish][bioenergetics]") {
+    for (float temp = 0.0f; temp <= 25.0f; temp += 0.0037f) {
+        INFO("temp " << temp);
+        const TemperatureFactors exact = exactTemperatureFactors(temp);
+        const TemperatureFactors table = tabulatedTemperatureFactors(temp);
+        // fTcons goes to 0 at CTM, so compare it against its peak value of 1
+        REQUIRE(std::fabs(table.consumption - exact.consumption) <= 1e-4);
+        REQUIRE(table.respiration == Catch::Approx(exact.respiration).epsilon(1e-4));
+        REQUIRE(table.egestion == Catch::Approx(exact.egestion).epsilon(1e-4));
+        REQUIRE(table.excretion == Catch::Approx(exact.excretion).epsilon(1e-4));
+    }
+    // Below the table range the exact factors are used
+    const TemperatureFactors cold = tabulatedTemperatureFactors(0.25f);
+    REQUIRE(cold.egestion == exactTemperatureFactors(0.25f).egestion);
+}
+
+TEST_CASE("temperatureFactors config selects the growth table", "[fish][bioenergetics]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    hydroModel->tempValue = 11.3f;
+    Model model(hydroModel.get());
+    REQUIRE_FALSE(model.getParams().temperatureFactorTable);
+    auto node = createMapNode(0.0f, 0.0f, HabitatType::Distributary);
+    node->popDensity = 0.001f;
+    Fish fish(0UL, 0L, 50.0f, node.get());
+
+    const float exactGrowth = fish.getGrowth(model, *node, 1200.0f);
+    model.setConfigValue(ModelParamKey::TemperatureFactors, std::string("table"));
+    REQUIRE(model.getParams().temperatureFactorTable);
+    const float tableGrowth = fish.getGrowth(model, *node, 1200.0f);
+    REQUIRE(tableGrowth == Catch::Approx(exactGrowth).epsilon(BATCH_TOLERANCE));
+
+    std::tuple<MapNode *, float, float> candidate{node.get(), 1200.0f, 0.0f};
+    fish.getFitnessBatch(model, &candidate, 1);
+    REQUIRE(std::get<2>(candidate) == Catch::Approx(fish.getFitness(model, *node, 1200.0f)).epsilon(BATCH_TOLERANCE));
+
+    // A batch reaching below the table is evaluated exactly throughout; one within it is interpolated
+    ModelParams exactParams = model.getParams();
+    exactParams.temperatureFactorTable = false;
+    auto evaluate = [&fish](const ModelParams &params, std::vector<float> temp) {
+        const size_t n = temp.size();
+        const std::vector<float> pmax(n, 0.6f), cost(n, 500.0f), popDensity(n, 0.001f), habitatConst(n, 1.0f);
+        std::vector<float> growth(n), mortality(n), fitness(n);
+        evaluateBioenergeticsBatch(params, fish.mass, fish.forkLength, n, temp.data(), pmax.data(), cost.data(),
+                                   popDensity.data(), habitatConst.data(), growth.data(), mortality.data(),
+                                   fitness.data());
+        return growth;
+    };
+    REQUIRE(evaluate(model.getParams(), {9.0f, 0.25f, 18.0f}) == evaluate(exactParams, {9.0f, 0.25f, 18.0f}));
+    const std::vector<float> tabulated = evaluate(model.getParams(), {9.0f, 18.0f});
+    const std::vector<float> exact = evaluate(exactParams, {9.0f, 18.0f});
+    REQUIRE(tabulated != exact);
+    REQUIRE(tabulated[1] == Catch::Approx(exact[1]).epsilon(BATCH_TOLERANCE));
+
+    REQUIRE_THROWS(model.setConfigValue(ModelParamKey::TemperatureFactors, std::string("approximate")));
+}
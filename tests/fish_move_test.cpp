@@ -4,10 +4,12 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include <memory>
+#include <stdexcept>
 
 #include "fish.h"
 #include "fish_movement.h"
 #include "fish_movement_factory.h"
+#include "fish_movement_high_awareness.h"
 #include "model.h"
 #include "test_utilities.h"
 #include "catch2/catch_approx.hpp"
@@ -26,6 +28,10 @@ public:
         }
         return 1.0f; // simple, deterministic fitness
     }
+
+    void getFitnessBatch(Model &model, std::tuple<MapNode *, float, float> *candidates, size_t n) override {
+        this->getFitnessEach(model, candidates, n);
+    }
 };
 
 struct MoveTestFixture {
@@ -40,10 +46,7 @@ struct MoveTestFixture {
     }
 
     void setAgentAwareness(const std::string &awareness) {
-        // Nasty cast to modify private/const member for testing without changing production code interface
-        const ModelConfigMap &config = model->getConfigMap();
-        ModelConfigMap &mutableConfig = const_cast<ModelConfigMap &>(config);
-        mutableConfig.set(ModelParamKey::AgentAwareness, awareness);
+        model->setConfigValue(ModelParamKey::AgentAwareness, awareness);
     }
 };
 
@@ -553,3 +556,72 @@ TEST_CASE("FishMovement getReachableNeighbors respects agentAwareness", "[fish_m
         REQUIRE_THAT(neighborNodes, Catch::Matchers::VectorContains(nodeE.get()));
     }
 }
+
+TEST_CASE("Model resolves the movement strategy once and reuses it for every fish", "[fish][move]") {
+    MoveTestFixture fixture;
+
+    FishMovement &engine = fixture.model->getMovementEngine();
+    REQUIRE(&engine == &fixture.model->getMovementEngine());
+    REQUIRE(dynamic_cast<FishMovementHighAwareness *>(&engine) == nullptr);
+
+    // Changing the config alone doesn't affect the engine until the strategy is resolved again
+    const ModelConfigMap &config = fixture.model->getConfigMap();
+    const_cast<ModelConfigMap &>(config).set(ModelParamKey::AgentAwareness, std::string("high"));
+    REQUIRE(&engine == &fixture.model->getMovementEngine());
+
+    fixture.model->resolveMovementStrategy();
+    REQUIRE(dynamic_cast<FishMovementHighAwareness *>(&fixture.model->getMovementEngine()) != nullptr);
+}
+
+TEST_CASE("FishMovement::determineNextLocationFor uses the fish's swim parameters and fitness", "[fish][move]") {
+    MoveTestFixture fixture;
+    auto nodeB = createMapNode(10.0f, 0.0f);
+    auto nodeC = createMapNode(20.0f, 0.0f);
+    connectNodes(fixture.node.get(), nodeB.get(), 10.0f);
+    connectNodes(nodeB.get(), nodeC.get(), 10.0f);
+
+    TestFish fish(3UL, 0L, 50.0f, fixture.node.get());
+    fish.fitnessFn = [&](MapNode &node) { return &node == nodeC.get() ? 5.0f : 1.0f; };
+    float swimSpeed = swimSpeedFromForkLength(fish.forkLength);
+
+    // Record the weights offered at each hop so the engine can be compared with a per-fish movement object
+    static std::vector<std::vector<float> > offered;
+    auto recorder = [](float *weights, unsigned weightsLen) -> unsigned {
+        offered.emplace_back(weights, weights + weightsLen);
+        return weightsLen - 1;
+    };
+    SampleOverrideHelper override(recorder);
+
+    offered.clear();
+    auto fitness = [&fish](Model &model, MapNode &node, float cost) { return fish.getFitness(model, node, cost); };
+    FishMovement perFish(*fixture.model, swimSpeed, swimSpeed * SECONDS_PER_TIMESTEP, fitness);
+    auto expected = perFish.determineNextLocation(fish.location);
+    auto expectedOffers = offered;
+
+    offered.clear();
+    auto actual = fixture.model->getMovementEngine().determineNextLocationFor(
+        fish, swimSpeed, swimSpeed * SECONDS_PER_TIMESTEP);
+
+    REQUIRE(actual == expected);
+    REQUIRE(offered == expectedOffers);
+    REQUIRE(actual.first == nodeC.get());
+}
+
+TEST_CASE("FishMovement::determineNextLocationFor lets go of the fish when movement throws", "[fish][move]") {
+    MoveTestFixture fixture;
+    auto nodeB = createMapNode(10.0f, 0.0f);
+    connectNodes(fixture.node.get(), nodeB.get(), 10.0f);
+    FishMovement engine(*fixture.model, 0.5f, 1800.0f, createMockFitnessCalculator(2.0f));
+    {
+        TestFish fish(3UL, 0L, 50.0f, fixture.node.get());
+        fish.fitnessFn = [](MapNode &) -> float { throw std::runtime_error("no fitness"); };
+        REQUIRE_THROWS_AS(engine.determineNextLocationFor(fish, 0.5f, 1800.0f), std::runtime_error);
+    }
+
+    // With the fish gone, the engine scores with its own fitness calculator again
+    engine.determineNextLocation(fixture.node.get());
+    REQUIRE_FALSE(engine.getAllReachableNeighborsInTimestep().empty());
+    for (const auto &[node, cost, fitness]: engine.getAllReachableNeighborsInTimestep()) {
+        REQUIRE(fitness == 2.0f);
+    }
+}
@@ -0,0 +1,239 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+
+#include "fish_movement.h"
+#include "fish_movement_high_awareness.h"
+#include "test_utilities.h"
+
+// Allocations made through the global operator new are only counted on a thread inside an
+// AllocationCounter's scope, so the replaced operators below measure just the code under test and not
+// Catch, other threads or anything else in this binary
+static thread_local size_t *activeAllocationCount = nullptr;
+
+namespace {
+class AllocationCounter {
+public:
+    AllocationCounter() : previous(activeAllocationCount) { activeAllocationCount = &this->count; }
+    ~AllocationCounter() { activeAllocationCount = this->previous; }
+    AllocationCounter(const AllocationCounter &) = delete;
+    AllocationCounter &operator=(const AllocationCounter &) = delete;
+
+    size_t allocations() const { return this->count; }
+
+private:
+    size_t count = 0;
+    size_t *previous;
+};
+}
+
+// GCC can't tell that the replaced operators below pair up malloc and free
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(std::size_t size) {
+    if (activeAllocationCount != nullptr) {
+        ++*activeAllocationCount;
+    }
+    if (void *p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    if (activeAllocationCount != nullptr) {
+        ++*activeAllocationCount;
+    }
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    operator delete(p);
+}
+
+namespace {
+// A small braided channel network: every node has two to four neighbors
+struct AllocationTestMap {
+    std::vector<std::unique_ptr<MapNode> > owned;
+    std::vector<MapNode *> nodes;
+
+    AllocationTestMap() {
+        for (int i = 0; i < 12; ++i) {
+            owned.push_back(createMapNode((float) (i % 4) * 30.0f, (float) (i / 4) * 20.0f,
+                                          HabitatType::Nearshore));
+            nodes.push_back(owned.back().get());
+        }
+        for (int i = 0; i < 12; ++i) {
+            if (i % 4 != 3) connectNodes(nodes[i], nodes[i + 1], 30.0f);
+            if (i < 8) connectNodes(nodes[i], nodes[i + 4], 20.0f);
+        }
+    }
+};
+
+// Run enough random walks from every node for the movement buffers to reach their working size
+void warmUp(FishMovement &movement, const std::vector<MapNode *> &starts) {
+    for (int repeat = 0; repeat < 200; ++repeat) {
+        for (MapNode *start: starts) movement.determineNextLocation(start);
+    }
+}
+
+size_t allocationsDuring(const std::function<void()> &fn) {
+    AllocationCounter counter;
+    fn();
+    return counter.allocations();
+}
+}
+
+TEST_CASE("FishMovement::determineNextLocation does not allocate once warmed up", "[fish_movement][allocation]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    hydroModel->uValue = 0.05f;
+    Model model(hydroModel.get());
+    AllocationTestMap testMap;
+
+    auto fitness = [](Model &, MapNode &node, float cost) { return 1.0f + node.x * 0.01f - cost * 0.001f; };
+
+    SECTION("over pointer edges") {
+        FishMovement movement(model, 0.5f, 1800.0f, fitness);
+        warmUp(movement, testMap.nodes);
+
+        REQUIRE(allocationsDuring([&] {
+            for (int repeat = 0; repeat < 20; ++repeat) {
+                for (MapNode *start: testMap.nodes) movement.determineNextLocation(start);
+            }
+        }) == 0);
+        REQUIRE_FALSE(movement.getAllReachableNeighborsInTimestep().empty());
+    }
+
+    SECTION("over a frozen MapGraph") {
+        model.mapGraph.build(testMap.nodes);
+        FishMovement movement(model, 0.5f, 1800.0f, fitness);
+        warmUp(movement, testMap.nodes);
+
+        REQUIRE(allocationsDuring([&] {
+            for (int repeat = 0; repeat < 20; ++repeat) {
+                for (MapNode *start: testMap.nodes) movement.determineNextLocation(start);
+            }
+        }) == 0);
+        model.mapGraph.clear();
+    }
+}
+
+TEST_CASE("FishMovement::appendReachableNeighbors reuses the caller's buffer", "[fish_movement][allocation]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    Model model(hydroModel.get());
+    AllocationTestMap testMap;
+    FishMovement movement(model, 0.5f, 1800.0f, createMockFitnessCalculator(1.0f));
+
+    std::vector<std::tuple<MapNode *, float, float> > out;
+    out.reserve(16);
+    REQUIRE(allocationsDuring([&] {
+        for (MapNode *start: testMap.nodes) {
+            out.clear();
+            movement.appendReachableNeighbors(out, start, 0.0f, start);
+        }
+    }) == 0);
+
+    // The by-value wrapper sees the same neighbors
+    out.clear();
+    movement.appendReachableNeighbors(out, testMap.nodes[5], 0.0f, testMap.nodes[5]);
+    REQUIRE(movement.getReachableNeighbors(testMap.nodes[5], 0.0f, testMap.nodes[5]) == out);
+    REQUIRE(out.size() == 4);
+}
+
+TEST_CASE("Fish::move does not allocate once the model's movement engine is warmed up", "[fish][move][allocation]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    hydroModel->uValue = 0.05f;
+    Model model(hydroModel.get());
+    AllocationTestMap testMap;
+    model.mapGraph.build(testMap.nodes);
+
+    for (const char *awareness: {"low", "medium", "high"}) {
+        INFO("agentAwareness " << awareness);
+        model.setConfigValue(ModelParamKey::AgentAwareness, std::string(awareness));
+        std::vector<Fish> fish;
+        for (size_t i = 0; i < testMap.nodes.size(); ++i) {
+            fish.emplace_back(i, 0L, 45.0f, testMap.nodes[i]);
+        }
+        for (int repeat = 0; repeat < 50; ++repeat) {
+            for (Fish &f: fish) f.move(model);
+        }
+
+        REQUIRE(allocationsDuring([&] {
+            for (int repeat = 0; repeat < 20; ++repeat) {
+                for (Fish &f: fish) f.move(model);
+            }
+        }) == 0);
+    }
+    model.mapGraph.clear();
+}
+
+TEST_CASE("FishMovementHighAwareness::determineNextLocation does not allocate once warmed up",
+          "[fish_movement][high_awareness][allocation]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    hydroModel->uValue = 0.05f;
+    Model model(hydroModel.get());
+    AllocationTestMap testMap;
+    model.mapGraph.build(testMap.nodes);
+
+    auto fitness = [](Model &, MapNode &node, float cost) { return 1.0f + node.x * 0.01f - cost * 0.001f; };
+    FishMovementHighAwareness movement(model, 0.5f, 1800.0f, fitness);
+    warmUp(movement, testMap.nodes);
+
+    REQUIRE(allocationsDuring([&] {
+        for (int repeat = 0; repeat < 20; ++repeat) {
+            for (MapNode *start: testMap.nodes) movement.determineNextLocation(start);
+        }
+    }) == 0);
+    model.mapGraph.clear();
+}
+
+TEST_CASE("AllocationCounter only counts its own thread inside its scope", "[allocation]") {
+    // (through a volatile pointer, so the compiler can't elide the pair)
+    auto allocate = [] {
+        int *volatile p = new int(1);
+        delete p;
+    };
+    allocate();
+    REQUIRE(allocationsDuring(allocate) == 1);
+    // (starting the thread may allocate here; its 100 allocations happen elsewhere)
+    REQUIRE(allocationsDuring([&allocate] {
+        std::thread other([&allocate] {
+            for (int i = 0; i < 100; ++i) allocate();
+        });
+        other.join();
+    }) < 100);
+}
@@ -6,6 +6,9 @@
 #include <catch2/catch_approx.hpp>
 #include <catch2/matchers/catch_matchers_vector.hpp>
 
+#include <map>
+#include <queue>
+#include <random>
 #include <vector>
 
 #include "fish_movement_high_awareness.h"
@@ -322,4 +325,219 @@ TEST_CASE("FishMovementHighAwareness start node exclusion", "[fish_movement][hig
         REQUIRE(reachableNodes.size() == 1);
         REQUIRE(reachableNodes[0] == nodeB.get());
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("FishMovementHighAwareness::getReachableNeighbors matches a reference Dijkstra", "[fish_movement][high_awareness]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    hydroModel->uValue = 0.1f;
+    Model testModel(hydroModel.get());
+
+    // A random planar-ish mesh with edges of very different lengths
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> coordinate(0.0f, 400.0f);
+    std::vector<std::unique_ptr<MapNode> > owned;
+    std::vector<MapNode *> nodes;
+    for (int i = 0; i < 150; ++i) {
+        owned.push_back(createMapNode(coordinate(rng), coordinate(rng), HabitatType::Nearshore));
+        nodes.push_back(owned.back().get());
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (size_t j = i + 1; j < nodes.size(); ++j) {
+            const float d = getDistance(nodes[i], nodes[j]);
+            if (d < 45.0f) connectNodes(nodes[i], nodes[j], d);
+        }
+    }
+
+    const float swimSpeed = 0.4f;
+    const float swimRange = 300.0f;
+    FishMovementHighAwareness mover(testModel, swimSpeed, swimRange, createMockFitnessCalculator(1.0f));
+    FishMovement singleHop(testModel, swimSpeed, swimRange, createMockFitnessCalculator(1.0f));
+
+    auto referenceCosts = [&](MapNode *start) {
+        std::map<MapNode *, float> best{{start, 0.0f}};
+        using Entry = std::pair<float, MapNode *>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<> > queue;
+        queue.emplace(0.0f, start);
+        while (!queue.empty()) {
+            auto [cost, node] = queue.top();
+            queue.pop();
+            if (cost > best[node]) continue;
+            for (auto &[next, total, fitness]: singleHop.getReachableNeighbors(node, cost, start)) {
+                auto it = best.find(next);
+                if (it == best.end() || total < it->second) {
+                    best[next] = total;
+                    queue.emplace(total, next);
+                }
+            }
+        }
+        best.erase(start);
+        return best;
+    };
+
+    size_t totalReached = 0;
+    for (bool frozen: {false, true}) {
+        if (frozen) testModel.mapGraph.build(nodes);
+        for (int i = 0; i < 150; i += 7) {
+            MapNode *start = nodes[i];
+            const std::map<MapNode *, float> expected = referenceCosts(start);
+            const auto actual = mover.getReachableNeighbors(start, 0.0f, start);
+            INFO("frozen " << frozen << ", start " << i);
+            REQUIRE(actual.size() == expected.size());
+            totalReached += actual.size();
+            for (const auto &[node, cost, fitness]: actual) {
+                REQUIRE(expected.count(node) == 1);
+                REQUIRE(cost == expected.at(node));
+            }
+        }
+    }
+    // Multi-hop walks, not just direct neighbors
+    REQUIRE(totalReached > 20 * 2 * 10);
+    testModel.mapGraph.clear();
+}
+
+TEST_CASE("FishMovementHighAwareness shares reachable sets through the ReachabilityCache", "[fish_movement][high_awareness][reachability_cache]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    hydroModel->uValue = 0.1f;
+    Model testModel(hydroModel.get());
+    REQUIRE_FALSE(testModel.getReachabilityCache().enabled());
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> coordinate(0.0f, 400.0f);
+    std::vector<std::unique_ptr<MapNode> > owned;
+    std::vector<MapNode *> nodes;
+    for (int i = 0; i < 120; ++i) {
+        owned.push_back(createMapNode(coordinate(rng), coordinate(rng), HabitatType::Nearshore));
+        nodes.push_back(owned.back().get());
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (size_t j = i + 1; j < nodes.size(); ++j) {
+            const float d = getDistance(nodes[i], nodes[j]);
+            if (d < 50.0f) connectNodes(nodes[i], nodes[j], d);
+        }
+    }
+    testModel.mapGraph.build(nodes);
+    MapNode *start = nodes[0];
+
+    // Speeds proportional to ranges, as for real fish (range = speed * SECONDS_PER_TIMESTEP)
+    auto moverFor = [&](float swimRange) {
+        return FishMovementHighAwareness(testModel, swimRange / SECONDS_PER_TIMESTEP, swimRange,
+                                         createMockFitnessCalculator(1.0f));
+    };
+    auto candidatesOf = [](const FishMovement &mover) {
+        std::map<MapNode *, float> costs;
+        for (const auto &[node, cost, fitness]: mover.getAllReachableNeighborsInTimestep()) {
+            costs[node] = cost;
+        }
+        return costs;
+    };
+
+    SECTION("disabled by default") {
+        auto mover = moverFor(310.0f);
+        mover.determineNextLocation(start);
+        REQUIRE(testModel.getReachabilityCache().getHits() + testModel.getReachabilityCache().getMisses() == 0);
+    }
+
+    SECTION("fish in the same bucket share one walk at the bucket's range") {
+        testModel.setConfigValue(ModelParamKey::ReachabilityBucketWidth, 50.0f);
+        ReachabilityCache &cache = testModel.getReachabilityCache();
+        REQUIRE(cache.enabled());
+        REQUIRE(cache.bucketOf(100.0f) == cache.bucketOf(140.0f));
+        REQUIRE(cache.representativeRange(cache.bucketOf(100.0f)) == 150.0f);
+
+        auto first = moverFor(100.0f);
+        auto second = moverFor(140.0f);
+        first.determineNextLocation(start);
+        second.determineNextLocation(start);
+        REQUIRE(cache.getMisses() == 1);
+        REQUIRE(cache.getHits() == 1);
+        REQUIRE(cache.hitRate() == 0.5);
+
+        // Both see what an uncached walk at the bucket's upper bound finds, less what costs more than
+        // their own swim range
+        auto reference = moverFor(150.0f);
+        const auto walked = reference.getReachableNeighbors(start, 0.0f, start);
+        for (auto [mover, range]: {std::pair<FishMovementHighAwareness *, float>{&first, 100.0f}, {&second, 140.0f}}) {
+            const auto shared = candidatesOf(*mover);
+            size_t inRange = 0;
+            for (const auto &[node, cost, fitness]: walked) {
+                if (cost <= range) {
+                    ++inRange;
+                    REQUIRE(shared.count(node) == 1);
+                    REQUIRE(shared.at(node) == Catch::Approx(cost));
+                }
+            }
+            REQUIRE(shared.size() == inRange);
+        }
+        REQUIRE(candidatesOf(first).size() > 5);
+        REQUIRE(candidatesOf(first).size() < candidatesOf(second).size());
+
+        // Another bucket or another start node is a separate entry
+        auto farther = moverFor(360.0f);
+        farther.determineNextLocation(start);
+        farther.determineNextLocation(nodes[1]);
+        REQUIRE(cache.getMisses() == 3);
+
+        // Entries only last for one movement phase
+        cache.clear();
+        first.determineNextLocation(start);
+        REQUIRE(cache.getMisses() == 4);
+        REQUIRE(cache.getHits() == 1);
+    }
+
+    SECTION("rejects a negative bucket width") {
+        REQUIRE_THROWS(testModel.setConfigValue(ModelParamKey::ReachabilityBucketWidth, -1.0f));
+    }
+    testModel.mapGraph.clear();
+}
+
+TEST_CASE("Shared reachable sets give each fish the candidates of its own walk", "[fish_movement][high_awareness][reachability_cache]") {
+    // Still water, so costs don't depend on swim speed and the shared walk can match each fish's own exactly
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    Model testModel(hydroModel.get());
+    testModel.setConfigValue(ModelParamKey::ReachabilityBucketWidth, 50.0f);
+
+    // Ranges of 120 and 130 are both in the bucket [100, 150), on either side of its midpoint
+    auto start = createMapNode(0.0f, 0.0f, HabitatType::Nearshore);
+    auto farDistributary = createMapNode(0.0f, 10.0f, HabitatType::Distributary);
+    auto nearDistributary = createMapNode(10.0f, 0.0f, HabitatType::Distributary);
+    auto pastNearDistributary = createMapNode(20.0f, 0.0f, HabitatType::Distributary);
+    auto channel = createMapNode(0.0f, -10.0f, HabitatType::Nearshore);
+    auto pastChannel = createMapNode(0.0f, -20.0f, HabitatType::Nearshore);
+    // Capped at any range in the bucket
+    connectNodes(start.get(), farDistributary.get(), 200.0f);
+    // Capped at 120, not at 130 (which reaches one node past it)
+    connectNodes(start.get(), nearDistributary.get(), 122.0f);
+    connectNodes(nearDistributary.get(), pastNearDistributary.get(), 5.0f);
+    // Past the midpoint: only reachable at 130
+    connectNodes(start.get(), channel.get(), 100.0f);
+    connectNodes(channel.get(), pastChannel.get(), 28.0f);
+    std::vector<MapNode *> nodes{start.get(), farDistributary.get(), nearDistributary.get(),
+                                 pastNearDistributary.get(), channel.get(), pastChannel.get()};
+    testModel.mapGraph.build(nodes);
+
+    for (float swimRange: {120.0f, 130.0f}) {
+        INFO("swimRange " << swimRange);
+        FishMovementHighAwareness mover(testModel, swimRange / SECONDS_PER_TIMESTEP, swimRange,
+                                        createMockFitnessCalculator(1.0f));
+        mover.determineNextLocation(start.get());
+        std::map<MapNode *, float> shared;
+        for (const auto &[node, cost, fitness]: mover.getAllReachableNeighborsInTimestep()) {
+            shared[node] = cost;
+        }
+        std::map<MapNode *, float> own;
+        for (const auto &[node, cost, fitness]: mover.getReachableNeighbors(start.get(), 0.0f, start.get())) {
+            own[node] = cost;
+        }
+        REQUIRE(shared.size() == own.size());
+        for (const auto &[node, cost]: own) {
+            REQUIRE(shared.count(node) == 1);
+            REQUIRE(shared.at(node) == Catch::Approx(cost));
+        }
+        REQUIRE(shared.at(farDistributary.get()) == Catch::Approx(swimRange));
+        REQUIRE(shared.count(pastNearDistributary.get()) == (swimRange > 125.0f ? 1u : 0u));
+        REQUIRE(shared.count(pastChannel.get()) == (swimRange > 125.0f ? 1u : 0u));
+    }
+    REQUIRE(testModel.getReachabilityCache().getMisses() == 1);
+    REQUIRE(testModel.getReachabilityCache().getHits() == 1);
+    testModel.mapGraph.clear();
+}
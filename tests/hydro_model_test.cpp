@@ -1,6 +1,11 @@
 #include <complex>
 #include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
 #include "hydro.h"
+#include "map_graph.h"
 #include "catch2/matchers/catch_matchers.hpp"
 #include "catch2/matchers/catch_matchers_floating_point.hpp"
 
@@ -117,3 +122,130 @@ TEST_CASE("HydroModel::calculateFlowSpeedScalar tests", "[hydro]") {
         REQUIRE_THAT(scalar, Catch::Matchers::WithinRel(1.0, 0.0001));
     }
 }
+
+TEST_CASE("HydroModel node environment snapshot matches direct computation", "[hydro]") {
+    std::vector<std::unique_ptr<MapNode> > owned;
+    std::vector<MapNode *> map;
+    const HabitatType types[] = {HabitatType::Distributary, HabitatType::BlindChannel, HabitatType::Impoundment,
+                                 HabitatType::Nearshore};
+    for (HabitatType type: types) {
+        owned.push_back(std::make_unique<MapNode>(type, 40.0f, 0.5f, 0.0f));
+        map.push_back(owned.back().get());
+    }
+    std::vector<std::vector<float> > depths = {{1.0f, 2.0f}, {0.5f, 0.6f}, {0.3f, 0.2f}, {3.0f, 4.0f}};
+    std::vector<std::vector<float> > temps = {{10.0f, 11.0f}, {12.0f, 13.0f}, {14.0f, 15.0f}, {16.0f, 17.0f}};
+    HydroModel hydroModel(map, depths, temps, 1.5f);
+    for (unsigned i = 0; i < 2; ++i) {
+        hydroModel.hydroNodes.emplace_back(i);
+        hydroModel.hydroNodes[i].us = {0.2f + i, -0.4f};
+        hydroModel.hydroNodes[i].vs = {0.1f, 0.3f * i};
+    }
+    // The last node has no hydro node and must keep being computed on demand
+    for (size_t i = 0; i + 1 < map.size(); ++i) {
+        map[i]->nearestHydroNodeID = i % 2;
+    }
+
+    // Expected values for each timestep, computed before anything is cached
+    auto sample = [&](long t) {
+        hydroModel.updateTime(t);
+        std::vector<std::vector<double> > values;
+        for (MapNode *node: map) {
+            FlowVelocity velocity = node->nearestHydroNodeID < hydroModel.hydroNodes.size()
+                                        ? hydroModel.getScaledFlowVelocityAt(*node)
+                                        : FlowVelocity();
+            values.push_back({
+                hydroModel.getDepth(*node), hydroModel.getTemp(*node), velocity.u, velocity.v,
+                hydroModel.getUnsignedFlowSpeedAt(*node), hydroModel.calculateFlowSpeedScalar(*node)
+            });
+        }
+        return values;
+    };
+    auto expected0 = sample(0);
+    auto expected1 = sample(1);
+
+    MapGraph graph;
+    graph.build(map);
+    hydroModel.attachMap(graph, nullptr);
+    REQUIRE(sample(1) == expected1);
+    REQUIRE(sample(0) == expected0);
+
+    // Between updateTime calls the getters serve the snapshot
+    hydroModel.hydroNodes[0].us[0] = 5.0f;
+    REQUIRE(hydroModel.getScaledFlowVelocityAt(*map[0]).u == (float) expected0[0][2]);
+    REQUIRE(sample(0) != expected0);
+
+    hydroModel.detachMap();
+    hydroModel.hydroNodes[0].us[0] = 0.2f;
+    REQUIRE(sample(0) == expected0);
+}
+
+TEST_CASE("HydroCache stores hydro nodes hour by hour", "[hydro][hydro_cache]") {
+    constexpr size_t NODE_COUNT = 3;
+    constexpr size_t HOURS = 5;
+    std::vector<DistribHydroNode> nodes;
+    for (size_t i = 0; i < NODE_COUNT; ++i) {
+        nodes.emplace_back((unsigned) (i + 10));
+        DistribHydroNode &node = nodes.back();
+        node.x = 100.0f * i;
+        node.y = -50.0f * i;
+        for (size_t t = 0; t < HOURS; ++t) {
+            node.us.push_back(0.1f * t + i);
+            node.vs.push_back(-0.2f * t + i);
+            node.wses.push_back(1.5f + 0.01f * t * i);
+            node.temps.push_back(8.0f + t + 0.5f * i);
+        }
+        node.minWse = node.wses[0];
+    }
+    const HydroCacheSources sources{1, 2, 3, 4};
+    const std::string path = (std::filesystem::temp_directory_path() / "hydro_cache_test.bin").string();
+    HydroCache::write(path, nodes, sources);
+
+    SECTION("values are read back per hour") {
+        HydroCache cache(path);
+        REQUIRE(cache.nodeCount() == NODE_COUNT);
+        REQUIRE(cache.timeCount() == HOURS);
+        REQUIRE(cache.sources() == sources);
+        REQUIRE_FALSE(cache.sources() == HydroCacheSources{1, 2, 3, 5});
+        for (size_t t = 0; t < HOURS; ++t) {
+            for (size_t i = 0; i < NODE_COUNT; ++i) {
+                REQUIRE(cache.u(t)[i] == nodes[i].us[t]);
+                REQUIRE(cache.v(t)[i] == nodes[i].vs[t]);
+                REQUIRE(cache.wse(t)[i] == nodes[i].wses[t]);
+                REQUIRE(cache.temp(t)[i] == nodes[i].temps[t]);
+            }
+        }
+        std::vector<DistribHydroNode> loaded;
+        cache.loadNodes(loaded);
+        REQUIRE(loaded.size() == NODE_COUNT);
+        for (size_t i = 0; i < NODE_COUNT; ++i) {
+            REQUIRE(loaded[i].id == nodes[i].id);
+            REQUIRE(loaded[i].x == nodes[i].x);
+            REQUIRE(loaded[i].y == nodes[i].y);
+            REQUIRE(loaded[i].minWse == nodes[i].minWse);
+            REQUIRE(loaded[i].us.empty());
+        }
+    }
+
+    SECTION("a HydroModel reads the current hour from the cache") {
+        HydroModel hydroModel(dummy_map_nodes, dummy_depths, dummy_temps, 1.0f);
+        hydroModel.useHydroCache(std::make_unique<HydroCache>(path));
+        REQUIRE(hydroModel.hydroNodes.size() == NODE_COUNT);
+        MapNode node(HabitatType::Distributary, 100.0f, 0.0f, 0.0f);
+        node.nearestHydroNodeID = 2;
+        hydroModel.updateTime(3);
+        REQUIRE(hydroModel.getCurrentU(node) == nodes[2].us[3]);
+        REQUIRE(hydroModel.getCurrentV(node) == nodes[2].vs[3]);
+        REQUIRE_THROWS_AS(hydroModel.updateTime(HOURS), std::out_of_range);
+    }
+
+    SECTION("other files are rejected") {
+        {
+            std::ofstream garbage(path, std::ios::binary | std::ios::trunc);
+            garbage << "not a hydro cache, just some text that is long enough to hold a header";
+        }
+        REQUIRE_THROWS_AS(HydroCache(path), std::runtime_error);
+        std::filesystem::remove(path);
+        REQUIRE_THROWS_AS(HydroCache(path), std::runtime_error);
+    }
+    std::filesystem::remove(path);
+}
@@ -3,7 +3,11 @@
 //
 
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <filesystem>
 #include <memory>
+#include <netcdf>
+#include <thread>
 #include "load.h"
 #include "map.h"
 
@@ -118,4 +122,60 @@ TEST_CASE("checkAndAddEdge functionality", "[edges]") {
         REQUIRE(target->edgesIn[0].source == source.get());
         REQUIRE(target->edgesIn[0].target == target.get());
     }
-}
\ No newline at end of file
+}
+// Run with: tests "[benchmark]"
+TEST_CASE("Startup cost of loadDistribHydro", "[.][benchmark][load]") {
+    constexpr size_t NODES = 2000;
+    constexpr size_t HOURS = 4000;
+    constexpr float MISSING = -9999.0f;
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string flowPath = (dir / "load_benchmark_flow.nc").string();
+    std::string wseTempPath = (dir / "load_benchmark_wse_temp.nc").string();
+
+    // Synthetic files with the layout of the Skagit hydro data: (time, node) variables, a few missing values
+    auto valueAt = [](size_t t, size_t n, float scale) { return scale * (float) ((t * 31 + n * 7) % 101); };
+    auto writeFile = [&](const std::string &path, const char *first, const char *second, float scale) {
+        netCDF::NcFile file(path, netCDF::NcFile::replace, netCDF::NcFile::nc4);
+        netCDF::NcDim time = file.addDim("time", HOURS);
+        netCDF::NcDim node = file.addDim("node", NODES);
+        netCDF::NcVar x = file.addVar("x", netCDF::ncFloat, node);
+        netCDF::NcVar y = file.addVar("y", netCDF::ncFloat, node);
+        std::vector<float> coords(NODES);
+        for (size_t n = 0; n < NODES; ++n) coords[n] = 10.0f * n;
+        x.putVar(coords.data());
+        y.putVar(coords.data());
+        std::vector<float> values(HOURS * NODES);
+        for (size_t t = 0; t < HOURS; ++t) {
+            for (size_t n = 0; n < NODES; ++n) values[t * NODES + n] = valueAt(t, n, scale);
+        }
+        values[5 * NODES + 3] = MISSING;
+        for (const char *name: {first, second}) {
+            netCDF::NcVar var = file.addVar(name, netCDF::ncFloat, std::vector<netCDF::NcDim>{time, node});
+            var.setFill(true, MISSING);
+            var.putVar(values.data());
+        }
+    };
+    writeFile(flowPath, "u", "v", 0.01f);
+    writeFile(wseTempPath, "wse", "temp", 0.1f);
+
+    std::vector<DistribHydroNode> loaded;
+    loadDistribHydro(flowPath, wseTempPath, loaded, std::thread::hardware_concurrency());
+    REQUIRE(loaded.size() == NODES);
+    REQUIRE(loaded[7].us[11] == valueAt(11, 7, 0.01f));
+    REQUIRE(loaded[7].temps[11] == valueAt(11, 7, 0.1f));
+    // The missing value is replaced by the one before it
+    REQUIRE(loaded[3].wses[5] == loaded[3].wses[4]);
+
+    BENCHMARK("loadDistribHydro, 1 thread") {
+        std::vector<DistribHydroNode> nodes;
+        loadDistribHydro(flowPath, wseTempPath, nodes, 1);
+        return nodes.size();
+    };
+    BENCHMARK("loadDistribHydro, all threads") {
+        std::vector<DistribHydroNode> nodes;
+        loadDistribHydro(flowPath, wseTempPath, nodes, std::thread::hardware_concurrency());
+        return nodes.size();
+    };
+    std::filesystem::remove(flowPath);
+    std::filesystem::remove(wseTempPath);
+}
@@ -0,0 +1,144 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+
+#include "fish_movement.h"
+#include "fish_movement_high_awareness.h"
+#include "map_graph.h"
+#include "test_utilities.h"
+
+TEST_CASE("MapGraph packs edges from both endpoints in edgesIn-then-edgesOut order", "[map_graph]") {
+    auto a = createMapNode(0.0f, 0.0f);
+    auto b = createMapNode(3.0f, 4.0f, HabitatType::BlindChannel);
+    auto c = createMapNode(0.0f, -2.0f);
+    connectNodes(a.get(), b.get(), 5.0f);
+    connectNodes(c.get(), a.get(), 2.0f);
+
+    MapGraph graph;
+    graph.build({a.get(), b.get(), c.get()});
+
+    REQUIRE(graph.nodeCount() == 3);
+    REQUIRE(graph.indexOf(b.get()) == 1);
+    REQUIRE(graph.type[1] == HabitatType::BlindChannel);
+    REQUIRE(graph.arcOffsets == std::vector<uint32_t>{0, 2, 3, 4});
+
+    // Node a: edgesIn (from c) first, then edgesOut (to b)
+    REQUIRE(graph.arcTarget[0] == 2);
+    REQUIRE(graph.arcLength[0] == 2.0f);
+    REQUIRE(graph.arcDirY[0] == -1.0);
+    REQUIRE(graph.arcTarget[1] == 1);
+    REQUIRE(graph.arcDirX[1] == 0.6);
+    REQUIRE(graph.arcDirY[1] == 0.8);
+    // Node b sees its edge back to a
+    REQUIRE(graph.arcTarget[2] == 0);
+    REQUIRE(graph.arcDirX[2] == -0.6);
+
+    auto stranger = createMapNode(0.0f, 0.0f);
+    REQUIRE(graph.indexOf(stranger.get()) == MapGraph::NOT_IN_GRAPH);
+
+    graph.clear();
+    REQUIRE(graph.indexOf(a.get()) == MapGraph::NOT_IN_GRAPH);
+    REQUIRE(a->graphIndex == MapGraph::NOT_IN_GRAPH);
+}
+
+TEST_CASE("Movement over a frozen MapGraph matches the pointer graph", "[map_graph][fish_movement]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    hydroModel->uValue = 0.3f;
+    hydroModel->vValue = -0.1f;
+    Model model(hydroModel.get());
+
+    std::vector<std::unique_ptr<MapNode>> owned;
+    std::vector<MapNode *> nodes;
+    for (int i = 0; i < 6; ++i) {
+        owned.push_back(createMapNode((float) (i % 3) * 40.0f, (float) (i / 3) * 25.0f,
+                                      i == 4 ? HabitatType::Nearshore : HabitatType::Distributary));
+        nodes.push_back(owned.back().get());
+    }
+    connectNodes(nodes[0], nodes[1], 40.0f);
+    connectNodes(nodes[1], nodes[2], 40.0f);
+    connectNodes(nodes[3], nodes[0], 25.0f);
+    connectNodes(nodes[1], nodes[4], 25.0f);
+    connectNodes(nodes[4], nodes[5], 40.0f);
+    connectNodes(nodes[2], nodes[5], 25.0f);
+    connectNodes(nodes[3], nodes[4], 40.0f);
+
+    auto fitness = [](Model &, MapNode &node, float cost) { return node.x + 2.0f * node.y + cost; };
+    FishMovement medium(model, 0.1f, 300.0f, fitness);
+    FishMovementHighAwareness high(model, 0.1f, 300.0f, fitness);
+
+    std::vector<std::vector<std::tuple<MapNode *, float, float>>> viaPointers;
+    for (MapNode *node: nodes) {
+        viaPointers.push_back(medium.getReachableNeighbors(node, 10.0f, nodes[0]));
+        viaPointers.push_back(high.getReachableNeighbors(node, 0.0f, node));
+    }
+
+    model.mapGraph.build(nodes);
+    std::vector<std::vector<std::tuple<MapNode *, float, float>>> viaGraph;
+    for (MapNode *node: nodes) {
+        viaGraph.push_back(medium.getReachableNeighbors(node, 10.0f, nodes[0]));
+        viaGraph.push_back(high.getReachableNeighbors(node, 0.0f, node));
+    }
+    model.mapGraph.clear();
+
+    size_t totalFound = 0;
+    for (const auto &result: viaPointers) totalFound += result.size();
+    REQUIRE(totalFound > 0);
+    REQUIRE(viaGraph == viaPointers);
+}
+
+TEST_CASE("Movement with the per-timestep arc water velocity table matches direct computation", "[map_graph][fish_movement]") {
+    std::vector<std::unique_ptr<MapNode>> owned;
+    std::vector<MapNode *> nodes;
+    for (int i = 0; i < 6; ++i) {
+        owned.push_back(createMapNode((float) (i % 3) * 40.0f, (float) (i / 3) * 25.0f,
+                                      i == 4 ? HabitatType::BlindChannel : HabitatType::Distributary));
+        owned.back()->area = 30.0f;
+        owned.back()->nearestHydroNodeID = i % 2;
+        nodes.push_back(owned.back().get());
+    }
+    connectNodes(nodes[0], nodes[1], 40.0f);
+    connectNodes(nodes[1], nodes[2], 40.0f);
+    connectNodes(nodes[3], nodes[0], 25.0f);
+    connectNodes(nodes[1], nodes[4], 25.0f);
+    connectNodes(nodes[4], nodes[5], 40.0f);
+    connectNodes(nodes[2], nodes[5], 25.0f);
+
+    std::vector<std::vector<float>> depths(nodes.size(), std::vector<float>{1.0f});
+    std::vector<std::vector<float>> temps(nodes.size(), std::vector<float>{12.0f});
+    HydroModel hydroModel(nodes, depths, temps, 0.5f);
+    for (unsigned i = 0; i < 2; ++i) {
+        hydroModel.hydroNodes.emplace_back(i);
+        hydroModel.hydroNodes[i].us = {i == 0 ? 0.07f : -0.03f};
+        hydroModel.hydroNodes[i].vs = {0.02f};
+    }
+    Model model(&hydroModel);
+    model.mapGraph.build(nodes);
+
+    auto fitness = [](Model &, MapNode &node, float cost) { return node.x + 2.0f * node.y + cost; };
+    FishMovement medium(model, 0.1f, 300.0f, fitness);
+    FishMovementHighAwareness high(model, 0.1f, 300.0f, fitness);
+    auto expand = [&] {
+        std::vector<std::vector<std::tuple<MapNode *, float, float>>> results;
+        for (MapNode *node: nodes) {
+            results.push_back(medium.getReachableNeighbors(node, 10.0f, nodes[0]));
+            results.push_back(high.getReachableNeighbors(node, 0.0f, node));
+        }
+        return results;
+    };
+
+    REQUIRE(hydroModel.getArcWaterVelocities(model.mapGraph) == nullptr);
+    auto direct = expand();
+
+    hydroModel.attachMap(model.mapGraph, nullptr);
+    const double *arcWaterVelocity = hydroModel.getArcWaterVelocities(model.mapGraph);
+    REQUIRE(arcWaterVelocity != nullptr);
+    // Reversing an arc flips the sign of the water velocity along it
+    REQUIRE(arcWaterVelocity[0] == -arcWaterVelocity[model.mapGraph.arcOffsets[3]]);
+    auto tabled = expand();
+    hydroModel.detachMap();
+    model.mapGraph.clear();
+
+    size_t totalFound = 0;
+    for (const auto &result: direct) totalFound += result.size();
+    REQUIRE(totalFound > 0);
+    REQUIRE(tabled == direct);
+}
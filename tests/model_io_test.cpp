@@ -0,0 +1,174 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "tagged_history_stream.h"
+#include "test_utilities.h"
+
+namespace {
+// A model over a map whose node ids match their indices (as saved files expect)
+void buildMap(Model &model, size_t nodeCount) {
+    for (size_t i = 0; i < nodeCount; ++i) {
+        MapNode *node = createMapNode((float) i, 0.0f).release();
+        node->id = (unsigned) i;
+        model.map.push_back(node);
+    }
+    model.recCounts = {0};
+}
+}
+
+TEST_CASE("TaggedHistoryStream takes over appended histories", "[model_io]") {
+    const std::string path = (std::filesystem::temp_directory_path() / "tagged_history_stream_test.nc").string();
+    auto node = createMapNode(0.0f, 0.0f);
+    Fish a(0, 5L, 45.0f, node.get());
+    Fish b(1, 7L, 50.0f, node.get());
+    auto record = [](Fish &f, int hours) {
+        f.addHistoryBuffers();
+        f.taggedTime = f.spawnTime;
+        FishHistory &h = *f.history;
+        h.location.assign(hours, 0);
+        h.growth.assign(hours, 0.01f);
+        h.pmax.assign(hours, 0.5f);
+        h.mortality.assign(hours, 0.0f);
+        h.temp.assign(hours, 9.0f);
+        h.depth.assign(hours, 1.0f);
+        h.flowSpeed_old.assign(hours, 0.0f);
+        h.flowVelocity.assign(hours, FlowVelocity(0.0f, 0.0f));
+    };
+    record(a, 3);
+    record(b, 1);
+
+    TaggedHistoryStream stream(path);
+    stream.append(a);
+    REQUIRE(a.history == nullptr);
+    REQUIRE(b.history != nullptr);
+    stream.append(b);
+    stream.flush();
+    REQUIRE(stream.trajectoryCount() == 2);
+    REQUIRE(stream.observationCount() == 4);
+}
+
+// Run with: tests "[benchmark]"
+TEST_CASE("Save and load time of states and tagged histories", "[.][benchmark][model_io]") {
+    constexpr size_t NODES = 5000;
+    constexpr size_t FISH = 200000;
+    constexpr size_t TAGGED = 2000;
+    constexpr long HOURS = 2000;
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    const std::string statePath = (dir / "model_io_benchmark_state.nc").string();
+    const std::string historyPath = (dir / "model_io_benchmark_histories.nc").string();
+
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    Model source(hydroModel.get());
+    buildMap(source, NODES);
+    source.time = HOURS - 1;
+    for (size_t id = 0; id < FISH; ++id) {
+        source.individuals.emplace_back(id, (long) (id % HOURS), 40.0f + (float) (id % 17),
+                                        source.map[id % NODES]);
+        Fish &f = source.individuals.back();
+        f.travel = (float) id;
+        f.lastTemp = (float) (id % 23);
+        if (id < TAGGED) {
+            // Tagged at recruitment, gone (alive or not) after a fish-specific number of hours
+            f.addHistoryBuffers();
+            f.taggedTime = f.spawnTime;
+            f.exitTime = std::min(f.spawnTime + 1 + (long) (id % 500), HOURS);
+            for (long t = f.taggedTime; t < f.exitTime; ++t) {
+                FishHistory &h = *f.history;
+                h.location.push_back((int) ((id + t) % NODES));
+                h.growth.push_back(0.001f);
+                h.pmax.push_back(0.5f);
+                h.mortality.push_back(0.0001f);
+                h.temp.push_back((float) (t % 20));
+                h.depth.push_back(1.0f);
+                h.flowSpeed_old.push_back(0.25f);
+                h.flowVelocity.emplace_back(0.1f, (float) t);
+            }
+        }
+    }
+    source.populationHistory.assign(HOURS, 0);
+    source.monitoringPoints = {source.map[1], source.map[2]};
+    source.monitoringHistory.assign(2, std::vector<MonitoringRecord>(HOURS, MonitoringRecord(3, 0.5f, 1.0f, 9.0f)));
+    source.saveState(statePath);
+    source.saveTaggedHistories(historyPath);
+
+    auto replayHydroModel = std::make_unique<MockHydroModel>();
+    Model loaded(replayHydroModel.get());
+    buildMap(loaded, NODES);
+
+    loaded.loadState(statePath);
+    REQUIRE(loaded.individuals.size() == FISH);
+    REQUIRE(loaded.individuals[12345].location == loaded.map[12345 % NODES]);
+    REQUIRE(loaded.individuals[12345].travel == 12345.0f);
+    REQUIRE(loaded.individuals[12345].lastTemp == source.individuals[12345].lastTemp);
+    REQUIRE(loaded.monitoringHistory[1][HOURS - 1].temp == 9.0f);
+
+    loaded.loadTaggedHistories(historyPath);
+    REQUIRE(loaded.individuals.size() == TAGGED);
+    const FishHistory &original = *source.individuals[777].history;
+    const FishHistory &replayed = *loaded.individuals[777].history;
+    REQUIRE(replayed.location == original.location);
+    REQUIRE(replayed.temp == original.temp);
+    REQUIRE(replayed.flowVelocity.back().v == original.flowVelocity.back().v);
+    REQUIRE(loaded.individuals[777].location == loaded.map[original.location.back()]);
+
+    BENCHMARK("saveState, 200k fish") {
+        source.saveState(statePath);
+        return source.individuals.size();
+    };
+    BENCHMARK("loadState, 200k fish") {
+        loaded.loadState(statePath);
+        return loaded.individuals.size();
+    };
+    BENCHMARK("loadTaggedHistories, 2000 fish x 2000 hours") {
+        loaded.loadTaggedHistories(historyPath);
+        return loaded.individuals.size();
+    };
+
+    // The same histories streamed as ragged arrays (in a different fish order) replay the same
+    const std::string streamPath = (dir / "model_io_benchmark_streamed.nc").string();
+    {
+        TaggedHistoryStream stream(streamPath);
+        for (size_t id = TAGGED; id-- > 0;) {
+            stream.append(source.individuals[id]);
+        }
+        REQUIRE(stream.observationCount() < HOURS * TAGGED / 4);
+    }
+    auto streamHydroModel = std::make_unique<MockHydroModel>();
+    Model streamed(streamHydroModel.get());
+    buildMap(streamed, NODES);
+    streamed.loadTaggedHistories(streamPath);
+    REQUIRE(streamed.individuals.size() == TAGGED);
+    const Fish &dense = loaded.individuals[777];
+    const Fish &ragged = streamed.individuals[TAGGED - 1 - 777];
+    REQUIRE(ragged.taggedTime == dense.taggedTime);
+    REQUIRE(ragged.history->location == dense.history->location);
+    REQUIRE(ragged.history->mass == dense.history->mass);
+    BENCHMARK("loadTaggedHistories, streamed") {
+        streamed.loadTaggedHistories(streamPath);
+        return streamed.individuals.size();
+    };
+
+    // Compact histories replay the same locations from less memory
+    auto compactHydroModel = std::make_unique<MockHydroModel>();
+    Model compact(compactHydroModel.get());
+    buildMap(compact, NODES);
+    compact.setConfigValue(ModelParamKey::CompactHistories, 1);
+    compact.loadTaggedHistories(historyPath);
+    const FishHistory &quantized = *compact.individuals[777].history;
+    std::vector<int> locations(quantized.length());
+    quantized.copyLocations(0, locations.size(), locations.data());
+    REQUIRE(locations == original.location);
+    REQUIRE(quantized.bytes() * 2 < loaded.individuals[777].history->bytes());
+    compact.setHistoryTimestep(compact.individuals[777].taggedTime);
+    REQUIRE(compact.individuals[777].location == compact.map[original.location.front()]);
+    BENCHMARK("loadTaggedHistories, compact") {
+        compact.loadTaggedHistories(historyPath);
+        return compact.individuals.size();
+    };
+}
@@ -0,0 +1,73 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <memory>
+
+#include "fish.h"
+#include "model.h"
+#include "model_config_map.h"
+#include "test_utilities.h"
+
+TEST_CASE("ModelParams resolves every numeric parameter from the config map", "[model_params]") {
+    ModelConfigMap config;
+    config.set(ModelParamKey::GrowthSlopeNearshore, 0.25f);
+    config.set(ModelParamKey::MortalityInflectionPoint, 123.0f);
+
+    ModelParams params(config);
+    REQUIRE(params.habitatMortalityMultiplier == config.getFloat(ModelParamKey::HabitatMortalityMultiplier));
+    REQUIRE(params.mortMin == config.getFloat(ModelParamKey::MortMin));
+    REQUIRE(params.mortMax == config.getFloat(ModelParamKey::MortMax));
+    REQUIRE(params.growthSlope == config.getFloat(ModelParamKey::GrowthSlope));
+    REQUIRE(params.growthSlopeNearshore == 0.25f);
+    REQUIRE(params.pmaxUpperLimit == config.getFloat(ModelParamKey::PmaxUpperLimit));
+    REQUIRE(params.pmaxUpperLimitNearshore == config.getFloat(ModelParamKey::PmaxUpperLimitNearshore));
+    REQUIRE(params.pmaxLowerLimit == config.getFloat(ModelParamKey::PmaxLowerLimit));
+    REQUIRE(params.mortalityInflectionPoint == 123.0f);
+}
+
+TEST_CASE("Model::setConfigValue keeps the resolved parameters in sync", "[model_params]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    Model model(hydroModel.get());
+    auto node = createMapNode(0.0f, 0.0f);
+    node->popDensity = 0.0001f;
+    Fish fish(0UL, 0L, 45.0f, node.get());
+
+    const float pmaxBefore = fish.getPmax(model, *node);
+    model.setConfigValue(ModelParamKey::PmaxUpperLimit, 0.6f);
+    REQUIRE(model.getParams().pmaxUpperLimit == 0.6f);
+    REQUIRE(model.getFloat(ModelParamKey::PmaxUpperLimit) == 0.6f);
+    REQUIRE(fish.getPmax(model, *node) < pmaxBefore);
+
+    const float mortalityBefore = fish.getMortality(model, *node);
+    model.setConfigValue(ModelParamKey::MortMax, 0.004f);
+    REQUIRE(fish.getMortality(model, *node) > mortalityBefore);
+}
+
+// Run with: tests "[benchmark]"
+TEST_CASE("Per-call cost of parameter lookups in getPmax/getMortality", "[.][benchmark][model_params]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    Model model(hydroModel.get());
+    auto node = createMapNode(0.0f, 0.0f);
+    node->popDensity = 0.0001f;
+    Fish fish(0UL, 0L, 45.0f, node.get());
+
+    // The eight lookups getPmax and getMortality used to make per call
+    BENCHMARK("ModelConfigMap::getFloat x8") {
+        return model.getFloat(ModelParamKey::GrowthSlope) + model.getFloat(ModelParamKey::PmaxUpperLimit)
+               + model.getFloat(ModelParamKey::PmaxLowerLimit) + model.getFloat(ModelParamKey::GrowthSlopeNearshore)
+               + model.getFloat(ModelParamKey::MortMin) + model.getFloat(ModelParamKey::MortMax)
+               + model.getFloat(ModelParamKey::HabitatMortalityMultiplier)
+               + model.getFloat(ModelParamKey::MortalityInflectionPoint);
+    };
+    BENCHMARK("ModelParams fields x8") {
+        const ModelParams &params = model.getParams();
+        return params.growthSlope + params.pmaxUpperLimit + params.pmaxLowerLimit + params.growthSlopeNearshore
+               + params.mortMin + params.mortMax + params.habitatMortalityMultiplier
+               + params.mortalityInflectionPoint;
+    };
+    BENCHMARK("Fish::getPmax") {
+        return fish.getPmax(model, *node);
+    };
+    BENCHMARK("Fish::getMortality") {
+        return fish.getMortality(model, *node);
+    };
+}
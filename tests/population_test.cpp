@@ -0,0 +1,248 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "fish.h"
+#include "model.h"
+#include "population.h"
+#include "test_utilities.h"
+
+TEST_CASE("Population mirrors fish hot fields", "[population]") {
+    auto node = createMapNode(0.0f, 0.0f);
+    std::vector<Fish> individuals;
+    individuals.emplace_back(0UL, 3L, 50.0f, node.get());
+    individuals.emplace_back(1UL, 4L, 60.0f, node.get());
+
+    Population population;
+    population.rebuild(individuals);
+    REQUIRE(population.size() == 2);
+    REQUIRE(population.spawnTime[1] == 4L);
+    REQUIRE(population.forkLength[1] == 60.0f);
+    REQUIRE(population.mass[0] == individuals[0].mass);
+
+    SECTION("store copies updated state into the fish's slot") {
+        individuals[1].mass = 12.5f;
+        individuals[1].travel = 100.0f;
+        individuals[1].status = FishStatus::Exited;
+        population.store(individuals[1]);
+        REQUIRE(population.mass[1] == 12.5f);
+        REQUIRE(population.travel[1] == 100.0f);
+        REQUIRE(population.status[1] == FishStatus::Exited);
+        REQUIRE(population.status[0] == FishStatus::Alive);
+    }
+
+    SECTION("verifyMirrors catches a fish changed without store") {
+        REQUIRE_NOTHROW(population.verifyMirrors(individuals));
+        individuals[0].travel = 5.0f;
+        REQUIRE_THROWS_AS(population.verifyMirrors(individuals), std::logic_error);
+        population.store(individuals[0]);
+        REQUIRE_NOTHROW(population.verifyMirrors(individuals));
+        individuals.emplace_back(2UL, 5L, 55.0f, node.get());
+        REQUIRE_THROWS_AS(population.verifyMirrors(individuals), std::logic_error);
+    }
+
+    SECTION("store rejects fish that were never added") {
+        Fish stranger(7UL, 0L, 50.0f, node.get());
+        REQUIRE_THROWS_AS(population.store(stranger), std::logic_error);
+        REQUIRE(population.size() == 2);
+    }
+}
+
+TEST_CASE("Model::countAll computes residency and ranks from the population arrays", "[population][model]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    Model model(hydroModel.get());
+    // The model owns (and deletes) its map nodes
+    MapNode *a = createMapNode(0.0f, 0.0f).release();
+    MapNode *b = createMapNode(1.0f, 0.0f).release();
+    a->area = 2.0f;
+    b->area = 1.0f;
+    model.map = {a, b};
+
+    const float masses[] = {3.0f, 1.0f, 2.0f, 5.0f};
+    MapNode *locations[] = {a, a, a, b};
+    for (unsigned long id = 0; id < 4; ++id) {
+        model.individuals.emplace_back(id, 0L, 50.0f, locations[id]);
+        model.individuals.back().mass = masses[id];
+        model.individuals.back().travel = (float) id;
+        model.population.add(model.individuals.back());
+        model.livingIndividuals.push_back(id);
+    }
+
+    model.countAll(false);
+
+    REQUIRE(a->residentIds.size() == 3);
+    REQUIRE(b->residentIds.size() == 1);
+    REQUIRE(a->popDensity == 1.5f);
+    REQUIRE(a->maxMass == 3.0f);
+    REQUIRE(b->maxMass == 5.0f);
+    // Ascending mass order at node a: fish 1, 2, 0
+    REQUIRE(model.population.massRank[1] == 0);
+    REQUIRE(model.population.massRank[2] == 1);
+    REQUIRE(model.population.massRank[0] == 2);
+    // Arrival ranks are reversed travel order
+    REQUIRE(model.population.arrivalTimeRank[0] == 2);
+    REQUIRE(model.population.arrivalTimeRank[2] == 0);
+}
+
+TEST_CASE("Model::countAll bins and ranks the same on several threads", "[population][model]") {
+    constexpr size_t NODE_COUNT = 64;
+    constexpr size_t FISH_COUNT = 5000;
+    std::vector<MapNode *> map;
+    for (size_t i = 0; i < NODE_COUNT; ++i) {
+        map.push_back(createMapNode((float) i, 0.0f, HabitatType::Distributary).release());
+        map.back()->area = 1.0f + (float) i;
+    }
+    std::vector<MapNode *> recPoints{map[0]};
+    std::vector<int> recCounts{0};
+    std::vector<std::vector<float> > recSizeDists{{1.0f}};
+    std::vector<std::vector<float> > depths(NODE_COUNT, std::vector<float>(1, 1.0f));
+    std::vector<std::vector<float> > temps(NODE_COUNT, std::vector<float>(1, 10.0f));
+    Model model(4, map, recPoints, recCounts, recSizeDists, depths, temps, 1.0f);
+    REQUIRE(model.getThreadPool().size() == 4);
+
+    std::mt19937 rng(99);
+    for (unsigned long id = 0; id < FISH_COUNT; ++id) {
+        // Leave the last node empty; round masses and travel so that ranks have ties
+        MapNode *location = map[rng() % (NODE_COUNT - 1)];
+        model.individuals.emplace_back(id, 0L, 50.0f, location);
+        model.individuals.back().mass = (float) (rng() % 50) * 0.1f;
+        model.individuals.back().travel = (float) (rng() % 20);
+        model.population.add(model.individuals.back());
+        // Every third fish is dead and must not be counted
+        if (id % 3 != 0) {
+            model.livingIndividuals.push_back(id);
+        }
+    }
+
+    model.countAll(false);
+
+    // Reference: the single-threaded per-node binning and sorting
+    std::unordered_map<MapNode *, std::vector<long> > expectedResidents;
+    for (size_t id: model.livingIndividuals) {
+        expectedResidents[model.population.location[id]].push_back((long) id);
+    }
+    for (MapNode *node: map) {
+        const std::vector<long> &expected = expectedResidents[node];
+        REQUIRE(std::vector<long>(node->residentIds.begin(), node->residentIds.end()) == expected);
+        REQUIRE(node->popDensity == (float) expected.size() / node->area);
+        float maxMass = 0.0f;
+        for (long id: expected) {
+            maxMass = std::max(maxMass, model.population.mass[id]);
+        }
+        REQUIRE(node->maxMass == maxMass);
+    }
+    REQUIRE(map.back()->residentIds.empty());
+    // Ranks are a permutation of 0..n-1 per node, ordered by mass (ascending) and travel (descending)
+    for (MapNode *node: map) {
+        const size_t n = node->residentIds.size();
+        std::vector<bool> seenMass(n, false), seenArrival(n, false);
+        bool ordered = true;
+        for (long id: node->residentIds) {
+            const int massRank = model.population.massRank[id];
+            const int arrivalRank = model.population.arrivalTimeRank[id];
+            REQUIRE((size_t) massRank < n);
+            REQUIRE((size_t) arrivalRank < n);
+            seenMass[massRank] = true;
+            seenArrival[arrivalRank] = true;
+            for (long other: node->residentIds) {
+                if (model.population.mass[other] < model.population.mass[id]) {
+                    ordered = ordered && model.population.massRank[other] < massRank;
+                }
+                if (model.population.travel[other] < model.population.travel[id]) {
+                    ordered = ordered && model.population.arrivalTimeRank[other] > arrivalRank;
+                }
+            }
+        }
+        REQUIRE(ordered);
+        REQUIRE(std::count(seenMass.begin(), seenMass.end(), false) == 0);
+        REQUIRE(std::count(seenArrival.begin(), seenArrival.end(), false) == 0);
+    }
+}
+
+TEST_CASE("Incremental residency matches a full recount through movement and mortality", "[population][model]") {
+    constexpr size_t NODE_COUNT = 40;
+    constexpr size_t FISH_COUNT = 2000;
+    std::vector<MapNode *> map;
+    for (size_t i = 0; i < NODE_COUNT; ++i) {
+        map.push_back(createMapNode(100.0f * (float) i, 0.0f, HabitatType::Distributary).release());
+        map.back()->area = 50.0f;
+        if (i > 0) {
+            connectNodes(map[i - 1], map[i], 100.0f);
+        }
+    }
+    std::vector<MapNode *> recPoints{map[0]};
+    std::vector<int> recCounts{0};
+    std::vector<std::vector<float> > recSizeDists{{1.0f}};
+    std::vector<std::vector<float> > depths(NODE_COUNT, std::vector<float>(1, 1.0f));
+    std::vector<std::vector<float> > temps(NODE_COUNT, std::vector<float>(1, 10.0f));
+    Model model(4, map, recPoints, recCounts, recSizeDists, depths, temps, 1.0f);
+    // Still water everywhere (movement reads flow velocities from the nearest hydro node)
+    model.hydroModel.hydroNodes.emplace_back(0);
+    model.hydroModel.hydroNodes.back().us = {0.0f};
+    model.hydroModel.hydroNodes.back().vs = {0.0f};
+    for (MapNode *node: map) {
+        node->nearestHydroNodeID = 0;
+    }
+    model.hydroModel.updateTime(0);
+
+    std::mt19937 rng(7);
+    for (unsigned long id = 0; id < FISH_COUNT; ++id) {
+        model.individuals.emplace_back(id, 0L, 50.0f, map[rng() % NODE_COUNT]);
+        model.population.add(model.individuals.back());
+        model.livingIndividuals.push_back(id);
+    }
+    model.countAll(false);
+
+    size_t moved = 0;
+    for (int step = 0; step < 5; ++step) {
+        std::vector<MapNode *> before(model.population.location);
+        model.moveAll();
+        for (size_t id: model.livingIndividuals) {
+            moved += model.population.location[id] != before[id];
+        }
+        model.applyResidencyChanges(false);
+        REQUIRE_NOTHROW(model.verifyResidency());
+        model.growAndDieAll();
+        model.applyResidencyChanges(true);
+        REQUIRE_NOTHROW(model.verifyResidency());
+    }
+    REQUIRE(moved > 0);
+    REQUIRE(model.livingIndividuals.size() < FISH_COUNT);
+
+    // Membership and ranks after the incremental updates are what a full recount produces
+    std::vector<std::vector<long> > tracked;
+    for (MapNode *node: map) {
+        tracked.emplace_back(node->residentIds.begin(), node->residentIds.end());
+    }
+    std::vector<int> massRank(model.population.massRank);
+    std::vector<int> arrivalTimeRank(model.population.arrivalTimeRank);
+    model.countAll(true);
+    for (size_t n = 0; n < NODE_COUNT; ++n) {
+        REQUIRE(std::vector<long>(map[n]->residentIds.begin(), map[n]->residentIds.end()) == tracked[n]);
+    }
+    for (size_t id: model.livingIndividuals) {
+        REQUIRE(model.population.massRank[id] == massRank[id]);
+        REQUIRE(model.population.arrivalTimeRank[id] == arrivalTimeRank[id]);
+    }
+
+    // More arrivals than a node has spare room for fall back to a full recount
+    for (size_t id: model.livingIndividuals) {
+        model.individuals[id].location = map[5];
+        model.population.store(model.individuals[id]);
+        model.recordResidencyChange(id);
+    }
+    model.applyResidencyChanges(true);
+    REQUIRE_NOTHROW(model.verifyResidency());
+    REQUIRE(map[5]->residentIds.size() == model.livingIndividuals.size());
+    REQUIRE(std::is_sorted(map[5]->residentIds.begin(), map[5]->residentIds.end()));
+
+    // A location change that bypasses the tracking is caught by the cross-check
+    const size_t id = model.livingIndividuals.front();
+    MapNode *elsewhere = model.population.location[id] == map[0] ? map[1] : map[0];
+    model.population.location[id] = elsewhere;
+    REQUIRE_THROWS_AS(model.verifyResidency(), std::logic_error);
+}
@@ -0,0 +1,207 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "sampling.h"
+#include "util.h"
+
+namespace {
+constexpr size_t DRAWS = 200000;
+
+// Pearson's chi-squared statistic of counts against weights (bins with zero weight must stay empty)
+bool matchesWeights(const std::vector<size_t> &counts, const std::vector<float> &weights, size_t draws) {
+    double total = 0.0;
+    for (float w: weights) total += w;
+    double chiSquared = 0.0;
+    size_t degreesOfFreedom = 0;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        if (weights[i] <= 0.0f) {
+            if (counts[i] != 0) return false;
+            continue;
+        }
+        const double expected = draws * (weights[i] / total);
+        chiSquared += (counts[i] - expected) * (counts[i] - expected) / expected;
+        ++degreesOfFreedom;
+    }
+    if (degreesOfFreedom < 2) {
+        // Every draw had to land in the one bin with weight
+        return true;
+    }
+    // Upper 0.1% point of the chi-squared distribution (Wilson-Hilferty approximation)
+    const double df = (double) degreesOfFreedom - 1.0;
+    const double critical = df * std::pow(1.0 - 2.0 / (9.0 * df) + 3.09 * std::sqrt(2.0 / (9.0 * df)), 3.0);
+    return chiSquared < critical;
+}
+
+// The probabilities sample() gives each index for the weights divided by their total: index i is drawn
+// when the running sum first exceeds the draw (anything left over goes to the last index)
+std::vector<float> normalizedScanProbabilities(const std::vector<float> &weights) {
+    double total = 0.0;
+    for (float w: weights) total += w;
+    std::vector<float> probabilities(weights.size(), 0.0f);
+    double acc = 0.0;
+    double covered = 0.0;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        acc += weights[i] / total;
+        const double upper = std::min(acc, 1.0);
+        if (upper > covered) {
+            probabilities[i] = (float) (upper - covered);
+            covered = upper;
+        }
+    }
+    probabilities.back() += (float) (1.0 - covered);
+    return probabilities;
+}
+
+std::vector<float> testWeights() {
+    // Unnormalized, with zero-weight entries in the middle and at the end
+    return {3.0f, 0.5f, 0.0f, 12.0f, 7.25f, 1.0f, 0.0f, 30.0f, 2.0f, 0.0f};
+}
+}
+
+TEST_CASE("sampleWeighted draws in proportion to unnormalized weights", "[sampling]") {
+    GlobalRand::reseed(11);
+    const std::vector<float> weights = testWeights();
+    std::vector<size_t> counts(weights.size(), 0);
+    for (size_t i = 0; i < DRAWS; ++i) {
+        ++counts[sampleWeighted(weights.data(), weights.size())];
+    }
+    REQUIRE(matchesWeights(counts, weights, DRAWS));
+}
+
+TEST_CASE("sampleWeighted picks what sample() picks from the normalized weights", "[sampling]") {
+    const std::vector<float> weights = testWeights();
+    float total = 0.0f;
+    for (float w: weights) total += w;
+    std::vector<float> normalized;
+    for (float w: weights) normalized.push_back(w / total);
+
+    // Same draws for both; only rounding at bin edges can tell them apart
+    size_t agreements = 0;
+    for (long t = 0; t < 20000; ++t) {
+        size_t fromSample;
+        size_t fromWeights;
+        {
+            RandomStreamScope scope(RandomStreamPhase::Move, 1UL, t);
+            fromSample = sample(normalized.data(), (unsigned) normalized.size());
+        }
+        {
+            RandomStreamScope scope(RandomStreamPhase::Move, 1UL, t);
+            fromWeights = sampleWeighted(weights.data(), weights.size());
+        }
+        agreements += fromSample == fromWeights;
+    }
+    REQUIRE(agreements >= 19990);
+}
+
+TEST_CASE("sampleWeighted keeps sample()'s choices for negative and mixed-sign weights", "[sampling]") {
+    // Fitness is growth / mortality, so it is negative wherever growth is
+    const std::vector<std::vector<float> > lists = {
+        {-1.0f, -3.0f},
+        {-0.5f, -2.0f, -0.25f, -4.0f, -1.0f},
+        {2.0f, -1.0f, 3.0f, 0.5f},
+        {1.0f, -3.0f, -0.5f, 0.25f},
+        {-2.0f, 1.0f, -1.0f, -0.5f, 0.5f}
+    };
+    for (const std::vector<float> &weights: lists) {
+        const std::vector<float> expected = normalizedScanProbabilities(weights);
+        GlobalRand::reseed(23);
+        std::vector<size_t> counts(weights.size(), 0);
+        for (size_t i = 0; i < DRAWS; ++i) {
+            ++counts[sampleWeighted(weights.data(), weights.size())];
+        }
+        REQUIRE(matchesWeights(counts, expected, DRAWS));
+    }
+    // For [-1, -3], sample() on the normalized weights [0.25, 0.75] draws index 0 a quarter of the time
+    REQUIRE(normalizedScanProbabilities({-1.0f, -3.0f})[0] == 0.25f);
+
+    // With the same draws, the choices agree with sample() (including a total of 0)
+    for (const std::vector<float> &weights: {lists[0], lists[1], lists[3], std::vector<float>{1.0f, -1.0f, 0.5f, -0.5f}}) {
+        double total = 0.0;
+        for (float w: weights) total += w;
+        std::vector<float> normalized;
+        for (float w: weights) normalized.push_back((float) (w / total));
+        for (long t = 0; t < 2000; ++t) {
+            size_t fromSample;
+            size_t fromWeights;
+            {
+                RandomStreamScope scope(RandomStreamPhase::Move, 2UL, t);
+                fromSample = sample(normalized.data(), (unsigned) normalized.size());
+            }
+            {
+                RandomStreamScope scope(RandomStreamPhase::Move, 2UL, t);
+                fromWeights = sampleWeighted(weights.size(), [&weights](size_t j) { return weights[j]; }, total);
+            }
+            REQUIRE(fromSample == fromWeights);
+        }
+    }
+}
+
+TEST_CASE("sampleWeighted falls back to the last positive weight", "[sampling]") {
+    GlobalRand::reseed(5);
+    // A total that overstates the weights puts some draws past the end of the running sum
+    const std::vector<float> weights = {1.0f, 2.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 1000; ++i) {
+        const size_t index = sampleWeighted(weights.size(), [&weights](size_t j) { return weights[j]; }, 6.0);
+        REQUIRE(index <= 1);
+    }
+    // With no positive weight, the last index is returned like sample() does
+    const std::vector<float> zeros(3, 0.0f);
+    REQUIRE(sampleWeighted(zeros.data(), zeros.size()) == 2);
+}
+
+TEST_CASE("AliasTable draws in proportion to its weights", "[sampling]") {
+    GlobalRand::reseed(17);
+
+    SECTION("small table") {
+        const std::vector<float> weights = testWeights();
+        AliasTable table(weights.data(), weights.size());
+        REQUIRE(table.size() == weights.size());
+        std::vector<size_t> counts(weights.size(), 0);
+        for (size_t i = 0; i < DRAWS; ++i) {
+            ++counts[table.sample()];
+        }
+        REQUIRE(matchesWeights(counts, weights, DRAWS));
+    }
+
+    SECTION("large table of skewed weights, rebuilt in place") {
+        AliasTable table(testWeights().data(), testWeights().size());
+        std::vector<float> weights;
+        for (int i = 0; i < 500; ++i) {
+            weights.push_back(i % 7 == 0 ? 0.0f : std::exp(-0.01f * i) * (1.0f + (i % 5)));
+        }
+        table.build(weights.data(), weights.size());
+        REQUIRE(table.size() == weights.size());
+        std::vector<size_t> draws(DRAWS * 5);
+        table.sample(draws.size(), draws.data());
+        std::vector<size_t> counts(weights.size(), 0);
+        for (size_t d: draws) ++counts[d];
+        REQUIRE(matchesWeights(counts, weights, draws.size()));
+    }
+
+    SECTION("no positive weight") {
+        const std::vector<float> zeros(4, 0.0f);
+        AliasTable table(zeros.data(), zeros.size());
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(table.sample() == 3);
+        }
+    }
+}
+
+TEST_CASE("sampleWeightedBatch matches the weights for small and large batches", "[sampling]") {
+    GlobalRand::reseed(23);
+    const std::vector<float> weights = testWeights();
+    std::vector<size_t> counts(weights.size(), 0);
+    std::vector<size_t> out(1000);
+    // Alternate batch sizes on either side of the alias table threshold
+    size_t drawn = 0;
+    for (size_t batch = 0; drawn < DRAWS; ++batch) {
+        const size_t count = batch % 2 == 0 ? 1000 : 3;
+        sampleWeightedBatch(weights.data(), weights.size(), count, out.data());
+        for (size_t i = 0; i < count; ++i) ++counts[out[i]];
+        drawn += count;
+    }
+    REQUIRE(matchesWeights(counts, weights, drawn));
+}
@@ -0,0 +1,80 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "spatial_index.h"
+#include "test_utilities.h"
+#include "util.h"
+
+namespace {
+// The linear scan SpatialIndex replaces: first node at the minimum distance
+MapNode *bruteForceNearest(const std::vector<MapNode *> &nodes, float x, float y, bool (*include)(HabitatType)) {
+    MapNode *best = nullptr;
+    float bestDistance = 0.0f;
+    for (MapNode *n : nodes) {
+        if (include != nullptr && !include(n->type)) {
+            continue;
+        }
+        const float dx = n->x - x;
+        const float dy = n->y - y;
+        const float d = std::sqrt(dx * dx + dy * dy);
+        if (best == nullptr || d < bestDistance) {
+            best = n;
+            bestDistance = d;
+        }
+    }
+    return best;
+}
+}
+
+TEST_CASE("SpatialIndex finds the same node as a linear scan", "[spatial_index]") {
+    GlobalRand::reseed(31);
+    std::vector<std::unique_ptr<MapNode>> owned;
+    std::vector<MapNode *> nodes;
+    const HabitatType types[] = {HabitatType::Distributary, HabitatType::BlindChannel,
+                                 HabitatType::Nearshore, HabitatType::Impoundment};
+    // A dense clump, a sparse spread, and a lattice with exact duplicates to exercise ties
+    for (int i = 0; i < 2000; ++i) {
+        const float x = i < 1000 ? 50.0f + 5.0f * GlobalRand::unit_rand() : 1000.0f * GlobalRand::unit_rand();
+        const float y = i < 1000 ? 50.0f + 5.0f * GlobalRand::unit_rand() : 1000.0f * GlobalRand::unit_rand();
+        owned.push_back(createMapNode(x, y, types[i % 4]));
+    }
+    for (int i = 0; i < 400; ++i) {
+        owned.push_back(createMapNode(200.0f + 10.0f * (i % 10), 200.0f + 10.0f * ((i / 10) % 20), types[i % 3]));
+    }
+    for (auto &n : owned) {
+        nodes.push_back(n.get());
+    }
+
+    const SpatialIndex all(nodes);
+    const SpatialIndex waterways(nodes, isDistributaryOrNearshore);
+    REQUIRE(all.size() == nodes.size());
+
+    for (int q = 0; q < 3000; ++q) {
+        float x;
+        float y;
+        if (q % 3 == 0) {
+            // Lattice points and midpoints between them
+            x = 195.0f + 5.0f * (q % 23);
+            y = 195.0f + 5.0f * (q % 43);
+        } else {
+            x = -100.0f + 1200.0f * GlobalRand::unit_rand();
+            y = -100.0f + 1200.0f * GlobalRand::unit_rand();
+        }
+        REQUIRE(all.nearest(x, y) == bruteForceNearest(nodes, x, y, nullptr));
+        float distance;
+        MapNode *found = waterways.nearest(x, y, distance);
+        REQUIRE(found == bruteForceNearest(nodes, x, y, isDistributaryOrNearshore));
+        REQUIRE(isDistributaryOrNearshore(found->type));
+        REQUIRE(distance == std::sqrt((found->x - x) * (found->x - x) + (found->y - y) * (found->y - y)));
+    }
+}
+
+TEST_CASE("SpatialIndex with nothing indexed returns no node", "[spatial_index]") {
+    auto impoundment = createMapNode(1.0f, 1.0f, HabitatType::Impoundment);
+    const SpatialIndex index({impoundment.get()}, isDistributaryOrNearshore);
+    REQUIRE(index.empty());
+    REQUIRE(index.nearest(1.0f, 1.0f) == nullptr);
+}
@@ -0,0 +1,177 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "model.h"
+#include "tag_sampler.h"
+#include "test_utilities.h"
+#include "util.h"
+
+namespace {
+TagSelection selectionWithRate(float rate) {
+    TagSelection selection;
+    selection.rate = rate;
+    return selection;
+}
+
+// Offer recruits first..last (entering in habitat at time), returning the ids tagged
+std::vector<size_t> offerRange(TagSampler &sampler, size_t first, size_t last, HabitatType habitat, long time) {
+    std::vector<size_t> tagged;
+    for (size_t id = first; id <= last; ++id) {
+        size_t evicted;
+        if (sampler.offer(id, habitat, time, evicted)) {
+            tagged.push_back(id);
+        }
+    }
+    return tagged;
+}
+}
+
+TEST_CASE("TagSampler tags a fixed fraction of the recruits", "[tag_sampler]") {
+    TagSampler sampler;
+    SECTION("the default rate tags every 2500th recruit") {
+        ModelConfigMap config;
+        sampler.configure(TagSelection::fromConfig(config));
+        const std::vector<size_t> tagged = offerRange(sampler, 0, 9999, HabitatType::Distributary, 0);
+        REQUIRE(tagged == std::vector<size_t>{0, 2500, 5000, 7500});
+    }
+    SECTION("a rate of 0 tags none and a rate of 1 tags all") {
+        sampler.configure(selectionWithRate(0.0f));
+        REQUIRE(offerRange(sampler, 0, 99, HabitatType::Distributary, 0).empty());
+        sampler.configure(selectionWithRate(1.0f));
+        REQUIRE(offerRange(sampler, 100, 199, HabitatType::Distributary, 0).size() == 100);
+    }
+    SECTION("fractional periods are spread evenly") {
+        sampler.configure(selectionWithRate(0.3f));
+        REQUIRE(offerRange(sampler, 0, 999, HabitatType::Distributary, 0).size() == 300);
+    }
+    SECTION("a resumed sampler tags the same recruits as an uninterrupted one") {
+        sampler.configure(selectionWithRate(0.0004f));
+        offerRange(sampler, 0, 3999, HabitatType::Distributary, 0);
+        REQUIRE(sampler.eligibleCount() == 4000);
+        TagSampler resumed;
+        resumed.configure(selectionWithRate(0.0004f));
+        resumed.resume(sampler.eligibleCount());
+        REQUIRE(resumed.memberCount() == 0);
+        REQUIRE(offerRange(resumed, 4000, 9999, HabitatType::Distributary, 0) == std::vector<size_t>{5000, 7500});
+    }
+}
+
+TEST_CASE("TagSampler only counts recruits from the selected habitats and release windows", "[tag_sampler]") {
+    TagSelection selection = selectionWithRate(0.5f);
+    selection.habitats = TagSelection::parseHabitats("blind channel, Distributary");
+    selection.windows = TagSelection::parseWindows("10-20,30-40");
+    REQUIRE(selection.habitats == std::vector<HabitatType>{HabitatType::BlindChannel, HabitatType::Distributary});
+    REQUIRE(selection.windows.size() == 2);
+    TagSampler sampler;
+    sampler.configure(selection);
+
+    REQUIRE(offerRange(sampler, 0, 9, HabitatType::Nearshore, 15).empty());
+    REQUIRE(offerRange(sampler, 10, 19, HabitatType::Distributary, 25).empty());
+    REQUIRE(offerRange(sampler, 20, 29, HabitatType::Distributary, 20).empty());
+    // Every other eligible recruit, starting with the first
+    REQUIRE(offerRange(sampler, 30, 33, HabitatType::BlindChannel, 10) == std::vector<size_t>{30, 32});
+    REQUIRE(offerRange(sampler, 34, 37, HabitatType::Distributary, 39) == std::vector<size_t>{34, 36});
+
+    REQUIRE_THROWS_AS(TagSelection::parseHabitats("Distributary,Estuary"), std::runtime_error);
+    REQUIRE_THROWS_AS(TagSelection::parseWindows("20-10"), std::runtime_error);
+    REQUIRE_THROWS_AS(TagSelection::parseWindows("0-10-20"), std::runtime_error);
+    REQUIRE_THROWS_AS(TagSelection::parseWindows("early"), std::runtime_error);
+    REQUIRE(TagSelection::parseWindows(" ").empty());
+}
+
+TEST_CASE("TagSampler keeps a reservoir sample within its memory budget", "[tag_sampler]") {
+    constexpr size_t FISH = 400;
+    constexpr size_t HOURS = 100;
+    GlobalRand::reseed(7);
+    auto node = createMapNode(0.0f, 0.0f);
+    std::vector<Fish> individuals;
+    for (size_t id = 0; id < FISH; ++id) {
+        individuals.emplace_back(id, 0L, 50.0f, node.get());
+    }
+    auto record = [&individuals](size_t id) {
+        Fish &f = individuals[id];
+        f.addHistoryBuffers();
+        f.taggedTime = 0;
+        f.history->location.assign(HOURS, 0);
+        f.history->temp.assign(HOURS, 9.0f);
+    };
+
+    TagSelection selection = selectionWithRate(1.0f);
+    const size_t perFish = [&]() {
+        record(0);
+        const size_t bytes = TagSampler::historyBytes(individuals[0]);
+        individuals[0].untag();
+        return bytes;
+    }();
+    // Room for 50 histories
+    selection.memoryBudgetBytes = 50 * perFish + perFish / 2;
+    TagSampler sampler;
+    sampler.configure(selection);
+
+    std::vector<size_t> evicted;
+    for (size_t id = 0; id < 80; ++id) {
+        size_t replaced;
+        REQUIRE(sampler.offer(id, HabitatType::Distributary, 0, replaced));
+        REQUIRE(replaced == TagSampler::NO_FISH);
+        record(id);
+    }
+    sampler.enforceBudget(individuals, evicted);
+    REQUIRE(sampler.reservoirActive());
+    REQUIRE(evicted.size() == 30);
+    REQUIRE(sampler.memberCount() == 50);
+    for (size_t id: evicted) {
+        individuals[id].untag();
+    }
+
+    // From now on, each new candidate replaces a member or is passed over
+    size_t replacements = 0;
+    for (size_t id = 80; id < FISH; ++id) {
+        size_t replaced;
+        if (sampler.offer(id, HabitatType::Distributary, 0, replaced)) {
+            REQUIRE(replaced != TagSampler::NO_FISH);
+            REQUIRE(individuals[replaced].history != nullptr);
+            individuals[replaced].untag();
+            record(id);
+            ++replacements;
+        } else {
+            REQUIRE(replaced == TagSampler::NO_FISH);
+        }
+    }
+    // Expected about 50 * ln(400 / 80) = 80
+    REQUIRE(replacements > 40);
+    REQUIRE(replacements < 130);
+    evicted.clear();
+    sampler.enforceBudget(individuals, evicted);
+    REQUIRE(evicted.empty());
+    REQUIRE(sampler.memberCount() == 50);
+
+    // Histories released elsewhere (e.g. streamed) free their slots
+    size_t tagged = 0;
+    for (Fish &f: individuals) {
+        if (f.history != nullptr && tagged++ < 10) {
+            f.history.reset();
+        }
+    }
+    sampler.enforceBudget(individuals, evicted);
+    REQUIRE(sampler.memberCount() == 40);
+}
+
+TEST_CASE("Model validates the tagging parameters", "[tag_sampler][model]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    Model model(hydroModel.get());
+    model.setRecruitTagRate(0.01f);
+    REQUIRE(model.getFloat(ModelParamKey::RecruitTagRate) == 0.01f);
+    model.setConfigValue(ModelParamKey::TagHabitats, std::string("Nearshore"));
+    SECTION("rate") {
+        REQUIRE_THROWS(model.setRecruitTagRate(1.5f));
+    }
+    SECTION("memory budget") {
+        REQUIRE_THROWS(model.setConfigValue(ModelParamKey::TagMemoryBudgetMB, -1.0f));
+    }
+    SECTION("release windows") {
+        REQUIRE_THROWS(model.setConfigValue(ModelParamKey::TagReleaseWindows, std::string("100")));
+    }
+}
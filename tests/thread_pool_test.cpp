@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+TEST_CASE("ThreadPool runs every task exactly once", "[thread_pool]") {
+    ThreadPool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    std::vector<std::atomic<int>> hits(37);
+    pool.run(hits.size(), [&](size_t i) { hits[i]++; });
+
+    for (auto &h : hits) {
+        REQUIRE(h.load() == 1);
+    }
+}
+
+TEST_CASE("ThreadPool can be reused across many rounds", "[thread_pool]") {
+    ThreadPool pool(3);
+    std::atomic<long> total{0};
+    for (int round = 0; round < 500; ++round) {
+        pool.run(3, [&](size_t i) { total += (long) i + 1; });
+    }
+    REQUIRE(total.load() == 500L * 6L);
+}
+
+TEST_CASE("ThreadPool with a single thread runs tasks on the calling thread", "[thread_pool]") {
+    ThreadPool pool(1);
+    REQUIRE(pool.size() == 1);
+    std::thread::id caller = std::this_thread::get_id();
+    bool allOnCaller = true;
+    pool.run(5, [&](size_t) { allOnCaller = allOnCaller && std::this_thread::get_id() == caller; });
+    REQUIRE(allOnCaller);
+}
+
+TEST_CASE("ThreadPool rethrows task exceptions after the round completes", "[thread_pool]") {
+    ThreadPool pool(2);
+    std::atomic<int> completed{0};
+    REQUIRE_THROWS_AS(pool.run(4, [&](size_t i) {
+        if (i == 1) throw std::runtime_error("boom");
+        completed++;
+    }), std::runtime_error);
+    REQUIRE(completed.load() == 3);
+
+    // The pool is still usable afterwards
+    std::atomic<int> after{0};
+    pool.run(2, [&](size_t) { after++; });
+    REQUIRE(after.load() == 2);
+}
+
+TEST_CASE("ThreadPool::parallelFor covers the range exactly once in bounded chunks", "[thread_pool]") {
+    ThreadPool pool(4);
+    const size_t count = 1003;
+    const size_t chunkSize = 10;
+    std::vector<std::atomic<int>> hits(count);
+    std::atomic<bool> chunkTooBig{false};
+
+    pool.parallelFor(count, chunkSize, [&](size_t begin, size_t end) {
+        if (end - begin > chunkSize) chunkTooBig = true;
+        for (size_t i = begin; i < end; ++i) hits[i]++;
+    });
+
+    REQUIRE_FALSE(chunkTooBig.load());
+    for (auto &h : hits) {
+        REQUIRE(h.load() == 1);
+    }
+
+    size_t totalItems = 0;
+    for (const ThreadPoolWorkerStats &s : pool.getStats()) {
+        totalItems += s.itemsProcessed;
+    }
+    REQUIRE(totalItems == count);
+}
+
+TEST_CASE("ThreadPool::parallelFor lets idle threads steal from a slow one", "[thread_pool]") {
+    ThreadPool pool(2);
+    // Every chunk in the first half is slow; without stealing, participant 0 would do all of them
+    pool.parallelFor(40, 1, [&](size_t begin, size_t) {
+        if (begin < 20) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    });
+
+    const auto &stats = pool.getStats();
+    REQUIRE(stats.size() == 2);
+    REQUIRE(stats[0].itemsProcessed + stats[1].itemsProcessed == 40);
+    REQUIRE(stats[1].chunksStolen > 0);
+
+    pool.resetStats();
+    REQUIRE(pool.getStats()[1].itemsProcessed == 0);
+}
+
+TEST_CASE("ThreadPool::currentParticipant identifies the thread running a task", "[thread_pool]") {
+    ThreadPool pool(3);
+    REQUIRE(ThreadPool::currentParticipant() == 0);
+
+    std::vector<size_t> seen(6, 99);
+    pool.run(seen.size(), [&](size_t i) { seen[i] = ThreadPool::currentParticipant(); });
+    for (size_t i = 0; i < seen.size(); ++i) {
+        REQUIRE(seen[i] == i % pool.size());
+    }
+}
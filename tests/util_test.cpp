@@ -4,6 +4,8 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include <random>
+#include <thread>
+#include <vector>
 #include "util.h"
 
 #include "catch2/matchers/catch_matchers.hpp"
@@ -159,3 +161,71 @@ TEST_CASE("randomness reseeding", "[rand]") {
         REQUIRE(same == true);
     }
 }
+
+TEST_CASE("Philox4x32 matches the Random123 known-answer vectors") {
+    // Philox4x32-10 KAT from Random123 (kat_vectors)
+    auto zero = Philox4x32::generate({0U, 0U, 0U, 0U}, {0U, 0U});
+    REQUIRE(zero == Philox4x32::Block{0x6627e8d5U, 0xe169c58dU, 0xbc57ac4cU, 0x9b00dbd8U});
+
+    auto ones = Philox4x32::generate({0xffffffffU, 0xffffffffU, 0xffffffffU, 0xffffffffU}, {0xffffffffU, 0xffffffffU});
+    REQUIRE(ones == Philox4x32::Block{0x408f276dU, 0x41c83b0eU, 0xa20bc7c6U, 0x6d5451fdU});
+}
+
+TEST_CASE("RandomStreamScope draws are keyed by seed, fish and timestep") {
+    auto draw = [](unsigned long fishId, long timestep) {
+        RandomStreamScope scope(RandomStreamPhase::Move, fishId, timestep);
+        std::vector<float> values;
+        for (int i = 0; i < 9; ++i) {
+            values.push_back(unit_rand());
+        }
+        values.push_back(unit_normal_rand());
+        values.push_back((float) GlobalRand::int_rand(0, 9));
+        return values;
+    };
+
+    GlobalRand::reseed(1234);
+    auto first = draw(7, 42);
+
+    SECTION("the same key reproduces the same draws, regardless of global engine use in between") {
+        GlobalRand::unit_rand();
+        GlobalRand::unit_normal_rand();
+        REQUIRE(draw(7, 42) == first);
+    }
+
+    SECTION("the same key reproduces the same draws on another thread") {
+        std::vector<float> fromThread;
+        std::thread t([&] { fromThread = draw(7, 42); });
+        t.join();
+        REQUIRE(fromThread == first);
+    }
+
+    SECTION("a different fish, timestep or seed gives different draws") {
+        REQUIRE(draw(8, 42) != first);
+        REQUIRE(draw(7, 43) != first);
+        GlobalRand::reseed(4321);
+        REQUIRE(draw(7, 42) != first);
+    }
+
+    SECTION("draws are in range") {
+        for (size_t i = 0; i < 9; ++i) {
+            REQUIRE(first[i] >= 0.0f);
+            REQUIRE(first[i] < 1.0f);
+        }
+        REQUIRE(first[10] >= 0.0f);
+        REQUIRE(first[10] <= 9.0f);
+    }
+
+    SECTION("nested scopes restore the outer stream") {
+        RandomStreamScope outer(RandomStreamPhase::GrowAndDie, 1, 1);
+        float a = unit_rand();
+        {
+            RandomStreamScope inner(RandomStreamPhase::Move, 2, 2);
+            unit_rand();
+        }
+        float b = unit_rand();
+
+        RandomStreamScope replay(RandomStreamPhase::GrowAndDie, 1, 1);
+        REQUIRE(unit_rand() == a);
+        REQUIRE(unit_rand() == b);
+    }
+}